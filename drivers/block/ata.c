@@ -94,6 +94,7 @@ static struct device ide_device[NR_IDE_CTRLS] = {
 		&ata_driver_fsop,
 		NULL,
 		NULL,
+		{ 0 },
 		NULL
 	},
 	{
@@ -105,6 +106,7 @@ static struct device ide_device[NR_IDE_CTRLS] = {
 		&ata_driver_fsop,
 		NULL,
 		NULL,
+		{ 0 },
 		NULL
 	}
 };
@@ -401,7 +403,7 @@ static void show_capabilities(struct ide *ide, struct ata_drv *drive)
 #ifdef CONFIG_PCI
 	if(drive->ident.capabilities & ATA_HAS_DMA && drive->ident.ultradma) {
 		if(ide->pci_dev && ide->pci_dev->bar[4] > 0) {
-			if(drive->flags & DRIVE_IS_DISK) {
+			if(drive->flags & DRIVE_IS_DISK && (drive->xfer.prd_table = (struct prd *)kmalloc(PAGE_SIZE))) {
 				drive->flags |= DRIVE_HAS_DMA;
 				drive->xfer.read_cmd = ATA_READ_DMA;
 				drive->xfer.write_cmd = ATA_WRITE_DMA;
@@ -708,8 +710,9 @@ void ata_set_timeout(struct ide *ide, int timeout, int reason)
 
 void ata_end_request(struct ide *ide)
 {
-	struct blk_request *br, *brh;
+	struct blk_request *br;
 	struct xfer_data *xd;
+	int errno;
 
 	if(!ide->irq_timeout) {
 		del_callout(&ide->creq);
@@ -726,25 +729,15 @@ void ata_end_request(struct ide *ide)
 		}
 
 		xd = (struct xfer_data *)br->device->xfer_data;
-		br->errno = xd->rw_end_fn(ide, xd);
-		if(br->errno < 0 || xd->count == xd->sectors_to_io) {
-			ide->device->requests_queue = (void *)br->next;
-			br->status = BR_COMPLETED;
-			if(br->head_group) {
-				brh = br->head_group;
-				brh->left--;
-				if(!brh->left) {
-					wakeup(brh);
-				}
-			} else {
-				wakeup(br);
-			}
-			if(br->errno < 0) {
+		errno = xd->rw_end_fn(ide, xd);
+		if(errno < 0 || xd->count == xd->sectors_to_io) {
+			end_blk_request(ide->device, errno);
+			if(errno < 0) {
 				return;
 			}
 		}
-		if(br->next) {
-			run_blk_request(br->device);
+		if(ide->device->requests_queue) {
+			run_blk_request(ide->device);
 		}
 	}
 }
@@ -110,6 +110,8 @@ static int setup_transfer(int mode, __dev_t dev, __blk_t block, char *buffer, in
 	struct ide *ide;
 	struct ata_drv *drive;
 	struct partition *part;
+	struct blk_request *br;
+	int nrblocks;
 
 	if(!(ide = get_ide_controller(dev))) {
 		return -EINVAL;
@@ -122,7 +124,22 @@ static int setup_transfer(int mode, __dev_t dev, __blk_t block, char *buffer, in
 	}
 
 	blksize = blksize ? blksize : BLKSIZE_1K;
-	drive->xd.sectors_to_io = MIN(blksize, PAGE_SIZE) / ATA_HD_SECTSIZE;
+
+	/*
+	 * If this transfer serves the request at the head of the queue, the
+	 * contiguous requests queued behind it are served along with it.
+	 */
+	nrblocks = 1;
+	br = (struct blk_request *)ide->device->requests_queue;
+	if(br && br->status == BR_PROCESSING && br->buffer && br->buffer->data == buffer) {
+		if(blksize <= PAGE_SIZE) {
+			nrblocks = merge_blk_request(br, ATA_HD_MAX_SECTORS / (blksize / ATA_HD_SECTSIZE));
+		}
+	} else {
+		br = NULL;
+	}
+	drive->xd.br = br;
+	drive->xd.sectors_to_io = (MIN(blksize, PAGE_SIZE) / ATA_HD_SECTSIZE) * nrblocks;
 
 	part = drive->part_table;
 	drive->xd.offset = block2sector(block, blksize, part, drive->xd.minor);
@@ -160,11 +177,44 @@ static int setup_transfer(int mode, __dev_t dev, __blk_t block, char *buffer, in
 	}
 }
 
+/* sectors to be transferred on the next data request of the drive */
+static void next_pio_block(struct ata_drv *drive, struct xfer_data *xd)
+{
+	xd->nrsectors = xd->sectors_to_io - xd->count;
+	if(drive->flags & DRIVE_HAS_RW_MULTIPLE) {
+		xd->nrsectors = MIN(xd->nrsectors, drive->multi);
+	} else {
+		xd->nrsectors = 1;
+	}
+	xd->datalen = ATA_HD_SECTSIZE * xd->nrsectors;
+}
+
+/*
+ * Moves the current block of sectors between the data port and the buffers.
+ * A merged transfer continues on the buffer of the next merged request each
+ * time the buffer of the current one gets full.
+ */
+static void pio_copy(struct ide *ide, struct ata_drv *drive, struct xfer_data *xd, void (*copy_fn)(unsigned int, void *, unsigned int))
+{
+	int n, sector, spb;
+
+	spb = xd->blksize / ATA_HD_SECTSIZE;
+	for(n = 0; n < xd->nrsectors; n++) {
+		copy_fn(ide->base + ATA_DATA, (void *)xd->buffer, ATA_HD_SECTSIZE / drive->xfer.copy_raw_factor);
+		xd->buffer += ATA_HD_SECTSIZE;
+		sector = xd->count + n + 1;
+		if(xd->br && !(sector % spb) && sector < xd->sectors_to_io) {
+			xd->br = xd->br->next;
+			xd->buffer = xd->br->buffer->data;
+		}
+	}
+}
+
 static int pio_read(struct ide *ide, struct ata_drv *drive, struct xfer_data *xd)
 {
 	ide->device->xfer_data = xd;
 
-	if(ata_io(ide, drive, xd->offset, xd->nrsectors)) {
+	if(ata_io(ide, drive, xd->offset, xd->sectors_to_io)) {
 		return -EIO;
 	}
 	ata_set_timeout(ide, WAIT_FOR_DISK, 0);
@@ -192,16 +242,17 @@ static int pio_read_end(struct ide *ide, struct xfer_data *xd)
 		printk("WARNING: %s(): %s: error on hard disk dev %d,%d during read.\n", __FUNCTION__, drive->dev_name, MAJOR(xd->dev), MINOR(xd->dev));
 		printk("\tstatus=0x%x ", status);
 		ata_error(ide, status);
-		printk("\tblock %d, sector %d.\n", xd->block, xd->offset);
+		printk("\tblock %d, sector %d.\n", xd->block, xd->offset + xd->count);
 		inport_b(ide->base + ATA_STATUS);	/* clear any pending interrupt */
 		return -EIO;
 	}
-	drive->xfer.copy_read_fn(ide->base + ATA_DATA, (void *)xd->buffer, xd->datalen / drive->xfer.copy_raw_factor);
+	pio_copy(ide, drive, xd, drive->xfer.copy_read_fn);
 	xd->count += xd->nrsectors;
 	if(xd->count < xd->sectors_to_io) {
-		xd->offset += xd->nrsectors;
-		xd->buffer += (ATA_HD_SECTSIZE * xd->nrsectors);
-		return pio_read(ide, drive, xd);
+		/* the drive keeps the command and interrupts on each block */
+		next_pio_block(drive, xd);
+		ata_set_timeout(ide, WAIT_FOR_DISK, 0);
+		return 0;
 	}
 	inport_b(ide->base + ATA_STATUS);	/* clear any pending interrupt */
 	return xd->sectors_to_io * ATA_HD_SECTSIZE;
@@ -213,7 +264,7 @@ static int pio_write(struct ide *ide, struct ata_drv *drive, struct xfer_data *x
 
 	ide->device->xfer_data = xd;
 
-	if(ata_io(ide, drive, xd->offset, xd->nrsectors)) {
+	if(ata_io(ide, drive, xd->offset, xd->sectors_to_io)) {
 		return -EIO;
 	}
 	outport_b(ide->base + ATA_COMMAND, drive->xfer.write_cmd);
@@ -227,7 +278,7 @@ static int pio_write(struct ide *ide, struct ata_drv *drive, struct xfer_data *x
 		return -EIO;
 	}
 	ata_set_timeout(ide, WAIT_FOR_DISK, 0);
-	drive->xfer.copy_write_fn(ide->base + ATA_DATA, (void *)xd->buffer, xd->datalen / drive->xfer.copy_raw_factor);
+	pio_copy(ide, drive, xd, drive->xfer.copy_write_fn);
 	return 0;
 }
 
@@ -248,24 +299,59 @@ static int pio_write_end(struct ide *ide, struct xfer_data *xd)
 
 	xd->count += xd->nrsectors;
 	if(xd->count < xd->sectors_to_io) {
-		xd->offset += xd->nrsectors;
-		xd->buffer += (ATA_HD_SECTSIZE * xd->nrsectors);
-		return pio_write(ide, drive, xd);
+		/* the drive keeps the command and asks for the next block */
+		next_pio_block(drive, xd);
+		status = ata_wait_state(ide, ATA_STAT_DRQ);
+		if(status) {
+			printk("WARNING: %s(): %s: error on hard disk dev %d,%d during write.\n", __FUNCTION__, drive->dev_name, MAJOR(xd->dev), MINOR(xd->dev));
+			printk("\tstatus=0x%x ", status);
+			ata_error(ide, status);
+			printk("\tblock %d, sector %d.\n", xd->block, xd->offset + xd->count);
+			inport_b(ide->base + ATA_STATUS);	/* clear any pending interrupt */
+			return -EIO;
+		}
+		ata_set_timeout(ide, WAIT_FOR_DISK, 0);
+		pio_copy(ide, drive, xd, drive->xfer.copy_write_fn);
+		return 0;
 	}
 	inport_b(ide->base + ATA_STATUS);	/* clear any pending interrupt */
 	return xd->sectors_to_io * ATA_HD_SECTSIZE;
 }
 
 #ifdef CONFIG_PCI
+/*
+ * Builds the PRD table with the buffers of all the requests merged in the
+ * transfer, so the whole of it is done by a single DMA command.
+ */
+static int setup_prd_table(struct ata_drv *drive, struct xfer_data *xd)
+{
+	struct blk_request *br;
+	int n, entries;
+
+	if(!xd->br) {
+		return ata_add_prd(drive, 0, xd->buffer, xd->sectors_to_io * ATA_HD_SECTSIZE);
+	}
+	br = xd->br;
+	for(entries = 0, n = 0; n <= xd->br->merged && entries >= 0; n++) {
+		entries = ata_add_prd(drive, entries, br->buffer->data, MIN(xd->blksize, PAGE_SIZE));
+		br = br->next;
+	}
+	return entries;
+}
+
 static int dma_transfer(struct ide *ide, struct ata_drv *drive, struct xfer_data *xd)
 {
 	ide->device->xfer_data = xd;
 
-	if(ata_io(ide, drive, xd->offset, xd->nrsectors)) {
+	if(setup_prd_table(drive, xd) < 0) {
+		printk("WARNING: %s(): %s: PRD table overflow.\n", __FUNCTION__, drive->dev_name);
+		return -EIO;
+	}
+	if(ata_io(ide, drive, xd->offset, xd->sectors_to_io)) {
 		return -EIO;
 	}
 
-	ata_setup_dma(ide, drive, xd->buffer, xd->datalen, xd->bm_cmd);
+	ata_setup_dma(ide, drive, xd->bm_cmd);
 	ata_set_timeout(ide, WAIT_FOR_DISK, 0);
 	outport_b(ide->base + ATA_COMMAND, xd->cmd);
 	ata_start_dma(ide, drive);
@@ -298,12 +384,7 @@ static int dma_transfer_end(struct ide *ide, struct xfer_data *xd)
 		inport_b(ide->base + ATA_STATUS);	/* clear any pending interrupt */
 		return -EIO;
 	}
-	xd->count += xd->nrsectors;
-	if(xd->count < xd->sectors_to_io) {
-		xd->offset += xd->nrsectors;
-		xd->buffer += (ATA_HD_SECTSIZE * xd->nrsectors);
-		dma_transfer(ide, drive, xd);
-	}
+	xd->count = xd->sectors_to_io;
 	inport_b(ide->base + ATA_STATUS);	/* clear any pending interrupt */
 	return xd->sectors_to_io * ATA_HD_SECTSIZE;
 }
@@ -73,15 +73,42 @@ static int setup_ata_device(struct ide *ide, struct pci_device *pci_dev)
 	return found;
 }
 
-void ata_setup_dma(struct ide *ide, struct ata_drv *drive, char *buffer, int datalen, int mode)
+/*
+ * Appends the buffer to the PRD table of the drive, starting at the entry
+ * 'entry', and splitting it wherever it crosses a 64KB boundary. The last
+ * entry appended is marked as the end of the table. Returns the number of
+ * entries in use, or -1 if the table is full.
+ */
+int ata_add_prd(struct ata_drv *drive, int entry, char *buffer, int datalen)
+{
+	struct prd *prd;
+	unsigned int addr;
+	int size;
+
+	addr = V2P((unsigned int)buffer);
+	while(datalen > 0) {
+		if(entry >= PRDT_MAX_ENTRIES) {
+			return -1;
+		}
+		size = MIN(datalen, PRDT_BOUNDARY - (addr & (PRDT_BOUNDARY - 1)));
+		if(entry) {
+			drive->xfer.prd_table[entry - 1].eot = 0;
+		}
+		prd = &drive->xfer.prd_table[entry++];
+		prd->addr = addr;
+		prd->size = size;	/* 64KB is encoded as 0 */
+		prd->eot = PRDT_MARK_END;
+		addr += size;
+		datalen -= size;
+	}
+	return entry;
+}
+
+void ata_setup_dma(struct ide *ide, struct ata_drv *drive, int mode)
 {
 	int value;
-	struct prd *prd_table = &drive->xfer.prd_table;
 
-	prd_table->addr = (unsigned int)V2P(buffer);
-	prd_table->size = datalen;
-	prd_table->eot = PRDT_MARK_END;
-	outport_l(ide->bm + BM_PRD_ADDRESS, V2P((unsigned int)prd_table));
+	outport_l(ide->bm + BM_PRD_ADDRESS, V2P((unsigned int)drive->xfer.prd_table));
 	value = inport_b(ide->bm + BM_COMMAND);
 	outport_b(ide->bm + BM_COMMAND, value | mode);
 
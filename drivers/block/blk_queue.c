@@ -6,6 +6,7 @@
  */
 
 #include <fiwix/asm.h>
+#include <fiwix/kernel.h>
 #include <fiwix/irq.h>
 #include <fiwix/blk_queue.h>
 #include <fiwix/buffer.h>
@@ -17,7 +18,36 @@
 #include <fiwix/stdio.h>
 #include <fiwix/string.h>
 
-/* append the request into the queue */
+struct kmem_cache *blk_request_cache;
+static struct blk_request *async_done;	/* completed asynchronous requests */
+
+static int compare_blk_request(struct blk_request *br1, struct blk_request *br2)
+{
+	if(br1->dev != br2->dev) {
+		return br1->dev < br2->dev ? -1 : 1;
+	}
+	if(br1->block != br2->block) {
+		return br1->block < br2->block ? -1 : 1;
+	}
+	return 0;
+}
+
+/*
+ * The queue is kept sorted in C-LOOK order: requests are served in ascending
+ * block order from the current position and, once the highest one has been
+ * reached, the elevator wraps around and starts again from the lowest one.
+ */
+static int fits_between(struct blk_request *prev, struct blk_request *br, struct blk_request *next)
+{
+	if(compare_blk_request(prev, next) <= 0) {
+		return compare_blk_request(prev, br) <= 0 && compare_blk_request(br, next) < 0;
+	}
+
+	/* the elevator wraps around between 'prev' and 'next' */
+	return compare_blk_request(prev, br) <= 0 || compare_blk_request(br, next) < 0;
+}
+
+/* insert the request into the queue */
 void add_blk_request(struct blk_request *br)
 {
 	unsigned int flags;
@@ -26,23 +56,59 @@ void add_blk_request(struct blk_request *br)
 
 	d = br->device;
 	SAVE_FLAGS(flags); CLI();
-	if((h = (struct blk_request *)d->requests_queue)) {
-		while(h->next) {
-			h = h->next;
-		}
-		h->next = br;
-	} else {
+	d->stats.requests++;
+	if(!(h = (struct blk_request *)d->requests_queue)) {
+		br->next = NULL;
 		d->requests_queue = (void *)br;
+		RESTORE_FLAGS(flags);
+		return;
 	}
+
+	/* the requests already in process can't be overtaken */
+	while(h->next && h->next->status == BR_PROCESSING) {
+		h = h->next;
+	}
+	while(h->next) {
+		if(fits_between(h, br, h->next)) {
+			break;
+		}
+		h = h->next;
+	}
+	br->next = h->next;
+	h->next = br;
 	RESTORE_FLAGS(flags);
 }
 
+/*
+ * The asynchronous requests are completed from the interrupt handler, so
+ * they are freed later from the context of the next process that queues
+ * a new request.
+ */
+static void free_async_requests(void)
+{
+	unsigned int flags;
+	struct blk_request *br, *next;
+
+	SAVE_FLAGS(flags); CLI();
+	br = async_done;
+	async_done = NULL;
+	RESTORE_FLAGS(flags);
+
+	while(br) {
+		next = br->next;
+		kmem_cache_free(blk_request_cache, (unsigned int)br);
+		br = next;
+	}
+}
+
 int do_blk_request(struct device *d, void *fn, struct buffer *buf)
 {
+	unsigned int flags;
 	struct blk_request *br;
 	int errno;
 
-	if(!(br = (struct blk_request *)kmalloc(sizeof(struct blk_request)))) {
+	free_async_requests();
+	if(!(br = (struct blk_request *)kmem_cache_alloc(blk_request_cache))) {
 		printk("WARNING: %s(): no more free memory for block requests.\n", __FUNCTION__);
 		return -ENOMEM;
 	}
@@ -56,53 +122,158 @@ int do_blk_request(struct device *d, void *fn, struct buffer *buf)
 	br->fn = fn;
 
 	add_blk_request(br);
+
+	/* an interrupt must not complete it between the check and the sleep */
+	SAVE_FLAGS(flags); CLI();
 	run_blk_request(d);
 	if(br->status != BR_COMPLETED) {
 		sleep(br, PROC_UNINTERRUPTIBLE);
 	}
+	RESTORE_FLAGS(flags);
 	errno = br->errno;
 	if(!br->head_group) {
-		kfree((unsigned int)br);
+		kmem_cache_free(blk_request_cache, (unsigned int)br);
 	}
 	return errno;
 }
 
+/*
+ * Queues a request to read the (locked) buffer without waiting for it. Once
+ * completed, the buffer is marked as valid (if no error) and released. The
+ * caller must run the queue once all its requests have been added.
+ */
+int add_async_blk_request(struct device *d, void *fn, struct buffer *buf)
+{
+	struct blk_request *br;
+
+	free_async_requests();
+	if(!(br = (struct blk_request *)kmem_cache_alloc(blk_request_cache))) {
+		return -ENOMEM;
+	}
+
+	memset_b(br, 0, sizeof(struct blk_request));
+	br->dev = buf->dev;
+	br->block = buf->block;
+	br->size = buf->size;
+	br->flags = BRF_ASYNC;
+	br->buffer = buf;
+	br->device = d;
+	br->fn = fn;
+
+	add_blk_request(br);
+	return 0;
+}
+
 void run_blk_request(struct device *d)
 {
 	unsigned int flags;
-	struct blk_request *br, *brh;
+	struct blk_request *br;
 	int errno;
 
 	SAVE_FLAGS(flags); CLI();
-	br = (struct blk_request *)d->requests_queue;
-	while(br) {
+	while((br = (struct blk_request *)d->requests_queue)) {
 		if(br->status) {
 			if(br->status == BR_COMPLETED) {
 				printk("%s(): status marked as BR_COMPLETED, picking the next one ...\n", __FUNCTION__);
 				d->requests_queue = (void *)br->next;
-				br = br->next;
 				continue;
 			}
-			return;
+			break;
 		}
 		br->status = BR_PROCESSING;
-		if(!(errno = br->fn(br->dev, br->block, br->buffer->data, br->size))) {
-			return;
+		if(br->dev != d->stats.last_dev || br->block != d->stats.next_block) {
+			d->stats.seeks++;
+		}
+		d->stats.dispatches++;
+		errno = br->fn(br->dev, br->block, br->buffer->data, br->size);
+		d->stats.last_dev = br->dev;
+		d->stats.next_block = br->block + br->merged + 1;
+		if(!errno) {
+			/* the driver will complete it asynchronously */
+			break;
 		}
+		end_blk_request(d, errno);
+	}
+	RESTORE_FLAGS(flags);
+}
+
+/*
+ * Merges into 'br' the requests queued right behind it that continue it on
+ * the same device, up to a total of 'max' requests. The driver then serves
+ * all of them as a single transfer. Returns the number of requests in it.
+ */
+int merge_blk_request(struct blk_request *br, int max)
+{
+	unsigned int flags;
+	struct blk_request *last, *next;
+
+	SAVE_FLAGS(flags); CLI();
+	last = br;
+	while(br->merged + 1 < max && (next = last->next)) {
+		if(next->status || next->dev != br->dev || next->fn != br->fn) {
+			break;
+		}
+		if(next->size != br->size || next->block != last->block + 1) {
+			break;
+		}
+		next->status = BR_PROCESSING;
+		br->merged++;
+		last = next;
+	}
+	br->device->stats.merges += br->merged;
+	RESTORE_FLAGS(flags);
+	return br->merged + 1;
+}
+
+/* complete the request at the head of the queue and all its merged ones */
+void end_blk_request(struct device *d, int errno)
+{
+	unsigned int flags;
+	struct blk_request *br, *brh, *next;
+	int merged;
+
+	SAVE_FLAGS(flags); CLI();
+	br = (struct blk_request *)d->requests_queue;
+	merged = br->merged;
+	if(merged && errno > 0) {
+		/* each request reports its own size */
+		errno = br->size;
+	}
+	for(;;) {
+		next = br->next;
+		d->requests_queue = (void *)next;
 		br->errno = errno;
-		d->requests_queue = (void *)br->next;
 		br->status = BR_COMPLETED;
-		if(br->head_group) {
+		if(br->flags & BRF_ASYNC) {
+			if(errno > 0) {
+				br->buffer->flags |= BUFFER_VALID;
+			}
+			brelse(br->buffer);
+			br->next = async_done;
+			async_done = br;
+		} else if(br->head_group) {
 			brh = br->head_group;
 			brh->left--;
-			brh->errno = errno;
+			if(errno < 0) {
+				brh->errno = errno;
+			}
 			if(!brh->left) {
 				wakeup(brh);
 			}
 		} else {
 			wakeup(br);
 		}
-		br = br->next;
+		if(!merged-- || !next) {
+			break;
+		}
+		br = next;
 	}
 	RESTORE_FLAGS(flags);
 }
+
+void blk_queue_init(void)
+{
+	if(!(blk_request_cache = kmem_cache_create("blk_request", sizeof(struct blk_request), NULL))) {
+		PANIC("Unable to create the blk_request cache.\n");
+	}
+}
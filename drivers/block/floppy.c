@@ -36,7 +36,7 @@ static int need_reset = 0;
 static int fdc_wait_interrupt = 0;
 static int fdc_timeout = 0;
 static unsigned char fdc_results[MAX_FDC_RESULTS];
-static struct resource floppy_resource = { 0, 0 };
+static struct resource floppy_resource = { 0 };
 
 static struct fddt fdd_type[] = {
 /*
@@ -126,6 +126,7 @@ static struct device floppy_device = {
 	&fdc_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
@@ -72,6 +72,7 @@ static struct device ramdisk_device = {
 	&ramdisk_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
@@ -104,6 +104,7 @@ static struct device tty_device = {
 	&tty_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
@@ -116,6 +117,7 @@ static struct device console_device = {
 	&tty_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
@@ -76,6 +76,7 @@ static struct device fb_device = {
 	&fb_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
@@ -67,6 +67,7 @@ static struct device lp_device = {
 	&lp_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
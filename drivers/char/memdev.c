@@ -370,6 +370,7 @@ static struct device memdev_device = {
 	&memdev_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
@@ -673,7 +674,7 @@ int mem_mmap(struct inode *i, struct vma *vma)
 			return -EAGAIN;
 		}
 	}
-	invalidate_tlb();
+	invalidate_tlb_range(vma->start, vma->start + length);
 	return 0;
 }
 
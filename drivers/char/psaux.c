@@ -9,6 +9,7 @@
 #include <fiwix/kernel.h>
 #include <fiwix/devices.h>
 #include <fiwix/fs.h>
+#include <fiwix/poll.h>
 #include <fiwix/errno.h>
 #include <fiwix/ps2.h>
 #include <fiwix/psaux.h>
@@ -73,6 +74,7 @@ static struct device psaux_device = {
 	&psaux_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
@@ -137,7 +139,7 @@ void irq_psaux(int num, struct sigcontext *sc)
 	}
 	charq_putchar(&psaux_table.read_q, ch);
 	wakeup(&psaux_read);
-	wakeup(&do_select);
+	select_notify(&psaux_table);
 }
 
 int psaux_open(struct inode *i, struct fd *f)
@@ -231,6 +233,7 @@ int psaux_select(struct inode *i, struct fd *f, int flag)
 		return -ENXIO;
 	}
 
+	select_wait(&psaux_table);
 	switch(flag) {
 		case SEL_R:
 			if(psaux_table.read_q.count) {
@@ -10,6 +10,7 @@
 #include <fiwix/tty.h>
 #include <fiwix/pty.h>
 #include <fiwix/filesystems.h>
+#include <fiwix/poll.h>
 #include <fiwix/fs_devpts.h>
 #include <fiwix/stat.h>
 #include <fiwix/ioctl.h>
@@ -116,6 +117,7 @@ static struct device pty_master_device = {
 	&pty_master_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
@@ -128,13 +130,23 @@ static struct device pty_slave_device = {
 	&pty_slave_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
+/* the state of both ends of a pty depends on the same queues */
+static void pty_notify(struct tty *tty)
+{
+	select_notify(tty);
+	if(tty->link) {
+		select_notify(tty->link);
+	}
+}
+
 void pty_wakeup_read(struct tty *tty)
 {
 	wakeup(&pty_read);
-	wakeup(&do_select);
+	pty_notify(tty);
 }
 
 int pty_open(struct tty *tty)
@@ -192,7 +204,7 @@ int pty_close(struct tty *tty)
 	tty->flags |= TTY_OTHER_CLOSED;
 	wakeup(&tty->read_q);
 	wakeup(&pty_read);
-	wakeup(&do_select);
+	pty_notify(tty);
 	if(MAJOR(tty->dev) == PTY_SLAVE_MAJOR) {
 		minor = MINOR(tty->dev);
 		CLEAR_MINOR(pty_slave_device.minors, minor);
@@ -239,7 +251,7 @@ int pty_read(struct inode *i, struct fd *f, char *buffer, __size_t count)
 		}
 	}
 	wakeup(&tty->write_q);
-	wakeup(&do_select);
+	pty_notify(tty);
 	return n;
 }
 
@@ -261,7 +273,7 @@ int pty_write(struct inode *i, struct fd *f, const char *buffer, __size_t count)
 		}
 	}
 	tty->input(tty);
-	wakeup(&do_select);
+	pty_notify(tty);
 	return n;
 }
 
@@ -295,6 +307,7 @@ int pty_select(struct inode *i, struct fd *f, int flag)
 	struct tty *tty;
 
 	tty = f->private_data;
+	select_wait(tty);
 
 	switch(flag) {
 		case SEL_R:
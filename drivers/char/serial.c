@@ -76,6 +76,7 @@ static struct device serial_device = {
 	&serial_driver_fsop,
 	NULL,
 	NULL,
+	{ 0 },
 	NULL
 };
 
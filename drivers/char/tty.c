@@ -14,6 +14,7 @@
 #include <fiwix/console.h>
 #include <fiwix/devices.h>
 #include <fiwix/fs.h>
+#include <fiwix/poll.h>
 #include <fiwix/errno.h>
 #include <fiwix/sched.h>
 #include <fiwix/timer.h>
@@ -308,11 +309,8 @@ void disassociate_ctty(struct tty *tty)
 	tty->pgid = tty->sid = 0;
 
 	/* clear the controlling tty for all processes in the same SID */
-	FOR_EACH_PROCESS(p) {
-		if(p->sid == current->sid) {
-			p->ctty = NULL;
-		}
-		p = p->next;
+	for(p = first_in_session(current->sid); p; p = next_in_session(p)) {
+		p->ctty = NULL;
 	}
 	kill_pgrp(current->pgid, SIGHUP, KERNEL);
 	kill_pgrp(current->pgid, SIGCONT, KERNEL);
@@ -517,7 +515,7 @@ void do_cook(struct tty *tty)
 		tty->output(tty);
 	}
 	if(!(tty->termios.c_lflag & ICANON) || ((tty->termios.c_lflag & ICANON) && tty->canon_data)) {
-		wakeup(&do_select);
+		select_notify(tty);
 	}
 	wakeup(&tty->read_q);
 }
@@ -634,7 +632,7 @@ int tty_read(struct inode *i, struct fd *f, char *buffer, __size_t count)
 
 	/* only the foreground process group is allowed to read from the tty */
 	if(current->ctty == tty && current->pgid != tty->pgid) {
-		if(current->sigaction[SIGTTIN - 1].sa_handler == SIG_IGN || current->sigblocked & (1 << (SIGTTIN - 1)) || is_orphaned_pgrp(current->pgid)) {
+		if(current->sighand->action[SIGTTIN - 1].sa_handler == SIG_IGN || current->sigblocked & (1 << (SIGTTIN - 1)) || is_orphaned_pgrp(current->pgid)) {
 			return -EIO;
 		}
 		kill_pgrp(current->pgid, SIGTTIN, KERNEL);
@@ -782,7 +780,7 @@ int tty_write(struct inode *i, struct fd *f, const char *buffer, __size_t count)
 	/* only the foreground process group is allowed to write to the tty */
 	if(current->ctty == tty && current->pgid != tty->pgid) {
 		if(tty->termios.c_lflag & TOSTOP) {
-			if(current->sigaction[SIGTTIN - 1].sa_handler != SIG_IGN && !(current->sigblocked & (1 << (SIGTTIN - 1)))) {
+			if(current->sighand->action[SIGTTIN - 1].sa_handler != SIG_IGN && !(current->sigblocked & (1 << (SIGTTIN - 1)))) {
 				if(is_orphaned_pgrp(current->pgid)) {
 					return -EIO;
 				}
@@ -1143,6 +1141,7 @@ int tty_select(struct inode *i, struct fd *f, int flag)
 	struct tty *tty;
 
 	tty = f->private_data;
+	select_wait(tty);
 
 	switch(flag) {
 		case SEL_R:
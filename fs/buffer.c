@@ -27,19 +27,21 @@
 #define GROW_IF_NEEDED	1
 
 struct buffer *buffer_table;		/* buffer pool */
+static struct kmem_cache *buffer_cache;
 struct buffer **buffer_hash_table;
 
 /* [0] = 1KB, [1] = 2KB, [2] = unused, [3] = 4KB */
 struct buffer *buffer_head[4];		/* heads of free list */
 struct buffer *buffer_dirty_head[4];	/* heads of dirty list */
 
-static struct resource sync_resource = { 0, 0 };
+static struct resource sync_resource = { 0 };
+static struct wait_queue free_buffer_wait;	/* waiting for a free buffer */
 
 static struct buffer *add_buffer_to_pool(void)
 {
 	struct buffer *buf;
 
-	if(!(buf = (struct buffer *)kmalloc(sizeof(struct buffer)))) {
+	if(!(buf = (struct buffer *)kmem_cache_alloc(buffer_cache))) {
 		return NULL;
 	}
 	memset_b(buf, 0, sizeof(struct buffer));
@@ -81,7 +83,7 @@ static void del_buffer_from_pool(struct buffer *buf)
 		buffer_table = buf->next;
 	}
 
-	kfree((unsigned int)tmp);
+	kmem_cache_free(buffer_cache, (unsigned int)tmp);
 	kstat.nr_buffers--;
 }
 
@@ -104,11 +106,16 @@ static void insert_to_hash(struct buffer *buf)
 	}
 }
 
+/*
+ * The processes waiting for a buffer that changes its identity must look it
+ * up again, so all of them are woken up.
+ */
 static void remove_from_hash(struct buffer *buf)
 {
 	struct buffer **h;
 	int i;
 
+	wake_up_all(&buf->wait);
 	i = BUFFER_HASH(buf->dev, buf->block);
 	h = &buffer_hash_table[i];
 
@@ -241,6 +248,11 @@ static void remove_from_free_list(struct buffer *buf)
 	struct buffer *h;
 	int index;
 
+	/* the buffers mapped onto a page are never in the free list */
+	if(buf->page) {
+		return;
+	}
+
 	index = BUFHEAD_INDEX(buf->size);
 	h = buffer_head[index];
 
@@ -272,7 +284,7 @@ static void buffer_wait(struct buffer *buf)
 	for(;;) {
 		SAVE_FLAGS(flags); CLI();
 		if(buf->flags & BUFFER_LOCKED) {
-			sleep(&buffer_wait, PROC_UNINTERRUPTIBLE);
+			sleep_on_exclusive(&buf->wait, PROC_UNINTERRUPTIBLE);
 		} else {
 			break;
 		}
@@ -355,7 +367,7 @@ static struct buffer *get_free_buffer(int mode, int size)
 			return NULL;
 		}
 		if(buf->flags & BUFFER_LOCKED) {
-			sleep(&buffer_wait, PROC_UNINTERRUPTIBLE);
+			sleep_on(&buf->wait, PROC_UNINTERRUPTIBLE);
 		} else {
 			break;
 		}
@@ -369,36 +381,6 @@ static struct buffer *get_free_buffer(int mode, int size)
 	return buf;
 }
 
-static struct buffer *get_dirty_buffer(int size)
-{
-	unsigned int flags;
-	struct buffer *buf;
-	int index;
-
-	index = BUFHEAD_INDEX(size);
-
-	for(;;) {
-		SAVE_FLAGS(flags); CLI();
-		if(!(buf = buffer_dirty_head[index])) {
-			/* no buffers in this dirty list */
-			RESTORE_FLAGS(flags);
-			return NULL;
-		}
-		if(buf->flags & BUFFER_LOCKED) {
-			sleep(&buffer_wait, PROC_UNINTERRUPTIBLE);
-		} else {
-			break;
-		}
-		RESTORE_FLAGS(flags);
-	}
-
-	remove_from_dirty_list(buf);
-	buf->flags |= BUFFER_LOCKED;
-
-	RESTORE_FLAGS(flags);
-	return buf;
-}
-
 static int sync_one_buffer(struct buffer *buf)
 {
 	struct device *d;
@@ -439,7 +421,7 @@ static struct buffer *search_buffer_hash(__dev_t dev, __blk_t block, int size)
 	return NULL;
 }
 
-static struct buffer *getblk(__dev_t dev, __blk_t block, int size)
+struct buffer *getblk(__dev_t dev, __blk_t block, int size)
 {
 	unsigned int flags;
 	struct buffer *buf;
@@ -448,7 +430,7 @@ static struct buffer *getblk(__dev_t dev, __blk_t block, int size)
 		if((buf = search_buffer_hash(dev, block, size))) {
 			SAVE_FLAGS(flags); CLI();
 			if(buf->flags & BUFFER_LOCKED) {
-				sleep(&buffer_wait, PROC_UNINTERRUPTIBLE);
+				sleep_on_exclusive(&buf->wait, PROC_UNINTERRUPTIBLE);
 				RESTORE_FLAGS(flags);
 				continue;
 			}
@@ -460,7 +442,7 @@ static struct buffer *getblk(__dev_t dev, __blk_t block, int size)
 
 		if(!(buf = get_free_buffer(GROW_IF_NEEDED, size))) {
 			wakeup(&kswapd);
-			sleep(&get_free_buffer, PROC_UNINTERRUPTIBLE);
+			sleep_on(&free_buffer_wait, PROC_UNINTERRUPTIBLE);
 			continue;
 		}
 
@@ -486,13 +468,18 @@ static struct buffer *getblk(__dev_t dev, __blk_t block, int size)
 /* read a group of blocks */
 int gbread(struct device *d, struct blk_request *brh)
 {
+	unsigned int flags;
 	struct blk_request *br;
 	struct buffer *buf;
 
 	br = brh->next_group;
 	while(br) {
 		if(!(br->flags & BRF_NOBLOCK)) {
-			if((buf = getblk(br->dev, br->block, br->size))) {
+			/* the buffer might be already given (mapped onto a page) */
+			if(!(buf = br->buffer)) {
+				buf = getblk(br->dev, br->block, br->size);
+			}
+			if(buf) {
 				br->buffer = buf;
 				if(buf->flags & BUFFER_VALID) {
 					br = br->next_group;
@@ -516,10 +503,12 @@ int gbread(struct device *d, struct blk_request *brh)
 		br = br->next_group;
 	}
 
+	SAVE_FLAGS(flags); CLI();
 	run_blk_request(d);
 	if(brh->left) {
 		sleep(brh, PROC_UNINTERRUPTIBLE);
 	}
+	RESTORE_FLAGS(flags);
 	return brh->errno;
 }
 
@@ -546,6 +535,155 @@ struct buffer *bread(__dev_t dev, __blk_t block, int size)
 	return NULL;
 }
 
+/*
+ * Returns (locked) the buffer of a block whose data lives in the page-cache
+ * page 'pg' at 'data', so that the block is read or written straight into
+ * the page. If the block is already in the buffer cache, its contents (and
+ * its dirty state) are moved into the page and the old buffer is dropped,
+ * so every cached block is kept only once in memory.
+ */
+struct buffer *getblk_page(struct page *pg, char *data, __dev_t dev, __blk_t block, int size)
+{
+	unsigned int flags;
+	struct buffer *buf, *old, **b;
+
+	if(!(buf = add_buffer_to_pool())) {
+		return NULL;
+	}
+
+	for(;;) {
+		if(!(old = search_buffer_hash(dev, block, size))) {
+			break;
+		}
+		SAVE_FLAGS(flags); CLI();
+		if(old->flags & BUFFER_LOCKED) {
+			sleep_on_exclusive(&old->wait, PROC_UNINTERRUPTIBLE);
+			RESTORE_FLAGS(flags);
+			continue;
+		}
+		old->flags |= BUFFER_LOCKED;
+		remove_from_free_list(old);
+		RESTORE_FLAGS(flags);
+		if(old->page == pg) {
+			del_buffer_from_pool(buf);
+			return old;
+		}
+		break;
+	}
+
+	buf->dev = dev;
+	buf->block = block;
+	buf->size = size;
+	buf->data = data;
+	buf->page = pg;
+	buf->flags = BUFFER_LOCKED;
+
+	SAVE_FLAGS(flags); CLI();
+	if(old) {
+		if(old->flags & BUFFER_VALID) {
+			memcpy_b(data, old->data, size);
+			buf->flags |= old->flags & (BUFFER_VALID | BUFFER_DIRTY);
+		}
+		if(old->flags & BUFFER_DIRTY) {
+			remove_from_dirty_list(old);
+		}
+		remove_from_hash(old);
+		old->flags &= ~(BUFFER_VALID | BUFFER_DIRTY);
+		if(old->page) {
+			/* unlink it from the page that held it */
+			for(b = &old->page->buffers; *b; b = &(*b)->next_in_page) {
+				if(*b == old) {
+					*b = old->next_in_page;
+					break;
+				}
+			}
+			del_buffer_from_pool(old);
+			old = NULL;
+		}
+	}
+	insert_to_hash(buf);
+	buf->next_in_page = pg->buffers;
+	pg->buffers = buf;
+	RESTORE_FLAGS(flags);
+
+	if(old) {
+		brelse(old);
+	}
+	return buf;
+}
+
+/* checks if any of the buffers of a page is locked or pending to be written */
+int page_buffers_busy(struct page *pg)
+{
+	struct buffer *buf;
+
+	for(buf = pg->buffers; buf; buf = buf->next_in_page) {
+		if(buf->flags & (BUFFER_LOCKED | BUFFER_DIRTY)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+/* checks if all the buffers of a page hold valid data and none is locked */
+int page_buffers_uptodate(struct page *pg)
+{
+	struct buffer *buf;
+
+	for(buf = pg->buffers; buf; buf = buf->next_in_page) {
+		if(buf->flags & BUFFER_LOCKED || !(buf->flags & BUFFER_VALID)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* drops the buffers of a page that is about to be reused */
+void detach_page_buffers(struct page *pg)
+{
+	unsigned int flags;
+	struct buffer *buf, *next;
+
+	SAVE_FLAGS(flags); CLI();
+	for(buf = pg->buffers; buf; buf = next) {
+		next = buf->next_in_page;
+		remove_from_hash(buf);
+		del_buffer_from_pool(buf);
+	}
+	pg->buffers = NULL;
+	RESTORE_FLAGS(flags);
+}
+
+/*
+ * Waits for the I/O in progress on the buffers of a page and returns 1 if
+ * any of them couldn't be read.
+ */
+int wait_page_buffers(struct page *pg)
+{
+	unsigned int flags;
+	struct buffer *buf;
+	int errno;
+
+	SAVE_FLAGS(flags); CLI();
+	errno = 0;
+	buf = pg->buffers;
+	while(buf) {
+		if(buf->flags & BUFFER_LOCKED) {
+			sleep_on(&buf->wait, PROC_UNINTERRUPTIBLE);
+			/* the list might have changed meanwhile */
+			errno = 0;
+			buf = pg->buffers;
+			continue;
+		}
+		if(!(buf->flags & BUFFER_VALID)) {
+			errno = 1;
+		}
+		buf = buf->next_in_page;
+	}
+	RESTORE_FLAGS(flags);
+	return errno;
+}
+
 void bwrite(struct buffer *buf)
 {
 	buf->flags |= (BUFFER_DIRTY | BUFFER_VALID);
@@ -562,53 +700,139 @@ void brelse(struct buffer *buf)
 		insert_on_dirty_list(buf);
 	}
 
-	insert_on_free_list(buf);
+	/* the buffers mapped onto a page go away along with the page */
+	if(!buf->page) {
+		insert_on_free_list(buf);
+	}
 	buf->flags &= ~BUFFER_LOCKED;
 
 	RESTORE_FLAGS(flags);
 
-	wakeup(&get_free_buffer);
-	wakeup(&buffer_wait);
+	wake_up(&free_buffer_wait);
+	wake_up(&buf->wait);
 }
 
-void sync_buffers(__dev_t dev)
+static void take_dirty_buffer(struct buffer *buf, struct buffer **batch)
+{
+	remove_from_dirty_list(buf);
+	buf->flags |= BUFFER_LOCKED;
+	buf->next_retained = *batch;
+	*batch = buf;
+}
+
+/*
+ * Writes back a batch of up to WRITEBACK_MAX_BUFFERS dirty buffers of the
+ * device 'dev' (or of all devices if zero), along with the rest of the dirty
+ * buffers of the pages they belong to. All the requests are queued before
+ * running the queues, so they are sent in block order and the contiguous ones
+ * are merged into large transfers. Returns the number of buffers written.
+ */
+static int flush_buffers(__dev_t dev)
 {
-	struct buffer *buf, *first;
-	int flushed, size;
+	unsigned int flags;
+	struct buffer *buf, *next, *b, *batch;
+	struct blk_request brh, *br, *tmp;
+	struct device *d;
+	int size, nr, written;
 
-	lock_resource(&sync_resource);
-	flushed = 0;
+	batch = NULL;
+	nr = 0;
+	SAVE_FLAGS(flags); CLI();
 	for(size = BLKSIZE_1K; size <= PAGE_SIZE; size <<= 1) {
-		first = NULL;
-		for(;;) {
-			if(!(buf = get_dirty_buffer(size))) {
-				break;
+		for(buf = buffer_dirty_head[BUFHEAD_INDEX(size)]; buf && nr < WRITEBACK_MAX_BUFFERS; buf = next) {
+			next = buf->next_dirty;
+			if(buf->flags & BUFFER_LOCKED || (dev && buf->dev != dev)) {
+				continue;
 			}
-			if(first == buf) {
-				insert_on_dirty_list(buf);
-				buf->flags &= ~BUFFER_LOCKED;
-				flushed = 1;
-				break;
+			take_dirty_buffer(buf, &batch);
+			nr++;
+			if(!buf->page) {
+				continue;
 			}
-			if(!dev || buf->dev == dev) {
-				if(sync_one_buffer(buf)) {
-					insert_on_dirty_list(buf);
-					buf->flags &= ~BUFFER_LOCKED;
-					continue;
-				}
-				flushed = 1;
-			} else {
-				if(!first) {
-					first = buf;
+			for(b = buf->page->buffers; b; b = b->next_in_page) {
+				if((b->flags & (BUFFER_DIRTY | BUFFER_LOCKED)) == BUFFER_DIRTY) {
+					if(b == next) {
+						next = b->next_dirty;
+					}
+					take_dirty_buffer(b, &batch);
+					nr++;
 				}
-				insert_on_dirty_list(buf);
 			}
+		}
+	}
+	RESTORE_FLAGS(flags);
+
+	memset_b(&brh, 0, sizeof(struct blk_request));
+	tmp = NULL;
+	for(buf = batch; buf; buf = buf->next_retained) {
+		br = NULL;
+		if((d = get_device(BLK_DEV, buf->dev)) && d->fsop->write_block) {
+			br = (struct blk_request *)kmem_cache_alloc(blk_request_cache);
+		}
+		if(!br) {
+			SAVE_FLAGS(flags); CLI();
+			insert_on_dirty_list(buf);
 			buf->flags &= ~BUFFER_LOCKED;
+			RESTORE_FLAGS(flags);
+			wake_up(&buf->wait);
+			continue;
+		}
+		memset_b(br, 0, sizeof(struct blk_request));
+		br->dev = buf->dev;
+		br->block = buf->block;
+		br->size = buf->size;
+		br->buffer = buf;
+		br->device = d;
+		br->fn = d->fsop->write_block;
+		br->head_group = &brh;
+		if(!brh.next_group) {
+			brh.next_group = br;
+		} else {
+			tmp->next_group = br;
 		}
+		tmp = br;
+		SAVE_FLAGS(flags); CLI();
+		brh.left++;
+		add_blk_request(br);
+		RESTORE_FLAGS(flags);
+	}
+
+	/* an interrupt must not complete them between the check and the sleep */
+	SAVE_FLAGS(flags); CLI();
+	for(br = brh.next_group; br; br = br->next_group) {
+		run_blk_request(br->device);
 	}
-	if(flushed) {
-		wakeup(&buffer_wait);
+	if(brh.left) {
+		sleep(&brh, PROC_UNINTERRUPTIBLE);
 	}
+	RESTORE_FLAGS(flags);
+
+	written = 0;
+	br = brh.next_group;
+	while(br) {
+		buf = br->buffer;
+		SAVE_FLAGS(flags); CLI();
+		if(br->errno < 0) {
+			printk("WARNING: %s(): unable to write block %d on device %d,%d.\n", __FUNCTION__, buf->block, MAJOR(buf->dev), MINOR(buf->dev));
+			insert_on_dirty_list(buf);
+		} else {
+			buf->flags &= ~BUFFER_DIRTY;
+			written++;
+		}
+		buf->flags &= ~BUFFER_LOCKED;
+		RESTORE_FLAGS(flags);
+		wake_up(&buf->wait);
+		tmp = br->next_group;
+		kmem_cache_free(blk_request_cache, (unsigned int)br);
+		br = tmp;
+	}
+	return written;
+}
+
+void sync_buffers(__dev_t dev)
+{
+	lock_resource(&sync_resource);
+	while(flush_buffers(dev));
 	unlock_resource(&sync_resource);
 }
 
@@ -625,7 +849,7 @@ void invalidate_buffers(__dev_t dev)
 			buffer_wait(buf);
 			remove_from_hash(buf);
 			buf->flags &= ~(BUFFER_VALID | BUFFER_LOCKED);
-			wakeup(&buffer_wait);
+			wake_up(&buf->wait);
 		}
 		buf = buf->next;
 	}
@@ -719,6 +943,7 @@ int reclaim_buffers(void)
 				buf->mark = 0;
 				append_on_free_list(buf);
 				RESTORE_FLAGS(flags);
+				wake_up(&buf->wait);
 				goto next;
 			}
 			found++;
@@ -739,6 +964,7 @@ int reclaim_buffers(void)
 				buf->mark = mark;
 				append_on_free_list(buf);
 				RESTORE_FLAGS(flags);
+				wake_up(&buf->wait);
 				continue;
 			}
 			kfree((unsigned int)(buf->data) & PAGE_MASK);
@@ -761,8 +987,7 @@ next:
 		}
 	}
 
-	wakeup(&get_free_buffer);
-	wakeup(&buffer_wait);
+	wake_up(&free_buffer_wait);
 
 	/*
 	 * If some buffers were reclaimed, then wakeup any process
@@ -774,56 +999,21 @@ next:
 	return reclaimed;
 }
 
+/*
+ * This is the writeback thread. It's awaken when there are too many dirty
+ * buffers, and writes them back in batches until they are below the limit.
+ */
 int kbdflushd(void)
 {
-	struct buffer *buf, *first;
-	int flushed, size;
-
 	for(;;) {
 		sleep(&kbdflushd, PROC_INTERRUPTIBLE);
-		flushed = 0;
 
 		lock_resource(&sync_resource);
-		for(size = BLKSIZE_1K; size <= PAGE_SIZE; size <<= 1) {
-			first = NULL;
-			for(;;) {
-				if(!(buf = get_dirty_buffer(size))) {
-					break;
-				}
-
-				if(!(buf->flags & BUFFER_DIRTY)) {
-					printk("WARNING: %s(): a dirty buffer (dev %x, block %d, flags = %x) is not marked as dirty!\n", __FUNCTION__, buf->dev, buf->block, buf->flags);
-					continue;
-				}
-
-				if(first) {
-					if(first == buf) {
-						insert_on_dirty_list(buf);
-						buf->flags &= ~BUFFER_LOCKED;
-						wakeup(&buffer_wait);
-						break;
-					}
-				} else {
-					first = buf;
-				}
-
-				if(sync_one_buffer(buf)) {
-					insert_on_dirty_list(buf);
-					buf->flags &= ~BUFFER_LOCKED;
-					wakeup(&buffer_wait);
-					continue;
-				}
-				buf->flags &= ~BUFFER_LOCKED;
-				wakeup(&buffer_wait);
-				flushed++;
-
-				if(flushed >= NR_BUF_RECLAIM) {
-					if(kstat.nr_dirty_buffers < kstat.max_dirty_buffers) {
-						break;
-					}
-					do_sched();
-				}
+		while(flush_buffers(0)) {
+			if(kstat.nr_dirty_buffers < kstat.max_dirty_buffers) {
+				break;
 			}
+			do_sched();
 		}
 		unlock_resource(&sync_resource);
 	}
@@ -836,4 +1026,9 @@ void buffer_init(void)
 	memset_b(buffer_dirty_head, 0, sizeof(buffer_dirty_head));
 	kstat.max_dirty_buffers = (kstat.max_buffers_size * BUFFER_DIRTY_RATIO) / 100;
 	memset_b(buffer_hash_table, 0, buffer_hash_table_size);
+
+	if(!(buffer_cache = kmem_cache_create("buffer", sizeof(struct buffer), NULL))) {
+		PANIC("Unable to create the buffer cache.\n");
+	}
+	blk_queue_init();
 }
@@ -0,0 +1,293 @@
+/*
+ * fiwix/fs/dcache.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+/*
+ * dcache.c implements a cache of the names resolved during the path walk, so
+ * that the components already seen don't need to scan the directory again.
+ *
+ * Each dentry maps a name in a directory (device, directory inode, name) to
+ * the inode number it refers to, or to nothing at all (negative dentry) if
+ * the lookup failed with -ENOENT. The dentries live in a chained hash table
+ * and in a LRU list, so when the cache is full the least recently used
+ * dentry is reused.
+ *
+ * Only the filesystems that live on a block device are cached; the contents
+ * of the virtual ones (procfs, devpts) change on their own. The syscalls
+ * that modify a directory drop the affected dentries, and every one of these
+ * invalidations bumps 'dcache_seq' so a lookup that slept in the filesystem
+ * doesn't cache a result that might have changed meanwhile.
+ */
+
+#include <fiwix/kernel.h>
+#include <fiwix/fs.h>
+#include <fiwix/dcache.h>
+#include <fiwix/errno.h>
+#include <fiwix/mm.h>
+#include <fiwix/stdio.h>
+#include <fiwix/string.h>
+
+#define DCACHE_HASH(dev, dir, h)	(((dev) ^ (dir) ^ (h)) & (NR_DENTRY_HASH - 1))
+
+static struct kmem_cache *dentry_cache;
+static struct dentry *dentry_hash_table[NR_DENTRY_HASH];
+static struct dentry *lru_head;		/* most recently used */
+static struct dentry *lru_tail;		/* least recently used */
+static unsigned int dcache_seq;
+
+static unsigned int name_hash(const char *name, int len)
+{
+	unsigned int h;
+
+	h = 0;
+	while(len--) {
+		h = (h * 31) + *name++;
+	}
+	return h;
+}
+
+static int is_cacheable(struct inode *dir, int len)
+{
+	if(!dir->sb || !dir->sb->fsop) {
+		return 0;
+	}
+	if(!(dir->sb->fsop->flags & FSOP_REQUIRES_DEV)) {
+		return 0;
+	}
+	return len <= DNAME_INLINE_LEN;
+}
+
+static void insert_on_hash(struct dentry *d, unsigned int h)
+{
+	struct dentry **head;
+
+	head = &dentry_hash_table[DCACHE_HASH(d->dev, d->dir, h)];
+	d->prev_hash = NULL;
+	d->next_hash = *head;
+	if(*head) {
+		(*head)->prev_hash = d;
+	}
+	*head = d;
+}
+
+static void remove_from_hash(struct dentry *d)
+{
+	struct dentry **head;
+
+	head = &dentry_hash_table[DCACHE_HASH(d->dev, d->dir, name_hash(d->name, d->len))];
+	if(d->next_hash) {
+		d->next_hash->prev_hash = d->prev_hash;
+	}
+	if(d->prev_hash) {
+		d->prev_hash->next_hash = d->next_hash;
+	}
+	if(d == *head) {
+		*head = d->next_hash;
+	}
+	d->prev_hash = d->next_hash = NULL;
+}
+
+static void insert_on_lru(struct dentry *d)
+{
+	d->prev_lru = NULL;
+	d->next_lru = lru_head;
+	if(lru_head) {
+		lru_head->prev_lru = d;
+	}
+	lru_head = d;
+	if(!lru_tail) {
+		lru_tail = d;
+	}
+}
+
+static void remove_from_lru(struct dentry *d)
+{
+	if(d->next_lru) {
+		d->next_lru->prev_lru = d->prev_lru;
+	}
+	if(d->prev_lru) {
+		d->prev_lru->next_lru = d->next_lru;
+	}
+	if(d == lru_head) {
+		lru_head = d->next_lru;
+	}
+	if(d == lru_tail) {
+		lru_tail = d->prev_lru;
+	}
+	d->prev_lru = d->next_lru = NULL;
+}
+
+static void free_dentry(struct dentry *d)
+{
+	remove_from_hash(d);
+	remove_from_lru(d);
+	kmem_cache_free(dentry_cache, (unsigned int)d);
+	kstat.nr_dentries--;
+}
+
+static struct dentry *search_dentry(__dev_t dev, __ino_t dir, const char *name, int len, unsigned int h)
+{
+	struct dentry *d;
+
+	d = dentry_hash_table[DCACHE_HASH(dev, dir, h)];
+	while(d) {
+		if(d->dev == dev && d->dir == dir && d->len == len) {
+			if(!memcmp(d->name, name, len)) {
+				return d;
+			}
+		}
+		d = d->next_hash;
+	}
+	return NULL;
+}
+
+static void add_dentry(struct inode *dir, const char *name, int len, __ino_t inode)
+{
+	struct dentry *d;
+	unsigned int h;
+
+	h = name_hash(name, len);
+	if((d = search_dentry(dir->dev, dir->inode, name, len, h))) {
+		d->inode = inode;
+		remove_from_lru(d);
+		insert_on_lru(d);
+		return;
+	}
+
+	/* reuse the least recently used dentry if the cache is full */
+	if(kstat.nr_dentries >= NR_DENTRIES && lru_tail) {
+		d = lru_tail;
+		remove_from_hash(d);
+		remove_from_lru(d);
+	} else {
+		if(!(d = (struct dentry *)kmem_cache_alloc(dentry_cache))) {
+			return;
+		}
+		kstat.nr_dentries++;
+	}
+	d->dev = dir->dev;
+	d->dir = dir->inode;
+	d->inode = inode;
+	d->len = len;
+	memcpy_b(d->name, name, len);
+	d->name[len] = 0;
+	insert_on_hash(d, h);
+	insert_on_lru(d);
+}
+
+/*
+ * This is a front-end of the lookup() operation of the filesystems with the
+ * same semantics: it consumes the reference of 'dir' and returns in 'i_res'
+ * the inode found.
+ */
+int dcache_lookup(const char *name, struct inode *dir, struct inode **i_res)
+{
+	struct dentry *d;
+	struct superblock *sb;
+	unsigned int seq;
+	int len, errno;
+
+	len = strlen(name);
+	if(!is_cacheable(dir, len)) {
+		return dir->fsop->lookup(name, dir, i_res);
+	}
+
+	if((d = search_dentry(dir->dev, dir->inode, name, len, name_hash(name, len)))) {
+		kstat.dcache_hits++;
+		remove_from_lru(d);
+		insert_on_lru(d);
+		if(!d->inode) {
+			iput(dir);
+			return -ENOENT;
+		}
+		if(d->inode == dir->inode) {
+			*i_res = dir;
+			return 0;
+		}
+		sb = dir->sb;
+		if(!(*i_res = iget(sb, d->inode))) {
+			iput(dir);
+			return -EACCES;
+		}
+		iput(dir);
+		return 0;
+	}
+
+	/* keep 'dir' around to fill in the dentry after the lookup */
+	kstat.dcache_misses++;
+	seq = dcache_seq;
+	dir->count++;
+	errno = dir->fsop->lookup(name, dir, i_res);
+	if(seq == dcache_seq) {
+		if(!errno) {
+			if((*i_res)->dev == dir->dev) {
+				add_dentry(dir, name, len, (*i_res)->inode);
+			}
+		} else if(errno == -ENOENT) {
+			add_dentry(dir, name, len, 0);
+		}
+	}
+	iput(dir);
+	return errno;
+}
+
+/* drop the dentry of 'name' in the directory 'dir' */
+void dcache_remove(struct inode *dir, const char *name)
+{
+	struct dentry *d;
+	int len;
+
+	dcache_seq++;
+	len = strlen(name);
+	if(len > DNAME_INLINE_LEN) {
+		return;
+	}
+	if((d = search_dentry(dir->dev, dir->inode, name, len, name_hash(name, len)))) {
+		free_dentry(d);
+	}
+}
+
+/* drop the dentries inside the directory 'i' and those that point to it */
+void dcache_purge(struct inode *i)
+{
+	struct dentry *d, *next;
+
+	dcache_seq++;
+	d = lru_head;
+	while(d) {
+		next = d->next_lru;
+		if(d->dev == i->dev && (d->dir == i->inode || d->inode == i->inode)) {
+			free_dentry(d);
+		}
+		d = next;
+	}
+}
+
+void invalidate_dentries(__dev_t dev)
+{
+	struct dentry *d, *next;
+
+	dcache_seq++;
+	d = lru_head;
+	while(d) {
+		next = d->next_lru;
+		if(d->dev == dev) {
+			free_dentry(d);
+		}
+		d = next;
+	}
+}
+
+void dcache_init(void)
+{
+	lru_head = lru_tail = NULL;
+	dcache_seq = 0;
+	memset_b(dentry_hash_table, 0, sizeof(dentry_hash_table));
+
+	if(!(dentry_cache = kmem_cache_create("dentry", sizeof(struct dentry), NULL))) {
+		PANIC("Unable to create the dentry cache.\n");
+	}
+}
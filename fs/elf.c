@@ -414,6 +414,7 @@ int elf_load(struct inode *i, struct binargs *barg, struct sigcontext *sc, char
 	char type;
 	unsigned int ae_ptr_len, ae_str_len;
 	unsigned int sp, str;
+	unsigned int *pgdir;
 
 	elf32_h = (struct elf32_hdr *)data;
 	if(check_elf(elf32_h)) {
@@ -461,6 +462,17 @@ int elf_load(struct inode *i, struct binargs *barg, struct sigcontext *sc, char
 	printk("argc=%d (argv_len=%d) envc=%d (envp_len=%d)  ae_ptr_len=%d ae_str_len=%d\n", barg->argc, barg->argv_len, barg->envc, barg->envp_len, ae_ptr_len, ae_str_len);
 #endif /*__DEBUG__ */
 
+	/* a vfork()ed child needs an address space of its own */
+	if(current->flags & PF_VFORK) {
+		if(!(pgdir = (unsigned int *)kmalloc(PAGE_SIZE))) {
+			if(ii) {
+				iput(ii);
+			}
+			return -ENOMEM;
+		}
+		memcpy_b(pgdir, kpage_dir, PAGE_SIZE);
+		release_vfork(pgdir);
+	}
 
 	/* point of no return */
 
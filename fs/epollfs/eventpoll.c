@@ -0,0 +1,437 @@
+/*
+ * fiwix/fs/epollfs/eventpoll.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+/*
+ * eventpoll.c implements the readiness notification of the files, used by
+ * select(), poll() and the epoll instances.
+ *
+ * When the state of an object changes (a pipe inode, a tty, a socket...), its
+ * driver calls select_notify() with it. The select() method of the drivers
+ * calls select_wait() with the objects its result depends on, so when a file
+ * is added to an epoll instance it gets attached to those objects.
+ *
+ * Each file watched by an epoll instance (epitem) is linked in a hash of the
+ * objects it depends on. So select_notify() only touches the items watching
+ * that object, which are moved to the ready list of their instance, and the
+ * processes in epoll_wait() only check the files in that list instead of all
+ * the files watched. The items of the drivers that don't call select_wait()
+ * are attached to any object, and are checked on every notification.
+ *
+ * The items are level-triggered by default: a file that is still ready after
+ * being reported stays in the ready list, and it's dropped from there once
+ * it's found not ready. With EPOLLET the file is only queued again by the
+ * next notification, and with EPOLLONESHOT it's disabled until EPOLL_CTL_MOD.
+ *
+ * The notifications might come from an interrupt handler, so the hash and
+ * the ready lists are only modified with the interrupts disabled.
+ */
+
+#include <fiwix/asm.h>
+#include <fiwix/kernel.h>
+#include <fiwix/fs.h>
+#include <fiwix/eventpoll.h>
+#include <fiwix/sleep.h>
+#include <fiwix/sched.h>
+#include <fiwix/errno.h>
+#include <fiwix/mm.h>
+#include <fiwix/stdio.h>
+#include <fiwix/string.h>
+
+#define EP_HASH(object)	(((unsigned int)(object) >> 4) & (NR_EP_HASH - 1))
+
+static struct kmem_cache *epitem_cache;
+static struct ep_key *ep_hash_table[NR_EP_HASH];
+static struct epitem *ep_probe;		/* item being attached */
+static unsigned int nr_epitems;
+
+static unsigned int poll_flag(struct inode *i, struct fd *f, int flag, unsigned int events)
+{
+	int n;
+
+	if(!(n = i->fsop->select(i, f, flag))) {
+		return 0;
+	}
+	return n < 0 ? POLLERR : events;
+}
+
+/* returns the events of 'events' that are ready in the file */
+unsigned int poll_file(struct fd *f, unsigned int events)
+{
+	struct inode *i;
+	unsigned int revents;
+
+	i = f->inode;
+	if(!i->fsop || !i->fsop->select) {
+		/* files without the select() method never block */
+		return events & (POLLIN | POLLRDNORM | POLLOUT | POLLWRNORM);
+	}
+
+	revents = 0;
+	if(events & (POLLIN | POLLRDNORM)) {
+		revents |= poll_flag(i, f, SEL_R, events & (POLLIN | POLLRDNORM));
+	}
+	if(events & (POLLOUT | POLLWRNORM)) {
+		revents |= poll_flag(i, f, SEL_W, events & (POLLOUT | POLLWRNORM));
+	}
+	if(events & POLLPRI) {
+		revents |= poll_flag(i, f, SEL_E, POLLPRI);
+	}
+	return revents;
+}
+
+/* called by the select() methods with the objects their result depends on */
+void select_wait(void *object)
+{
+	struct epitem *item;
+	int n;
+
+	if(!(item = ep_probe) || item->nr_keys < 0) {
+		return;
+	}
+	for(n = 0; n < item->nr_keys; n++) {
+		if(item->keys[n].object == object) {
+			return;
+		}
+	}
+	if(item->nr_keys == EP_MAX_KEYS) {
+		/* too many objects, attach it to any object */
+		item->nr_keys = -1;
+		return;
+	}
+	item->keys[item->nr_keys++].object = object;
+}
+
+static void insert_on_hash(struct ep_key *k)
+{
+	struct ep_key **head;
+
+	head = &ep_hash_table[EP_HASH(k->object)];
+	k->prev_hash = NULL;
+	k->next_hash = *head;
+	if(*head) {
+		(*head)->prev_hash = k;
+	}
+	*head = k;
+}
+
+static void remove_from_hash(struct ep_key *k)
+{
+	struct ep_key **head;
+
+	head = &ep_hash_table[EP_HASH(k->object)];
+	if(k->next_hash) {
+		k->next_hash->prev_hash = k->prev_hash;
+	}
+	if(k->prev_hash) {
+		k->prev_hash->next_hash = k->next_hash;
+	}
+	if(k == *head) {
+		*head = k->next_hash;
+	}
+	k->prev_hash = k->next_hash = NULL;
+}
+
+/* appends the item to the ready list, returns 0 if it wasn't queued */
+static int ep_queue(struct epitem *item)
+{
+	struct eventpoll *ep;
+
+	if(item->ready || !(item->events & ~EP_PRIVATE_BITS)) {
+		return 0;
+	}
+	ep = item->ep;
+	item->prev_ready = ep->ready_tail;
+	item->next_ready = NULL;
+	if(ep->ready_tail) {
+		ep->ready_tail->next_ready = item;
+	} else {
+		ep->ready_head = item;
+	}
+	ep->ready_tail = item;
+	ep->nr_ready++;
+	item->ready = 1;
+	return 1;
+}
+
+static void ep_unqueue(struct epitem *item)
+{
+	struct eventpoll *ep;
+
+	if(!item->ready) {
+		return;
+	}
+	ep = item->ep;
+	if(item->next_ready) {
+		item->next_ready->prev_ready = item->prev_ready;
+	} else {
+		ep->ready_tail = item->prev_ready;
+	}
+	if(item->prev_ready) {
+		item->prev_ready->next_ready = item->next_ready;
+	} else {
+		ep->ready_head = item->next_ready;
+	}
+	item->prev_ready = item->next_ready = NULL;
+	ep->nr_ready--;
+	item->ready = 0;
+}
+
+/*
+ * Attaches the item to the objects its file depends on, and queues it if
+ * the file is already ready. It's done with the interrupts disabled so no
+ * notification is lost in between.
+ */
+static void ep_attach(struct epitem *item)
+{
+	unsigned int flags;
+	int n;
+
+	SAVE_FLAGS(flags); CLI();
+	item->nr_keys = 0;
+	ep_probe = item;
+	n = poll_file(item->file, item->events & ~EP_PRIVATE_BITS);
+	ep_probe = NULL;
+	if(n && ep_queue(item)) {
+		wake_up(&item->ep->wait);
+	}
+
+	if(item->nr_keys <= 0) {
+		item->nr_keys = 1;
+		item->keys[0].object = NULL;
+	}
+	for(n = 0; n < item->nr_keys; n++) {
+		item->keys[n].item = item;
+		insert_on_hash(&item->keys[n]);
+	}
+	RESTORE_FLAGS(flags);
+}
+
+static void ep_detach(struct epitem *item)
+{
+	unsigned int flags;
+	int n;
+
+	SAVE_FLAGS(flags); CLI();
+	for(n = 0; n < item->nr_keys; n++) {
+		remove_from_hash(&item->keys[n]);
+	}
+	item->nr_keys = 0;
+	ep_unqueue(item);
+	RESTORE_FLAGS(flags);
+}
+
+/* queues the items watching 'object' and wakes up their instances */
+static void ep_wake_object(void *object)
+{
+	struct ep_key *k;
+
+	for(k = ep_hash_table[EP_HASH(object)]; k; k = k->next_hash) {
+		if(k->object == object) {
+			if(ep_queue(k->item)) {
+				wake_up(&k->item->ep->wait);
+			}
+		}
+	}
+}
+
+/* called by the drivers when the state of 'object' has changed */
+void select_notify(void *object)
+{
+	unsigned int flags;
+
+	wakeup(&do_select);
+	if(!nr_epitems) {
+		return;
+	}
+
+	SAVE_FLAGS(flags); CLI();
+	ep_wake_object(object);
+	if(object) {
+		ep_wake_object(NULL);
+	}
+	RESTORE_FLAGS(flags);
+}
+
+struct epitem *ep_find(struct eventpoll *ep, struct fd *f)
+{
+	struct epitem *item;
+
+	for(item = f->epitems; item; item = item->next_file) {
+		if(item->ep == ep) {
+			return item;
+		}
+	}
+	return NULL;
+}
+
+int ep_insert(struct eventpoll *ep, struct fd *f, struct epoll_event *event)
+{
+	struct epitem *item;
+	unsigned int flags;
+
+	if(!(item = (struct epitem *)kmem_cache_alloc(epitem_cache))) {
+		return -ENOMEM;
+	}
+
+	/* the allocation might have slept */
+	if(ep_find(ep, f)) {
+		kmem_cache_free(epitem_cache, (unsigned int)item);
+		return -EEXIST;
+	}
+
+	memset_b(item, 0, sizeof(struct epitem));
+	item->ep = ep;
+	item->file = f;
+	item->events = event->events;
+	item->data = event->data;
+
+	SAVE_FLAGS(flags); CLI();
+	if((item->next = ep->items)) {
+		ep->items->prev = item;
+	}
+	ep->items = item;
+	if((item->next_file = f->epitems)) {
+		f->epitems->prev_file = item;
+	}
+	f->epitems = item;
+	nr_epitems++;
+	ep_attach(item);
+	RESTORE_FLAGS(flags);
+	return 0;
+}
+
+void ep_modify(struct epitem *item, struct epoll_event *event)
+{
+	unsigned int flags;
+
+	SAVE_FLAGS(flags); CLI();
+	ep_detach(item);
+	item->events = event->events;
+	item->data = event->data;
+	ep_attach(item);
+	RESTORE_FLAGS(flags);
+}
+
+void ep_remove(struct epitem *item)
+{
+	struct eventpoll *ep;
+	unsigned int flags;
+
+	ep = item->ep;
+
+	SAVE_FLAGS(flags); CLI();
+	ep_detach(item);
+	if(item->next) {
+		item->next->prev = item->prev;
+	}
+	if(item->prev) {
+		item->prev->next = item->next;
+	} else {
+		ep->items = item->next;
+	}
+	if(item->next_file) {
+		item->next_file->prev_file = item->prev_file;
+	}
+	if(item->prev_file) {
+		item->prev_file->next_file = item->next_file;
+	} else {
+		item->file->epitems = item->next_file;
+	}
+	nr_epitems--;
+	RESTORE_FLAGS(flags);
+
+	kmem_cache_free(epitem_cache, (unsigned int)item);
+}
+
+/*
+ * Checks the files in the ready list and copies the events of those that are
+ * ready into 'events'. Only the items present on entry are checked, as the
+ * level-triggered ones are queued again at the tail.
+ */
+static int ep_collect(struct eventpoll *ep, struct epoll_event *events, int maxevents)
+{
+	struct epitem *item;
+	struct epoll_event ev;
+	unsigned int flags, n;
+	int count;
+
+	count = 0;
+	n = ep->nr_ready;
+	while(n-- && count < maxevents) {
+		SAVE_FLAGS(flags); CLI();
+		if(!(item = ep->ready_head)) {
+			RESTORE_FLAGS(flags);
+			break;
+		}
+		ep_unqueue(item);
+		ev.events = poll_file(item->file, item->events & ~EP_PRIVATE_BITS);
+		if(ev.events) {
+			ev.data = item->data;
+			if(item->events & EPOLLONESHOT) {
+				item->events &= EP_PRIVATE_BITS;
+			} else if(!(item->events & EPOLLET)) {
+				ep_queue(item);
+			}
+		}
+		RESTORE_FLAGS(flags);
+
+		/* the item is not used anymore, since this might sleep */
+		if(ev.events) {
+			memcpy_b(&events[count++], &ev, sizeof(struct epoll_event));
+		}
+	}
+	return count;
+}
+
+/* this must be called with the timeout of the current process started */
+int ep_poll(struct eventpoll *ep, struct epoll_event *events, int maxevents)
+{
+	unsigned int flags;
+	int count;
+
+	for(;;) {
+		if((count = ep_collect(ep, events, maxevents))) {
+			break;
+		}
+		if(current->sigpending & ~current->sigblocked) {
+			return -EINTR;
+		}
+
+		SAVE_FLAGS(flags); CLI();
+		if(!current->timeout) {
+			RESTORE_FLAGS(flags);
+			break;
+		}
+		if(!ep->nr_ready) {
+			if(sleep_on(&ep->wait, PROC_INTERRUPTIBLE)) {
+				RESTORE_FLAGS(flags);
+				return -EINTR;
+			}
+		}
+		RESTORE_FLAGS(flags);
+	}
+	return count;
+}
+
+/* the file is being released, so it's removed from all the instances */
+void eventpoll_release(struct fd *f)
+{
+	while(f->epitems) {
+		ep_remove(f->epitems);
+	}
+}
+
+void eventpoll_init(void)
+{
+	ep_probe = NULL;
+	nr_epitems = 0;
+	memset_b(ep_hash_table, 0, sizeof(ep_hash_table));
+
+	if(!(epitem_cache = kmem_cache_create("epitem", sizeof(struct epitem), NULL))) {
+		PANIC("Unable to create the epitem cache.\n");
+	}
+}
@@ -0,0 +1,127 @@
+/*
+ * fiwix/fs/epollfs/super.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/types.h>
+#include <fiwix/errno.h>
+#include <fiwix/fs.h>
+#include <fiwix/filesystems.h>
+#include <fiwix/eventpoll.h>
+#include <fiwix/stat.h>
+#include <fiwix/sched.h>
+#include <fiwix/string.h>
+
+static unsigned int i_counter;
+
+struct fs_operations epollfs_fsop = {
+	FSOP_KERN_MOUNT,
+	EPOLL_DEV,
+
+	NULL,			/* open */
+	epollfs_close,
+	NULL,			/* read */
+	NULL,			/* write */
+	NULL,			/* ioctl */
+	epollfs_llseek,
+	NULL,			/* readdir */
+	NULL,			/* readdir64 */
+	NULL,			/* mmap */
+	epollfs_select,
+
+	NULL,			/* readlink */
+	NULL,			/* followlink */
+	NULL,			/* bmap */
+	NULL,			/* lookup */
+	NULL,			/* rmdir */
+	NULL,			/* link */
+	NULL,			/* unlink */
+	NULL,			/* symlink */
+	NULL,			/* mkdir */
+	NULL,			/* mknod */
+	NULL,			/* truncate */
+	NULL,			/* create */
+	NULL,			/* rename */
+
+	NULL,			/* read_block */
+	NULL,			/* write_block */
+
+	NULL,			/* read_inode */
+	NULL,			/* write_inode */
+	epollfs_ialloc,
+	epollfs_ifree,
+	NULL,			/* statfs */
+	epollfs_read_superblock,
+	NULL,			/* remount_fs */
+	NULL,			/* write_superblock */
+	NULL			/* release_superblock */
+};
+
+int epollfs_close(struct inode *i, struct fd *f)
+{
+	struct eventpoll *ep;
+
+	ep = &i->u.epollfs.ep;
+	while(ep->items) {
+		ep_remove(ep->items);
+	}
+	return 0;
+}
+
+__loff_t epollfs_llseek(struct inode *i, __loff_t offset)
+{
+	return -ESPIPE;
+}
+
+int epollfs_select(struct inode *i, struct fd *f, int flag)
+{
+	switch(flag) {
+		case SEL_R:
+			if(i->u.epollfs.ep.nr_ready) {
+				return 1;
+			}
+			break;
+	}
+	return 0;
+}
+
+int epollfs_ialloc(struct inode *i, int mode)
+{
+	struct superblock *sb = i->sb;
+
+	superblock_lock(sb);
+	i_counter++;
+	superblock_unlock(sb);
+
+	i->i_mode = mode;
+	i->dev = i->rdev = sb->dev;
+	i->fsop = &epollfs_fsop;
+	i->inode = i_counter;
+	i->count = 1;
+	memset_b(&i->u.epollfs.ep, 0, sizeof(struct eventpoll));
+	return 0;
+}
+
+void epollfs_ifree(struct inode *i)
+{
+	/* the files watched were already released on the last close() */
+}
+
+int epollfs_read_superblock(__dev_t dev, struct superblock *sb)
+{
+	superblock_lock(sb);
+	sb->dev = dev;
+	sb->fsop = &epollfs_fsop;
+	sb->s_blocksize = BLKSIZE_1K;
+	i_counter = 0;
+	superblock_unlock(sb);
+	return 0;
+}
+
+int epollfs_init(void)
+{
+	eventpoll_init();
+	return register_filesystem("epollfs", &epollfs_fsop);
+}
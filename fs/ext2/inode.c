@@ -256,7 +256,7 @@ int ext2_bmap(struct inode *i, __off_t offset, int mode)
 				return -ENOSPC;
 			}
 			/* initialize the new block */
-			if(!(buf = bread(i->dev, newblock, blksize))) {
+			if(!(buf = getblk(i->dev, newblock, blksize))) {
 				ext2_bfree(i->sb, newblock);
 				return -EIO;
 			}
@@ -274,7 +274,7 @@ int ext2_bmap(struct inode *i, __off_t offset, int mode)
 				return -ENOSPC;
 			}
 			/* initialize the new block */
-			if(!(buf = bread(i->dev, newblock, blksize))) {
+			if(!(buf = getblk(i->dev, newblock, blksize))) {
 				ext2_bfree(i->sb, newblock);
 				return -EIO;
 			}
@@ -307,7 +307,7 @@ int ext2_bmap(struct inode *i, __off_t offset, int mode)
 				return -ENOSPC;
 			}
 			/* initialize the new block */
-			if(!(buf2 = bread(i->dev, newblock, blksize))) {
+			if(!(buf2 = getblk(i->dev, newblock, blksize))) {
 				ext2_bfree(i->sb, newblock);
 				brelse(buf);
 				return -EIO;
@@ -349,7 +349,7 @@ int ext2_bmap(struct inode *i, __off_t offset, int mode)
 					return -ENOSPC;
 				}
 				/* initialize the new block */
-				if(!(buf4 = bread(i->dev, newblock, blksize))) {
+				if(!(buf4 = getblk(i->dev, newblock, blksize))) {
 					ext2_bfree(i->sb, newblock);
 					brelse(buf);
 					brelse(buf3);
@@ -396,7 +396,7 @@ int ext2_bmap(struct inode *i, __off_t offset, int mode)
 			return -ENOSPC;
 		}
 		/* initialize the new block */
-		if(!(buf4 = bread(i->dev, newblock, blksize))) {
+		if(!(buf4 = getblk(i->dev, newblock, blksize))) {
 			ext2_bfree(i->sb, newblock);
 			brelse(buf);
 			if(level == EXT2_TIND_BLOCK) {
@@ -5,16 +5,68 @@
  * Distributed under the terms of the Fiwix License.
  */
 
+/*
+ * Both the system file table (fd_table) and the descriptor table of each
+ * process keep a bitmap of the slots in use, and a hint of the lowest slot
+ * that may be free. So finding the lowest free slot only scans the bitmap
+ * words from the hint onwards, instead of every slot.
+ *
+ * The descriptor table of a process starts small and it's doubled every time
+ * it runs out of slots, up to the RLIMIT_NOFILE of the process. The system
+ * file table keeps its size, as its entries are referenced by address while
+ * the filesystems sleep.
+ *
+ * The descriptor table is shared by the processes created by clone() with
+ * CLONE_FILES, and it's freed when the last of them releases it. Only its
+ * last user closes the descriptors on exit.
+ */
+
+#include <fiwix/kernel.h>
 #include <fiwix/errno.h>
 #include <fiwix/types.h>
 #include <fiwix/fs.h>
+#include <fiwix/eventpoll.h>
+#include <fiwix/mm.h>
 #include <fiwix/sleep.h>
 #include <fiwix/stdio.h>
 #include <fiwix/string.h>
 
+#define FD_TABLE_MIN	32	/* initial size of a descriptor table */
+#define BITMAP_WORDS(n)	(((n) + 31) / 32)
+
 struct fd *fd_table;
 
-static struct resource fd_resource = { 0, 0 };
+static struct resource fd_resource = { 0 };
+static unsigned int fd_bitmap[BITMAP_WORDS(NR_OPENS)];
+static struct kmem_cache *files_cache;
+static unsigned int fd_next;
+
+/* returns the index of the lowest bit set in 'word', which can't be 0 */
+static int lowest_bit(unsigned int word)
+{
+	int bit;
+
+	__asm__ __volatile__ ("bsfl %1, %0" : "=r" (bit) : "rm" (word));
+	return bit;
+}
+
+/* returns the first clear bit from 'start' onwards, or 'size' if none */
+static unsigned int find_zero_bit(unsigned int *bitmap, unsigned int size, unsigned int start)
+{
+	unsigned int n, word;
+
+	for(n = start & ~31; n < size; n += 32) {
+		word = ~bitmap[n / 32];
+		if(n < start) {
+			word &= ~0U << (start - n);
+		}
+		if(word) {
+			n += lowest_bit(word);
+			return n < size ? n : size;
+		}
+	}
+	return size;
+}
 
 int get_new_fd(struct inode *i)
 {
@@ -22,14 +74,14 @@ int get_new_fd(struct inode *i)
 
 	lock_resource(&fd_resource);
 
-	for(n = 1; n < NR_OPENS; n++) {
-		if(fd_table[n].count == 0) {
-			memset_b(&fd_table[n], 0, sizeof(struct fd));
-			fd_table[n].inode = i;
-			fd_table[n].count = 1;
-			unlock_resource(&fd_resource);
-			return n;
-		}
+	if((n = find_zero_bit(fd_bitmap, NR_OPENS, fd_next)) < NR_OPENS) {
+		fd_bitmap[n / 32] |= 1 << (n % 32);
+		fd_next = n + 1;
+		memset_b(&fd_table[n], 0, sizeof(struct fd));
+		fd_table[n].inode = i;
+		fd_table[n].count = 1;
+		unlock_resource(&fd_resource);
+		return n;
 	}
 
 	unlock_resource(&fd_resource);
@@ -39,32 +91,176 @@ int get_new_fd(struct inode *i)
 
 void release_fd(unsigned int fd)
 {
+	if(fd_table[fd].epitems) {
+		eventpoll_release(&fd_table[fd]);
+	}
+
 	lock_resource(&fd_resource);
 	fd_table[fd].count = 0;
+	fd_bitmap[fd / 32] &= ~(1 << (fd % 32));
+	if(fd < fd_next) {
+		fd_next = fd;
+	}
 	unlock_resource(&fd_resource);
 }
 
+/* replaces the descriptor table with one of 'size' slots */
+static int resize_user_fd_table(struct files *f, unsigned int size)
+{
+	unsigned int *bitmap;
+	unsigned short int *fd;
+	unsigned char *fd_flags;
+	unsigned int words;
+
+	words = BITMAP_WORDS(size);
+	if(!(bitmap = (unsigned int *)kmalloc((words * sizeof(unsigned int)) + (size * (sizeof(unsigned short int) + sizeof(unsigned char)))))) {
+		return -ENOMEM;
+	}
+	fd = (unsigned short int *)(bitmap + words);
+	fd_flags = (unsigned char *)(fd + size);
+	memset_b(bitmap, 0, words * sizeof(unsigned int));
+	memset_b(fd, 0, size * sizeof(unsigned short int));
+	memset_b(fd_flags, 0, size);
+
+	if(f->fd_max) {
+		memcpy_b(bitmap, f->fd_bitmap, BITMAP_WORDS(f->fd_max) * sizeof(unsigned int));
+		memcpy_b(fd, f->fd, f->fd_max * sizeof(unsigned short int));
+		memcpy_b(fd_flags, f->fd_flags, f->fd_max);
+		kfree((unsigned int)f->fd_bitmap);
+	}
+	f->fd_bitmap = bitmap;
+	f->fd = fd;
+	f->fd_flags = fd_flags;
+	f->fd_max = size;
+	return 0;
+}
+
 int get_new_user_fd(int fd)
 {
-	int n;
+	struct files *f;
+	unsigned int n, start, limit, size;
 
-	for(n = fd; n < OPEN_MAX && n < current->rlim[RLIMIT_NOFILE].rlim_cur; n++) {
-		if(current->fd[n] == 0) {
-			current->fd[n] = -1;
-			current->fd_flags[n] = 0;
-			return n;
+	f = current->files;
+	limit = MIN((unsigned int)current->rlim[RLIMIT_NOFILE].rlim_cur, NR_OPENS);
+	start = MAX((unsigned int)fd, f->fd_next);
+	n = find_zero_bit(f->fd_bitmap, f->fd_max, start);
+	n = MAX(n, start);
+	if(n >= limit) {
+		return -EMFILE;
+	}
+
+	if(n >= f->fd_max) {
+		size = f->fd_max ? f->fd_max : FD_TABLE_MIN;
+		while(size <= n) {
+			size <<= 1;
+		}
+		if(resize_user_fd_table(f, MIN(size, limit))) {
+			return -ENOMEM;
 		}
 	}
 
-	return -EMFILE;
+	f->fd_bitmap[n / 32] |= 1 << (n % 32);
+	f->fd[n] = -1;
+	f->fd_flags[n] = 0;
+	if(start == f->fd_next) {
+		f->fd_next = n + 1;
+	}
+	return n;
 }
 
 void release_user_fd(int ufd)
 {
-	current->fd[ufd] = 0;
+	struct files *f;
+
+	f = current->files;
+	f->fd[ufd] = 0;
+	f->fd_bitmap[ufd / 32] &= ~(1 << (ufd % 32));
+	if(ufd < f->fd_next) {
+		f->fd_next = ufd;
+	}
+}
+
+/*
+ * Gives the child its own copy of the descriptor table of the parent (an
+ * empty one if the parent has none). The child might be the parent itself,
+ * to stop sharing its table. The usage of the descriptors is not increased.
+ */
+int dup_user_fd_table(struct proc *child, struct proc *parent)
+{
+	struct files *old, *new;
+
+	if(!(new = (struct files *)kmem_cache_alloc(files_cache))) {
+		return -ENOMEM;
+	}
+	memset_b(new, 0, sizeof(struct files));
+	new->count = 1;
+
+	if((old = parent->files) && old->fd_max) {
+		if(resize_user_fd_table(new, old->fd_max)) {
+			kmem_cache_free(files_cache, (unsigned int)new);
+			return -ENOMEM;
+		}
+		memcpy_b(new->fd_bitmap, old->fd_bitmap, BITMAP_WORDS(old->fd_max) * sizeof(unsigned int));
+		memcpy_b(new->fd, old->fd, old->fd_max * sizeof(unsigned short int));
+		memcpy_b(new->fd_flags, old->fd_flags, old->fd_max);
+		new->fd_next = old->fd_next;
+	}
+	if(child == parent) {
+		old->count--;
+	}
+	child->files = new;
+	return 0;
+}
+
+/* gives the current process its own copy of a shared descriptor table */
+int unshare_user_fd_table(void)
+{
+	struct files *f;
+	unsigned int n;
+
+	if(current->files->count == 1) {
+		return 0;
+	}
+	if(dup_user_fd_table(current, current)) {
+		return -ENOMEM;
+	}
+	f = current->files;
+	for(n = 0; n < f->fd_max; n++) {
+		if(f->fd[n]) {
+			fd_table[f->fd[n]].count++;
+		}
+	}
+	return 0;
+}
+
+/* drops the descriptor table of the process, it's freed by the last user */
+void free_user_fd_table(struct proc *p)
+{
+	struct files *f;
+
+	if(!(f = p->files)) {
+		return;
+	}
+	p->files = NULL;
+	if(--f->count) {
+		return;
+	}
+	if(f->fd_bitmap) {
+		kfree((unsigned int)f->fd_bitmap);
+	}
+	kmem_cache_free(files_cache, (unsigned int)f);
 }
 
 void fd_init(void)
 {
 	memset_b(fd_table, 0, fd_table_size);
+	memset_b(fd_bitmap, 0, sizeof(fd_bitmap));
+
+	/* the slot 0 is never used */
+	fd_bitmap[0] = 1;
+	fd_next = 1;
+
+	if(!(files_cache = kmem_cache_create("files", sizeof(struct files), NULL))) {
+		PANIC("Unable to create the files cache.\n");
+	}
 }
@@ -84,6 +84,9 @@ void fs_init(void)
 		printk("%s(): unable to register 'sockfs' filesystem.\n", __FUNCTION__);
 	}
 #endif /* CONFIG_NET */
+	if(epollfs_init()) {
+		printk("%s(): unable to register 'epollfs' filesystem.\n", __FUNCTION__);
+	}
 #ifdef CONFIG_UNIX98_PTYS
 	if(devpts_init()) {
 		printk("%s(): unable to register 'devpts' filesystem.\n", __FUNCTION__);
@@ -41,14 +41,15 @@ struct inode *inode_table;		/* inode pool */
 struct inode *inode_head;		/* head of free list */
 struct inode **inode_hash_table;
 
-static struct resource sync_resource = { 0, 0 };
+static struct kmem_cache *inode_cache;
+static struct resource sync_resource = { 0 };
 
 static struct inode *add_inode_to_pool(void)
 {
 	unsigned int flags;
 	struct inode *i;
 
-	if(!(i = (struct inode *)kmalloc(sizeof(struct inode)))) {
+	if(!(i = (struct inode *)kmem_cache_alloc(inode_cache))) {
 		return NULL;
 	}
 	memset_b(i, 0, sizeof(struct inode));
@@ -95,7 +96,7 @@ static void del_inode_from_pool(struct inode *i)
 	}
 	RESTORE_FLAGS(flags);
 
-	kfree((unsigned int)tmp);
+	kmem_cache_free(inode_cache, (unsigned int)tmp);
 	kstat.nr_inodes--;
 }
 
@@ -272,7 +273,7 @@ static void wait_on_inode(struct inode *i)
 {
 	for(;;) {
 		if(i->state & INODE_LOCKED) {
-			sleep(i, PROC_UNINTERRUPTIBLE);
+			sleep_on(&i->wait, PROC_UNINTERRUPTIBLE);
 		} else {
 			break;
 		}
@@ -283,14 +284,9 @@ void inode_lock(struct inode *i)
 {
 	unsigned int flags;
 
-	for(;;) {
-		SAVE_FLAGS(flags); CLI();
-		if(i->state & INODE_LOCKED) {
-			RESTORE_FLAGS(flags);
-			sleep(i, PROC_UNINTERRUPTIBLE);
-		} else {
-			break;
-		}
+	SAVE_FLAGS(flags); CLI();
+	while(i->state & INODE_LOCKED) {
+		sleep_on_exclusive(&i->wait, PROC_UNINTERRUPTIBLE);
 	}
 	i->state |= INODE_LOCKED;
 	RESTORE_FLAGS(flags);
@@ -302,7 +298,7 @@ void inode_unlock(struct inode *i)
 
 	SAVE_FLAGS(flags); CLI();
 	i->state &= ~INODE_LOCKED;
-	wakeup(i);
+	wake_up(&i->wait);
 	RESTORE_FLAGS(flags);
 }
 
@@ -340,7 +336,7 @@ struct inode *iget(struct superblock *sb, __ino_t inode)
 		if((i = search_inode_hash(sb->dev, inode))) {
 			SAVE_FLAGS(flags); CLI();
 			if(i->state & INODE_LOCKED) {
-				sleep(i, PROC_UNINTERRUPTIBLE);
+				sleep_on(&i->wait, PROC_UNINTERRUPTIBLE);
 				RESTORE_FLAGS(flags);
 				continue;
 			}
@@ -504,4 +500,8 @@ void inode_init(void)
 {
 	inode_table = inode_head = NULL;
 	memset_b(inode_hash_table, 0, inode_hash_table_size);
+
+	if(!(inode_cache = kmem_cache_create("inode", sizeof(struct inode), NULL))) {
+		PANIC("Unable to create the inode cache.\n");
+	}
 }
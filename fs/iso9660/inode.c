@@ -30,12 +30,12 @@ static int read_pathtable(struct inode *i)
 	pt_len = isonum_733(sbi->sb->path_table_size);
 	pt_blk = isonum_731(sbi->sb->type_l_path_table);
 
-	if(pt_len > PAGE_SIZE) {
-		printk("WARNING: %s(): path table record size (%d) > 4096, not supported yet.\n", __FUNCTION__, pt_len);
+	if(pt_len > (PAGE_SIZE << BUDDY_HIGH_MAX_ORDER)) {
+		printk("WARNING: %s(): path table record size (%d) > %d, not supported yet.\n", __FUNCTION__, pt_len, PAGE_SIZE << BUDDY_HIGH_MAX_ORDER);
 		return -EINVAL;
 	}
 
-	if(!(sbi->pathtable_raw = (void *)kmalloc(PAGE_SIZE))) {
+	if(!(sbi->pathtable_raw = (void *)kmalloc(pt_len))) {
 		return -ENOMEM;
 	}
 	offset = 0;
@@ -51,7 +51,7 @@ static int read_pathtable(struct inode *i)
 
 	/* allocate and count the number of records in the Path Table */
 	offset = n = 0;
-	if(!(sbi->pathtable = (struct iso9660_pathtable_record **)kmalloc(PAGE_SIZE))) {
+	if(!(sbi->pathtable = (struct iso9660_pathtable_record **)kmalloc(((pt_len / sizeof(struct iso9660_pathtable_record)) + 2) * sizeof(struct iso9660_pathtable_record *)))) {
 		kfree((unsigned int)sbi->pathtable_raw);
 		return -ENOMEM;
 	}
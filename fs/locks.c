@@ -19,7 +19,7 @@
 
 struct flock_file *flock_file_table = NULL;
 
-static struct resource flock_resource = { 0, 0 };
+static struct resource flock_resource = { 0 };
 
 static struct flock_file *get_new_flock(struct inode *i)
 {
@@ -111,7 +111,7 @@ int posix_lock(int ufd, int cmd, struct flock *fl)
 
 	lock_resource(&flock_resource);
 	ff = flock_file_table;
-	i = fd_table[current->fd[ufd]].inode;
+	i = fd_table[current->files->fd[ufd]].inode;
 
 	while(ff) {
 		if(ff->inode == i) {
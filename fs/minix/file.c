@@ -78,49 +78,25 @@ int minix_file_close(struct inode *i, struct fd *f)
 
 int minix_file_write(struct inode *i, struct fd *f, const char *buffer, __size_t count)
 {
-	__blk_t block;
-	__size_t total_written;
-	unsigned int boffset, bytes;
-	int blksize;
-	struct buffer *buf;
+	int retval;
 
 	inode_lock(i);
 
-	blksize = i->sb->s_blocksize;
-	total_written = 0;
-
 	if(f->flags & O_APPEND) {
 		f->offset = i->i_size;
 	}
 
-	while(total_written < count) {
-		boffset = f->offset & (blksize - 1);	/* mod blksize */
-		if((block = bmap(i, f->offset, FOR_WRITING)) < 0) {
-			inode_unlock(i);
-			return block;
-		}
-		bytes = blksize - boffset;
-		bytes = MIN(bytes, (count - total_written));
-		if(!(buf = bread(i->dev, block, blksize))) {
-			inode_unlock(i);
-			return -EIO;
+	if((retval = file_write(i, f, buffer, count)) > 0) {
+		if(f->offset > i->i_size) {
+			i->i_size = f->offset;
 		}
-		memcpy_b(buf->data + boffset, buffer + total_written, bytes);
-		update_page_cache(i, f->offset, buffer + total_written, bytes);
-		bwrite(buf);
-		total_written += bytes;
-		f->offset += bytes;
+		i->i_ctime = CURRENT_TIME;
+		i->i_mtime = CURRENT_TIME;
+		i->state |= INODE_DIRTY;
 	}
 
-	if(f->offset > i->i_size) {
-		i->i_size = f->offset;
-	}
-	i->i_ctime = CURRENT_TIME;
-	i->i_mtime = CURRENT_TIME;
-	i->state |= INODE_DIRTY;
-	
 	inode_unlock(i);
-	return total_written;
+	return retval;
 }
 
 __loff_t minix_file_llseek(struct inode *i, __loff_t offset)
@@ -276,7 +276,7 @@ int v1_minix_bmap(struct inode *i, __off_t offset, int mode)
 				return -ENOSPC;
 			}
 			/* initialize the new block */
-			if(!(buf = bread(i->dev, newblock, blksize))) {
+			if(!(buf = getblk(i->dev, newblock, blksize))) {
 				minix_bfree(i->sb, newblock);
 				return -EIO;
 			}
@@ -293,7 +293,7 @@ int v1_minix_bmap(struct inode *i, __off_t offset, int mode)
 				return -ENOSPC;
 			}
 			/* initialize the new block */
-			if(!(buf = bread(i->dev, newblock, blksize))) {
+			if(!(buf = getblk(i->dev, newblock, blksize))) {
 				minix_bfree(i->sb, newblock);
 				return -EIO;
 			}
@@ -321,7 +321,7 @@ int v1_minix_bmap(struct inode *i, __off_t offset, int mode)
 				return -ENOSPC;
 			}
 			/* initialize the new block */
-			if(!(buf2 = bread(i->dev, newblock, blksize))) {
+			if(!(buf2 = getblk(i->dev, newblock, blksize))) {
 				minix_bfree(i->sb, newblock);
 				brelse(buf);
 				return -EIO;
@@ -360,7 +360,7 @@ int v1_minix_bmap(struct inode *i, __off_t offset, int mode)
 			return -ENOSPC;
 		}
 		/* initialize the new block */
-		if(!(buf3 = bread(i->dev, newblock, blksize))) {
+		if(!(buf3 = getblk(i->dev, newblock, blksize))) {
 			minix_bfree(i->sb, newblock);
 			brelse(buf);
 			brelse(buf2);
@@ -283,7 +283,7 @@ int v2_minix_bmap(struct inode *i, __off_t offset, int mode)
 				return -ENOSPC;
 			}
 			/* initialize the new block */
-			if(!(buf = bread(i->dev, newblock, blksize))) {
+			if(!(buf = getblk(i->dev, newblock, blksize))) {
 				minix_bfree(i->sb, newblock);
 				return -EIO;
 			}
@@ -300,7 +300,7 @@ int v2_minix_bmap(struct inode *i, __off_t offset, int mode)
 				return -ENOSPC;
 			}
 			/* initialize the new block */
-			if(!(buf = bread(i->dev, newblock, blksize))) {
+			if(!(buf = getblk(i->dev, newblock, blksize))) {
 				minix_bfree(i->sb, newblock);
 				return -EIO;
 			}
@@ -332,7 +332,7 @@ int v2_minix_bmap(struct inode *i, __off_t offset, int mode)
 				return -ENOSPC;
 			}
 			/* initialize the new block */
-			if(!(buf2 = bread(i->dev, newblock, blksize))) {
+			if(!(buf2 = getblk(i->dev, newblock, blksize))) {
 				minix_bfree(i->sb, newblock);
 				brelse(buf);
 				return -EIO;
@@ -373,7 +373,7 @@ int v2_minix_bmap(struct inode *i, __off_t offset, int mode)
 					return -ENOSPC;
 				}
 				/* initialize the new block */
-				if(!(buf4 = bread(i->dev, newblock, blksize))) {
+				if(!(buf4 = getblk(i->dev, newblock, blksize))) {
 					minix_bfree(i->sb, newblock);
 					brelse(buf);
 					brelse(buf3);
@@ -419,7 +419,7 @@ int v2_minix_bmap(struct inode *i, __off_t offset, int mode)
 			return -ENOSPC;
 		}
 		/* initialize the new block */
-		if(!(buf4 = bread(i->dev, newblock, blksize))) {
+		if(!(buf4 = getblk(i->dev, newblock, blksize))) {
 			minix_bfree(i->sb, newblock);
 			brelse(buf);
 			if(level == MINIX_TIND_BLOCK) {
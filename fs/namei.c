@@ -10,6 +10,7 @@
 #include <fiwix/sched.h>
 #include <fiwix/fs.h>
 #include <fiwix/filesystems.h>
+#include <fiwix/dcache.h>
 #include <fiwix/stat.h>
 #include <fiwix/mm.h>
 #include <fiwix/mman.h>
@@ -65,7 +66,7 @@ static int do_namei(char *path, struct inode *dir, struct inode **i_res, struct
 		}
 
 		dir->count++;
-		if((errno = dir->fsop->lookup(name, dir, &i))) {
+		if((errno = dcache_lookup(name, dir, &i))) {
 			break;
 		}
 
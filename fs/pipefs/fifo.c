@@ -30,12 +30,12 @@ int fifo_open(struct inode *i, struct fd *f)
 
 	if((f->flags & O_ACCMODE) == O_RDONLY) {
 		i->u.pipefs.i_readers++;
-		wakeup(&pipefs_write);
+		wake_up(&i->u.pipefs.i_write_wait);
 		if(!(f->flags & O_NONBLOCK)) {
 			while(!i->u.pipefs.i_writers) {
-				if(sleep(&pipefs_read, PROC_INTERRUPTIBLE)) {
+				if(sleep_on(&i->u.pipefs.i_read_wait, PROC_INTERRUPTIBLE)) {
 					if(!--i->u.pipefs.i_readers) {
-						wakeup(&pipefs_write);
+						wake_up(&i->u.pipefs.i_write_wait);
 					}
 					return -EINTR;
 				}
@@ -49,12 +49,12 @@ int fifo_open(struct inode *i, struct fd *f)
 		}
 
 		i->u.pipefs.i_writers++;
-		wakeup(&pipefs_read);
+		wake_up(&i->u.pipefs.i_read_wait);
 		if(!(f->flags & O_NONBLOCK)) {
 			while(!i->u.pipefs.i_readers) {
-				if(sleep(&pipefs_write, PROC_INTERRUPTIBLE)) {
+				if(sleep_on(&i->u.pipefs.i_write_wait, PROC_INTERRUPTIBLE)) {
 					if(!--i->u.pipefs.i_writers) {
-						wakeup(&pipefs_read);
+						wake_up(&i->u.pipefs.i_read_wait);
 					}
 					return -EINTR;
 				}
@@ -65,8 +65,8 @@ int fifo_open(struct inode *i, struct fd *f)
 	if((f->flags & O_ACCMODE) == O_RDWR) {
 		i->u.pipefs.i_readers++;
 		i->u.pipefs.i_writers++;
-		wakeup(&pipefs_write);
-		wakeup(&pipefs_read);
+		wake_up(&i->u.pipefs.i_write_wait);
+		wake_up(&i->u.pipefs.i_read_wait);
 	}
 
 	return 0;
@@ -10,6 +10,7 @@
 #include <fiwix/fs.h>
 #include <fiwix/filesystems.h>
 #include <fiwix/fs_pipe.h>
+#include <fiwix/poll.h>
 #include <fiwix/stat.h>
 #include <fiwix/fcntl.h>
 #include <fiwix/ioctl.h>
@@ -18,30 +19,30 @@
 #include <fiwix/stdio.h>
 #include <fiwix/string.h>
 
-static struct resource pipe_resource = { 0, 0 };
+static struct resource pipe_resource = { 0 };
 
 int pipefs_close(struct inode *i, struct fd *f)
 {
 	if((f->flags & O_ACCMODE) == O_RDONLY) {
 		if(!--i->u.pipefs.i_readers) {
-			wakeup(&do_select);
-			wakeup(&pipefs_write);
+			select_notify(i);
+			wake_up(&i->u.pipefs.i_write_wait);
 		}
 	}
 	if((f->flags & O_ACCMODE) == O_WRONLY) {
 		if(!--i->u.pipefs.i_writers) {
-			wakeup(&do_select);
-			wakeup(&pipefs_read);
+			select_notify(i);
+			wake_up(&i->u.pipefs.i_read_wait);
 		}
 	}
 	if((f->flags & O_ACCMODE) == O_RDWR) {
 		if(!--i->u.pipefs.i_readers) {
-			wakeup(&do_select);
-			wakeup(&pipefs_write);
+			select_notify(i);
+			wake_up(&i->u.pipefs.i_write_wait);
 		}
 		if(!--i->u.pipefs.i_writers) {
-			wakeup(&do_select);
-			wakeup(&pipefs_read);
+			select_notify(i);
+			wake_up(&i->u.pipefs.i_read_wait);
 		}
 	}
 	return 0;
@@ -77,15 +78,15 @@ int pipefs_read(struct inode *i, struct fd *f, char *buffer, __size_t count)
 				i->u.pipefs.i_writeoff = 0;
 			}
 			unlock_resource(&pipe_resource);
-			wakeup(&do_select);
-			wakeup(&pipefs_write);
+			select_notify(i);
+			wake_up(&i->u.pipefs.i_write_wait);
 			break;
 		} else {
 			if(i->u.pipefs.i_writers) {
 				if(f->flags & O_NONBLOCK) {
 					return -EAGAIN;
 				}
-				if(sleep(&pipefs_read, PROC_INTERRUPTIBLE)) {
+				if(sleep_on(&i->u.pipefs.i_read_wait, PROC_INTERRUPTIBLE)) {
 					return -EINTR;
 				}
 			} else {
@@ -151,15 +152,15 @@ int pipefs_write(struct inode *i, struct fd *f, const char *buffer, __size_t cou
 				i->u.pipefs.i_readoff = 0;
 			}
 			unlock_resource(&pipe_resource);
-			wakeup(&do_select);
-			wakeup(&pipefs_read);
+			select_notify(i);
+			wake_up(&i->u.pipefs.i_read_wait);
 			continue;
 		}
 
-		wakeup(&do_select);
-		wakeup(&pipefs_read);
+		select_notify(i);
+		wake_up(&i->u.pipefs.i_read_wait);
 		if(!(f->flags & O_NONBLOCK)) {
-			if(sleep(&pipefs_write, PROC_INTERRUPTIBLE)) {
+			if(sleep_on(&i->u.pipefs.i_write_wait, PROC_INTERRUPTIBLE)) {
 				return -EINTR;
 			}
 		} else {
@@ -193,6 +194,7 @@ __loff_t pipefs_llseek(struct inode *i, __loff_t offset)
 
 int pipefs_select(struct inode *i, struct fd *f, int flag)
 {
+	select_wait(i);
 	switch(flag) {
 		case SEL_R:
 			/*
@@ -55,9 +55,26 @@ int data_proc_self(char *buffer, __pid_t pid)
 	return sprintk(buffer, "%s", current->pidstr);
 }
 
+int data_proc_blkstats(char *buffer, __pid_t pid)
+{
+	int n, size;
+	struct device *d;
+
+	size = sprintk(buffer, "major name       requests     merges dispatches      seeks\n");
+	for(n = 0; n < NR_BLKDEV; n++) {
+		d = blk_device_table[n];
+		while(d) {
+			size += sprintk(buffer + size, "%5d %8s %10u %10u %10u %10u\n", d->major, d->name, d->stats.requests, d->stats.merges, d->stats.dispatches, d->stats.seeks);
+			d = d->next;
+		}
+	}
+	return size;
+}
+
 int data_proc_buddyinfo(char *buffer, __pid_t pid)
 {
 	int n, level, size;
+	int areas[BUDDY_HIGH_MAX_ORDER + 1];
 
 	size = sprintk(buffer, "Sizes:");
 	for(level = 32, n = 0; n < BUDDY_MAX_LEVEL; n++, level <<= 1) {
@@ -71,6 +88,28 @@ int data_proc_buddyinfo(char *buffer, __pid_t pid)
 	size += sprintk(buffer + size, "\n\n");
 	size += sprintk(buffer + size, "Memory requested (used): %d KB (%d KB)\n", kstat.buddy_low_mem_requested / 1024, (kstat.buddy_low_num_pages * PAGE_SIZE / 1024));
 
+	size += sprintk(buffer + size, "\nPages:");
+	for(n = 0; n <= BUDDY_HIGH_MAX_ORDER; n++) {
+		size += sprintk(buffer + size, "\t%d", 1 << n);
+	}
+	size += sprintk(buffer + size, "\n");
+	size += sprintk(buffer + size, "------------------------------------------------------------\n");
+	size += sprintk(buffer + size, "Used:");
+	for(n = 0; n <= BUDDY_HIGH_MAX_ORDER; n++) {
+		size += sprintk(buffer + size, "\t%d", kstat.buddy_high_count[n]);
+	}
+	size += sprintk(buffer + size, "\nFree:");
+	for(n = 0; n <= BUDDY_HIGH_MAX_ORDER; n++) {
+		size += sprintk(buffer + size, "\t%d", kstat.buddy_high_free[n]);
+	}
+	get_free_areas(areas, BUDDY_HIGH_MAX_ORDER);
+	size += sprintk(buffer + size, "\nPool:");
+	for(n = 0; n <= BUDDY_HIGH_MAX_ORDER; n++) {
+		size += sprintk(buffer + size, "\t%d", areas[n]);
+	}
+	size += sprintk(buffer + size, "\n\n");
+	size += sprintk(buffer + size, "Memory used by buddy_high: %d KB\n", kstat.buddy_high_num_pages * PAGE_SIZE / 1024);
+
 	return size;
 }
 
@@ -403,6 +442,18 @@ int data_proc_rtc(char *buffer, __pid_t pid)
 	return size;
 }
 
+int data_proc_slabinfo(char *buffer, __pid_t pid)
+{
+	struct kmem_cache *c;
+	int size;
+
+	size = sprintk(buffer, "name         size objsize  active   total slabs colors     allocs      frees\n");
+	for(c = kmem_cache_head; c; c = c->next) {
+		size += sprintk(buffer + size, "%12s %4d %7d %7d %7d %5d %6d %10u %10u\n", c->name, c->size, c->objsize, c->nr_active, c->nr_slabs * c->objs_per_slab, c->nr_slabs, c->colors, c->nr_allocs, c->nr_frees);
+	}
+	return size;
+}
+
 int data_proc_stat(char *buffer, __pid_t pid)
 {
 	int n, size;
@@ -445,6 +496,21 @@ int data_proc_fullversion(char *buffer, __pid_t pid)
 	return sprintk(buffer, "Fiwix version %s %s\n", UTS_RELEASE, UTS_VERSION);
 }
 
+int data_proc_vmstat(char *buffer, __pid_t pid)
+{
+	int size;
+
+	size = 0;
+	size += sprintk(buffer + size, "readahead_hits %u\n", kstat.ra_hits);
+	size += sprintk(buffer + size, "readahead_misses %u\n", kstat.ra_misses);
+	size += sprintk(buffer + size, "readahead_pages %u\n", kstat.ra_pages);
+	size += sprintk(buffer + size, "dcache_hits %u\n", kstat.dcache_hits);
+	size += sprintk(buffer + size, "dcache_misses %u\n", kstat.dcache_misses);
+	size += sprintk(buffer + size, "dcache_entries %d\n", kstat.nr_dentries);
+	size += sprintk(buffer + size, "tickless_idles %u\n", kstat.tickless_idles);
+	return size;
+}
+
 
 int data_proc_unix(char *buffer, __pid_t pid)
 {
@@ -577,6 +643,28 @@ int data_proc_dirty_background_ratio(char *buffer, __pid_t pid)
 	return sprintk(buffer, "%d\n", BUFFER_DIRTY_RATIO);
 }
 
+int data_proc_max_readahead(char *buffer, __pid_t pid)
+{
+	return sprintk(buffer, "%d\n", kstat.max_readahead);
+}
+
+int data_proc_max_readahead_write(const char *buffer, __size_t count)
+{
+	char *endptr;
+	int value;
+
+	value = strtol(buffer, &endptr, 10);
+	if(endptr == buffer || (*endptr && *endptr != '\n')) {
+		return -EINVAL;
+	}
+	/* up to 1MB */
+	if(value < 0 || value > 256) {
+		return -EINVAL;
+	}
+	kstat.max_readahead = value;
+	return 0;
+}
+
 
 /*
  * PID directory related functions
@@ -590,8 +678,8 @@ int data_proc_pid_fd(char *buffer, __pid_t pid, __ino_t inode)
 
 	size = 0;
 	ufd = inode & 0xFFF;
-	if((p = get_proc_by_pid(pid))) {
-		i = fd_table[p->fd[ufd]].inode;
+	if((p = get_proc_by_pid(pid)) && p->files && ufd < p->files->fd_max && p->files->fd[ufd]) {
+		i = fd_table[p->files->fd[ufd]].inode;
 		size = sprintk(buffer, "[%02d%02d]:%d", MAJOR(i->dev), MINOR(i->dev), i->inode);
 	}
 	return size;
@@ -835,11 +923,11 @@ int data_proc_pid_stat(char *buffer, __pid_t pid)
 		}
 
 		sigignored = sigcaught = 0;
-		for(signum = 0, mask = 1; signum < NSIG; signum++, mask <<= 1) {
-			if(p->sigaction[signum].sa_handler == SIG_IGN) {
+		for(signum = 0, mask = 1; p->sighand && signum < NSIG; signum++, mask <<= 1) {
+			if(p->sighand->action[signum].sa_handler == SIG_IGN) {
 				sigignored |= mask;
 			}
-			if(p->sigaction[signum].sa_handler == SIG_DFL) {
+			if(p->sighand->action[signum].sa_handler == SIG_DFL) {
 				sigcaught |= mask;
 			}
 		}
@@ -973,11 +1061,11 @@ int data_proc_pid_status(char *buffer, __pid_t pid)
 		size += sprintk(buffer + size, "SigPnd:\t%08x\n", p->sigpending);
 		size += sprintk(buffer + size, "SigBlk:\t%08x\n", p->sigblocked);
 		sigignored = sigcaught = 0;
-		for(signum = 0, mask = 1; signum < NSIG; signum++, mask <<= 1) {
-			if(p->sigaction[signum].sa_handler == SIG_IGN) {
+		for(signum = 0, mask = 1; p->sighand && signum < NSIG; signum++, mask <<= 1) {
+			if(p->sighand->action[signum].sa_handler == SIG_IGN) {
 				sigignored |= mask;
 			}
-			if(p->sigaction[signum].sa_handler == SIG_DFL) {
+			if(p->sighand->action[signum].sa_handler == SIG_DFL) {
 				sigcaught |= mask;
 			}
 		}
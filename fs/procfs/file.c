@@ -22,7 +22,7 @@ struct fs_operations procfs_file_fsop = {
 	procfs_file_open,
 	procfs_file_close,
 	procfs_file_read,
-	NULL,			/* write */
+	procfs_file_write,
 	NULL,			/* ioctl */
 	procfs_file_llseek,
 	NULL,			/* readdir */
@@ -60,8 +60,13 @@ struct fs_operations procfs_file_fsop = {
 
 int procfs_file_open(struct inode *i, struct fd *f)
 {
+	struct procfs_dir_entry *d;
+
 	if(f->flags & (O_WRONLY | O_RDWR | O_TRUNC | O_APPEND)) {
-		return -EINVAL;
+		/* only the entries with a write function accept writes */
+		if(!(d = get_procfs_by_inode(i)) || !d->write_fn) {
+			return -EINVAL;
+		}
 	}
 	f->offset = 0;
 	return 0;
@@ -117,6 +122,35 @@ int procfs_file_read(struct inode *i, struct fd *f, char *buffer, __size_t count
 	return total_read;
 }
 
+int procfs_file_write(struct inode *i, struct fd *f, const char *buffer, __size_t count)
+{
+	struct procfs_dir_entry *d;
+	char *buf;
+	int errno;
+
+	if(!(d = get_procfs_by_inode(i))) {
+		return -EINVAL;
+	}
+	if(!d->write_fn) {
+		return -EINVAL;
+	}
+	if(count >= PAGE_SIZE) {
+		return -EINVAL;
+	}
+	if(!(buf = (void *)kmalloc(PAGE_SIZE))) {
+		return -ENOMEM;
+	}
+
+	memcpy_b(buf, buffer, count);
+	buf[count] = 0;
+	if(!(errno = d->write_fn(buf, count))) {
+		errno = count;
+	}
+
+	kfree((unsigned int)buf);
+	return errno;
+}
+
 __loff_t procfs_file_llseek(struct inode *i, __loff_t offset)
 {
 	return offset;
@@ -8,6 +8,7 @@
 #include <fiwix/types.h>
 #include <fiwix/stat.h>
 #include <fiwix/fs.h>
+#include <fiwix/poll.h>
 #include <fiwix/fs_proc.h>
 #include <fiwix/syslog.h>
 #include <fiwix/syscalls.h>
@@ -30,6 +31,7 @@ static int kmsg_read(struct inode *i, struct fd *f, char *buffer, __size_t count
 
 static int kmsg_select(struct inode *i, struct fd *f, int flag)
 {
+	select_wait(&log_new_chars);
 	switch(flag) {
 		case SEL_R:
 			if(log_new_chars) {
@@ -59,7 +59,7 @@ int procfs_lookup(const char *name, struct inode *dir, struct inode **i_res)
 		}
 
 		ufd = atoi(name);
-		if(p->fd[ufd]) {
+		if(p->files && ufd >= 0 && ufd < p->files->fd_max && p->files->fd[ufd]) {
 			inode = (PROC_FD_INO + (pid << 12)) + ufd;
 			if(!(*i_res = iget(dir->sb, inode))) {
 				iput(dir);
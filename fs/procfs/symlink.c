@@ -126,8 +126,12 @@ int procfs_followlink(struct inode *dir, struct inode *i, struct inode **i_res)
 
 	if((i->inode & 0xF0000000) == PROC_FD_INO) {
 		ufd = i->inode & 0xFFF;
-		*i_res = fd_table[p->fd[ufd]].inode;
-		fd_table[p->fd[ufd]].inode->count++;
+		if(!p->files || ufd >= p->files->fd_max || !p->files->fd[ufd]) {
+			iput(i);
+			return -ENOENT;
+		}
+		*i_res = fd_table[p->files->fd[ufd]].inode;
+		fd_table[p->files->fd[ufd]].inode->count++;
 		iput(i);
 		return 0;
 	}
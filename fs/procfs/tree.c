@@ -18,6 +18,7 @@
 #define DIRFD	S_IFDIR | S_IRUSR | S_IXUSR		/* dr-x------ */
 #define REG	S_IFREG | S_IRUSR | S_IRGRP | S_IROTH	/* -r--r--r-- */
 #define REGUSR	S_IFREG | S_IRUSR			/* -r-------- */
+#define REGRW	S_IFREG | S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH	/* -rw-r--r-- */
 #define LNK	S_IFLNK | S_IRWXU | S_IRWXG | S_IRWXO	/* lrwxrwxrwx */
 #define LNKPID	S_IFLNK | S_IRWXU			/* lrwx------ */
 
@@ -32,6 +33,7 @@ struct procfs_dir_entry procfs_array[][PROC_ARRAY_ENTRIES + 1] = {
 	{ 3,     DIR,    3, 3, 3,  "bus", NULL },
 	{ 4,     DIR,    2, 4, 3,  "net", NULL },
 	{ 5,     DIR,    4, 5, 3,  "sys", NULL },
+	{ 25,            REG,    1, 0, 8,  "blkstats",   data_proc_blkstats },
 	{ 6,             REG,    1, 0, 9,  "buddyinfo",  data_proc_buddyinfo },
 	{ 7,             REG,    1, 0, 7,  "cmdline",    data_proc_cmdline },
 	{ 8,             REG,    1, 0, 7,  "cpuinfo",    data_proc_cpuinfo },
@@ -48,9 +50,11 @@ struct procfs_dir_entry procfs_array[][PROC_ARRAY_ENTRIES + 1] = {
 	{ 19,            REG,    1, 0, 3,  "pci",        data_proc_pci },
 	{ 20,            REG,    1, 0, 3,  "rtc",        data_proc_rtc },
 	{ 21,            LNK,    1, 0, 4,  "self",       data_proc_self },
+	{ 27,            REG,    1, 0, 8,  "slabinfo",   data_proc_slabinfo },
 	{ 22,            REG,    1, 0, 4,  "stat",       data_proc_stat },
 	{ 23,            REG,    1, 0, 6,  "uptime",     data_proc_uptime },
 	{ 24,            REG,    1, 0, 7,  "version",    data_proc_fullversion },
+	{ 26,            REG,    1, 0, 6,  "vmstat",     data_proc_vmstat },
 	{ 0, 0, 0, 0, 0, NULL, NULL }
    },
    {	/* [lev 1] /PID/ */
@@ -120,6 +124,7 @@ struct procfs_dir_entry procfs_array[][PROC_ARRAY_ENTRIES + 1] = {
 	{ 5002,  DIR,  2, 8, 1,  ".",   NULL },
 	{ 5,     DIR,  2, 3, 2,  "..",  NULL },
 	{ 8001,  REG,  1, 8, 22, "dirty_background_ratio", data_proc_dirty_background_ratio },
+	{ 8002,  REGRW, 1, 8, 13, "max-readahead", data_proc_max_readahead, data_proc_max_readahead_write },
 	{ 0, 0, 0, 0, 0, NULL, NULL }
    }
 };
@@ -20,7 +20,7 @@
 #include <fiwix/mm.h>
 
 struct mount *mount_table = NULL;
-static struct resource sync_resource = { 0, 0 };
+static struct resource sync_resource = { 0 };
 
 void superblock_lock(struct superblock *sb)
 {
@@ -95,10 +95,15 @@ void invalidate_tlb(void);
 #define STI() __asm__ __volatile__ ("sti":::"memory")
 #define NOP() __asm__ __volatile__ ("nop":::"memory")
 #define HLT() __asm__ __volatile__ ("hlt":::"memory")
+#define STI_HLT() __asm__ __volatile__ ("sti\n\thlt":::"memory")
 
 #define GET_CR2(cr2)	__asm__ __volatile__ ("movl %%cr2, %0" : "=r" (cr2));
 #define GET_ESP(esp)	__asm__ __volatile__ ("movl %%esp, %0" : "=r" (esp));
 #define SET_ESP(esp)	__asm__ __volatile__ ("movl %0, %%esp" :: "r" (esp));
+#define SET_CR3(cr3)	__asm__ __volatile__ ("movl %0, %%cr3" :: "r" (cr3) : "memory");
+#define GET_CR4(cr4)	__asm__ __volatile__ ("movl %%cr4, %0" : "=r" (cr4));
+#define SET_CR4(cr4)	__asm__ __volatile__ ("movl %0, %%cr4" :: "r" (cr4) : "memory");
+#define INVLPG(addr)	__asm__ __volatile__ ("invlpg (%0)" :: "r" (addr) : "memory");
 #define GET_GS(gs)	__asm__ __volatile__ ("movl %%gs, %0" : "=r" (gs));
 
 #define SAVE_FLAGS(flags)			\
@@ -167,6 +167,8 @@
 #define DRIVE_HAS_DATA32	0x40
 
 #define PRDT_MARK_END		0x8000
+#define PRDT_MAX_ENTRIES	512	/* entries in a page-sized PRD table */
+#define PRDT_BOUNDARY		0x10000	/* a PRD entry can't cross a 64KB boundary */
 #define WAKEUP_AND_RETURN	1
 
 /* ATA/ATAPI-4 based */
@@ -263,6 +265,7 @@ struct xfer_data {
 	int bm_cmd;
 	int cmd;
 	char *mode;
+	struct blk_request *br;		/* request being transferred */
 	int (*rw_end_fn)(struct ide *, struct xfer_data *);
 };
 
@@ -272,7 +275,7 @@ struct ata_xfer {
 	void (*copy_write_fn)(unsigned int, void *, unsigned int);
 	int write_cmd;
 	char copy_raw_factor;		/* 2 for 16bit, 4 for 32bit */
-	struct prd prd_table;		/* Physical Region Descriptor table */
+	struct prd *prd_table;		/* Physical Region Descriptor table */
 };
 
 struct ata_drv {
@@ -11,6 +11,7 @@
 #include <fiwix/types.h>
 
 #define ATA_HD_SECTSIZE		512	/* sector size (in bytes) */
+#define ATA_HD_MAX_SECTORS	128	/* max. sectors in a merged transfer */
 
 int ata_hd_open(struct inode *, struct fd *);
 int ata_hd_close(struct inode *, struct fd *);
@@ -24,6 +24,7 @@ extern struct bios_mem_map kernel_mem_map[NR_BIOS_MM_ENT];
 extern char bios_data[256];
 
 int is_addr_in_bios_map(unsigned int);
+int is_range_in_bios_map(unsigned int, unsigned int);
 void bios_map_reserve(unsigned int, unsigned int);
 void bios_map_init(struct multiboot_mmap_entry *, unsigned int);
 
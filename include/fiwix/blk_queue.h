@@ -16,6 +16,7 @@
 #define BR_COMPLETED	2
 
 #define BRF_NOBLOCK	1
+#define BRF_ASYNC	2	/* nobody waits for its completion */
 
 struct blk_request {
 	int status;
@@ -28,13 +29,20 @@ struct blk_request {
 	struct device *device;
 	int (*fn)(__dev_t, __blk_t, char *, int);
 	int left;
+	int merged;			/* requests merged behind this one */
 	struct blk_request *next;
 	struct blk_request *next_group;
 	struct blk_request *head_group;
 };
 
+extern struct kmem_cache *blk_request_cache;
+
 void add_blk_request(struct blk_request *);
 int do_blk_request(struct device *, void *, struct buffer *);
+int add_async_blk_request(struct device *, void *, struct buffer *);
 void run_blk_request(struct device *);
+int merge_blk_request(struct blk_request *, int);
+void end_blk_request(struct device *, int);
+void blk_queue_init(void);
 
 #endif /* _FIWIX_BLKQUEUE_H */
@@ -38,6 +38,9 @@ struct buffer {
 	struct buffer *first_sibling;
 	struct buffer *next_sibling;
 	struct buffer *next_retained;
+	struct page *page;		/* page-cache page holding the data */
+	struct buffer *next_in_page;	/* next buffer of the same page */
+	struct wait_queue wait;		/* processes waiting for the buffer */
 };
 extern struct buffer *buffer_table;
 extern struct buffer **buffer_hash_table;
@@ -45,8 +48,14 @@ extern struct buffer **buffer_hash_table;
 /* value to be determined during system startup */
 extern unsigned int buffer_hash_table_size;	/* size in bytes */
 
+struct buffer *getblk(__dev_t, __blk_t, int);
 int gbread(struct device *, struct blk_request *);
 struct buffer *bread(__dev_t, __blk_t, int);
+struct buffer *getblk_page(struct page *, char *, __dev_t, __blk_t, int);
+int page_buffers_busy(struct page *);
+int page_buffers_uptodate(struct page *);
+void detach_page_buffers(struct page *);
+int wait_page_buffers(struct page *);
 void bwrite(struct buffer *);
 void brelse(struct buffer *);
 void sync_buffers(__dev_t);
@@ -0,0 +1,49 @@
+/*
+ * fiwix/include/fiwix/clock.h
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#ifndef _FIWIX_CLOCK_H
+#define _FIWIX_CLOCK_H
+
+#include <fiwix/time.h>
+#include <fiwix/timer.h>
+
+#define NSEC_PER_SEC	1000000000L
+#define NSEC_PER_USEC	1000L
+#define NSEC_PER_TICK	(NSEC_PER_SEC / HZ)
+
+/* sub-tick remainder of a sleep that real-time processes busy-wait */
+#define HRTIMER_SPIN_NSEC	2000000L
+
+struct clocksource {
+	const char *name;
+	unsigned int (*read)(void);	/* nanoseconds since the last tick */
+	unsigned int resolution;	/* in nanoseconds */
+};
+
+struct hrtimer {
+	struct timespec expires;	/* monotonic time of the expiration */
+	struct callout timer;		/* fires on the tick after 'expires' */
+};
+
+extern struct clocksource *clocksource;
+
+void timespec_add(struct timespec *, const struct timespec *);
+int timespec_before(const struct timespec *, const struct timespec *);
+void get_monotonic_time(struct timespec *);
+void get_real_time(struct timespec *);
+void clock_tick(unsigned int);
+
+unsigned int hrtimer_ticks(const struct timespec *, unsigned int *);
+void hrtimer_left(const struct timespec *, struct timespec *);
+void hrtimer_spin(const struct timespec *);
+void hrtimer_start(struct hrtimer *, const struct timespec *);
+void hrtimer_forward(struct hrtimer *, const struct timespec *);
+void hrtimer_cancel(struct hrtimer *);
+void hrtimer_get_left(struct hrtimer *, struct timespec *);
+void clock_init(void);
+
+#endif /* _FIWIX_CLOCK_H */
@@ -9,7 +9,8 @@
 #define _FIWIX_CONFIG_H
 
 /* kernel tuning options */
-#define NR_PROCS		64	/* max. number of processes */
+#define NR_PROCS		64	/* initial number of process slots */
+#define MAX_PROCS		4096	/* max. number of processes */
 #define NR_CALLOUTS		NR_PROCS	/* max. active callouts */
 #define NR_MOUNT_POINTS		8	/* max. number of mounted filesystems */
 #define NR_OPENS		1024	/* max. number of opened files */
@@ -24,12 +25,20 @@
 					   size of the buffer table */
 #define NR_BUF_RECLAIM		250	/* buffers reclaimed in a single shot */
 #define BUFFER_DIRTY_RATIO	5	/* % of dirty buffers in buffer cache */
+#define WRITEBACK_MAX_BUFFERS	256	/* dirty buffers written in one batch */
+#define READAHEAD_MIN_PAGES	4	/* initial readahead window (in pages) */
+#define READAHEAD_MAX_PAGES	32	/* max. readahead window (in pages) */
 #define INODE_PERCENTAGE	5	/* % of memory for the inode table and
 					   hash table */
 #define INODE_HASH_PERCENTAGE	10	/* % of hash buckets relative to the
 					   size of the inode table */
+#define NR_DENTRIES		1024	/* max. number of cached dentries */
+#define NR_DENTRY_HASH		256	/* dentry hash buckets (power of 2) */
+#define NR_EP_HASH		64	/* epoll watchers hash buckets (power of 2) */
 
 #define MAX_PID_VALUE		32767	/* max. value for PID */
+#define NR_PID_HASH		256	/* PID hash buckets (power of 2) */
+#define NR_UID_HASH		32	/* UID hash buckets (power of 2) */
 #define SCREENS_LOG		6	/* max. number of screens in console's
 					   scroll back */
 #define MAX_SPU_NOTICES		10	/* max. number of messages on spurious
@@ -54,6 +63,7 @@
 #define CONFIG_PRINTK64
 #define CONFIG_PSAUX
 #define CONFIG_UNIX98_PTYS
+#define CONFIG_TICKLESS
 
 
 /* configuration options to help debugging */
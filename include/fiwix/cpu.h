@@ -41,6 +41,10 @@
 #define CPU_RES30	0x40000000	/* Reserved */
 #define CPU_PBE		0x80000000	/* Pending Break Enable */
 
+/* flags of the CR4 register */
+#define CR4_PSE		0x00000010	/* Page Size Extension */
+#define CR4_PGE		0x00000080	/* Page Global Enable */
+
 #define RESERVED_DESC	0x80000000	/* TLB descriptor reserved */
 
 struct cpu {
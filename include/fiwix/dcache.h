@@ -0,0 +1,34 @@
+/*
+ * fiwix/include/fiwix/dcache.h
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#ifndef _FIWIX_DCACHE_H
+#define _FIWIX_DCACHE_H
+
+#include <fiwix/types.h>
+#include <fiwix/fs.h>
+
+#define DNAME_INLINE_LEN	31	/* longer names are not cached */
+
+struct dentry {
+	__dev_t dev;			/* device of the parent directory */
+	__ino_t dir;			/* inode of the parent directory */
+	__ino_t inode;			/* inode of the name (0 = negative) */
+	int len;			/* length of the name */
+	char name[DNAME_INLINE_LEN + 1];
+	struct dentry *prev_hash;
+	struct dentry *next_hash;
+	struct dentry *prev_lru;
+	struct dentry *next_lru;
+};
+
+int dcache_lookup(const char *, struct inode *, struct inode **);
+void dcache_remove(struct inode *, const char *);
+void dcache_purge(struct inode *);
+void invalidate_dentries(__dev_t);
+void dcache_init(void);
+
+#endif /* _FIWIX_DCACHE_H */
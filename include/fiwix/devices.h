@@ -22,6 +22,16 @@
 #define CLEAR_MINOR(minors, bit) ((minors[(bit) / 32]) &= ~(1 << ((bit) % 32)))
 #define TEST_MINOR(minors, bit)	 ((minors[(bit) / 32]) & (1 << ((bit) % 32)))
 
+/* block request queue statistics */
+struct blk_stats {
+	unsigned int requests;		/* requests queued */
+	unsigned int merges;		/* requests merged into a previous one */
+	unsigned int dispatches;	/* transfers started in the driver */
+	unsigned int seeks;		/* dispatches not following the last one */
+	__dev_t last_dev;		/* device of the last dispatch */
+	__blk_t next_block;		/* block following the last dispatch */
+};
+
 struct device {
 	char *name;
 	unsigned char major;
@@ -31,6 +41,7 @@ struct device {
 	struct fs_operations *fsop;
 	void *requests_queue;
 	void *xfer_data;
+	struct blk_stats stats;
 	struct device *next;
 };
 
@@ -0,0 +1,73 @@
+/*
+ * fiwix/include/fiwix/eventpoll.h
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#ifndef _FIWIX_EVENTPOLL_H
+#define _FIWIX_EVENTPOLL_H
+
+#include <fiwix/types.h>
+#include <fiwix/fd.h>
+#include <fiwix/poll.h>
+#include <fiwix/fs_epoll.h>
+
+#define EPOLLIN		POLLIN
+#define EPOLLPRI	POLLPRI
+#define EPOLLOUT	POLLOUT
+#define EPOLLERR	POLLERR
+#define EPOLLHUP	POLLHUP
+#define EPOLLRDNORM	POLLRDNORM
+#define EPOLLWRNORM	POLLWRNORM
+#define EPOLLONESHOT	0x40000000	/* disable the file once reported */
+#define EPOLLET		0x80000000	/* edge-triggered */
+
+/* the flags that are not events */
+#define EP_PRIVATE_BITS	(EPOLLONESHOT | EPOLLET)
+
+#define EPOLL_CTL_ADD	1
+#define EPOLL_CTL_DEL	2
+#define EPOLL_CTL_MOD	3
+
+#define EP_MAX_KEYS	2	/* objects watched per file */
+
+struct epoll_event {
+	__u32 events;
+	__u64 data;
+} __attribute__((packed));
+
+/* link of an item in the hash of the watchers of an object */
+struct ep_key {
+	void *object;			/* NULL = notified by any object */
+	struct epitem *item;
+	struct ep_key *prev_hash;
+	struct ep_key *next_hash;
+};
+
+/* a file watched by an epoll instance */
+struct epitem {
+	struct eventpoll *ep;
+	struct fd *file;
+	unsigned int events;		/* requested events and EP_* flags */
+	__u64 data;			/* returned with the events */
+	int ready;			/* queued in the ready list */
+	int nr_keys;
+	struct ep_key keys[EP_MAX_KEYS];
+	struct epitem *prev;		/* items of the instance */
+	struct epitem *next;
+	struct epitem *prev_file;	/* items watching the same file */
+	struct epitem *next_file;
+	struct epitem *prev_ready;
+	struct epitem *next_ready;
+};
+
+struct epitem *ep_find(struct eventpoll *, struct fd *);
+int ep_insert(struct eventpoll *, struct fd *, struct epoll_event *);
+void ep_modify(struct epitem *, struct epoll_event *);
+void ep_remove(struct epitem *);
+int ep_poll(struct eventpoll *, struct epoll_event *, int);
+void eventpoll_release(struct fd *);
+void eventpoll_init(void);
+
+#endif /* _FIWIX_EVENTPOLL_H */
@@ -13,11 +13,13 @@
 
 #define CHECK_UFD(ufd)							\
 {									\
-	if((ufd) > (OPEN_MAX - 1) || current->fd[(ufd)] == 0) {		\
+	if((unsigned int)(ufd) >= current->files->fd_max || current->files->fd[(ufd)] == 0) {	\
 		return -EBADF;						\
 	}								\
 }									\
 
+struct epitem;
+
 extern unsigned int fd_table_size;	/* size in bytes */
 extern struct fd *fd_table;
 
@@ -31,6 +33,20 @@ struct fd {
 	__off_t offset;			/* r/w pointer position */
 #endif /* CONFIG_OFFSET64 */
 	void *private_data;		/* needed for tty driver */
+	__off_t ra_offset;		/* offset of the next sequential read */
+	__off_t ra_end;			/* end of the pages read ahead */
+	int ra_pages;			/* readahead window (in pages) */
+	struct epitem *epitems;		/* epoll instances watching it */
+};
+
+/* descriptor table of a process, shared by the clone()s with CLONE_FILES */
+struct files {
+	int count;			/* processes using it */
+	unsigned short int *fd;		/* descriptors (fd_table indexes) */
+	unsigned char *fd_flags;
+	unsigned int *fd_bitmap;	/* descriptors in use */
+	unsigned int fd_max;		/* size of the descriptor table */
+	unsigned int fd_next;		/* lowest descriptor that may be free */
 };
 
 #endif /* _FIWIX_FS_H */
@@ -11,7 +11,7 @@
 #include <fiwix/types.h>
 #include <fiwix/limits.h>
 
-#define NR_FILESYSTEMS		6	/* supported filesystems */
+#define NR_FILESYSTEMS		7	/* supported filesystems */
 
 /* special device numbers for nodev filesystems */
 enum {
@@ -20,6 +20,7 @@ enum {
 	PIPE_DEV,
 	PROC_DEV,
 	SOCK_DEV,
+	EPOLL_DEV,
 };
 
 struct filesystems {
@@ -152,6 +153,7 @@ int iso9660_init(void);
 int procfs_file_open(struct inode *, struct fd *);
 int procfs_file_close(struct inode *, struct fd *);
 int procfs_file_read(struct inode *, struct fd *, char *, __size_t);
+int procfs_file_write(struct inode *, struct fd *, const char *, __size_t);
 __loff_t procfs_file_llseek(struct inode *, __loff_t);
 int procfs_dir_open(struct inode *, struct fd *);
 int procfs_dir_close(struct inode *, struct fd *);
@@ -181,6 +183,15 @@ int sockfs_read_superblock(__dev_t, struct superblock *);
 int sockfs_init(void);
 #endif /* CONFIG_NET */
 
+/* epollfs prototypes */
+int epollfs_close(struct inode *, struct fd *);
+__loff_t epollfs_llseek(struct inode *, __loff_t);
+int epollfs_select(struct inode *, struct fd *, int);
+int epollfs_ialloc(struct inode *, int);
+void epollfs_ifree(struct inode *);
+int epollfs_read_superblock(__dev_t, struct superblock *);
+int epollfs_init(void);
+
 #ifdef CONFIG_UNIX98_PTYS
 /* devpts prototypes */
 int devpts_dir_open(struct inode *, struct fd *);
@@ -19,6 +19,7 @@
 #include <fiwix/fs_iso9660.h>
 #include <fiwix/fs_proc.h>
 #include <fiwix/fs_sock.h>
+#include <fiwix/fs_epoll.h>
 
 #define BPS			512	/* bytes per sector */
 #define BLKSIZE_1K		1024	/* 1KB block size */
@@ -87,6 +88,7 @@ struct inode {
 	struct inode *next_hash;
 	struct inode *prev_free;
 	struct inode *next_free;
+	struct wait_queue wait;		/* processes waiting for the inode */
 	union {
 #ifdef CONFIG_FS_MINIX
 		struct minix_i_info minix;
@@ -98,6 +100,7 @@ struct inode {
 #ifdef CONFIG_NET
 		struct sockfs_inode sockfs;
 #endif /* CONFIG_NET */
+		struct epollfs_inode epollfs;
 	} u;
 };
 extern struct inode *inode_table;
@@ -253,6 +256,9 @@ int get_new_fd(struct inode *);
 void release_fd(unsigned int);
 int get_new_user_fd(int);
 void release_user_fd(int);
+int dup_user_fd_table(struct proc *, struct proc *);
+int unshare_user_fd_table(void);
+void free_user_fd_table(struct proc *);
 void fd_init(void);
 
 void free_name(const char *);
@@ -0,0 +1,30 @@
+/*
+ * fiwix/include/fiwix/fs_epoll.h
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#ifndef _FIWIX_FS_EPOLL_H
+#define _FIWIX_FS_EPOLL_H
+
+#include <fiwix/wait.h>
+
+extern struct fs_operations epollfs_fsop;
+
+struct epitem;
+
+/* an epoll instance */
+struct eventpoll {
+	struct epitem *items;		/* files watched */
+	struct epitem *ready_head;	/* files to be checked */
+	struct epitem *ready_tail;
+	unsigned int nr_ready;
+	struct wait_queue wait;		/* processes in epoll_wait() */
+};
+
+struct epollfs_inode {
+	struct eventpoll ep;
+};
+
+#endif /* _FIWIX_FS_EPOLL_H */
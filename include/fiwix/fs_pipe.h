@@ -8,6 +8,8 @@
 #ifndef _FIWIX_FS_PIPE_H
 #define _FIWIX_FS_PIPE_H
 
+#include <fiwix/wait.h>
+
 extern struct fs_operations pipefs_fsop;
 
 struct pipefs_inode {
@@ -16,6 +18,8 @@ struct pipefs_inode {
 	unsigned int i_writeoff;	/* offset for writes */
 	unsigned int i_readers;		/* number of readers */
 	unsigned int i_writers;		/* number of writers */
+	struct wait_queue i_read_wait;	/* readers waiting for data */
+	struct wait_queue i_write_wait;	/* writers waiting for room */
 };
 
 #endif /* _FIWIX_FS_PIPE_H */
@@ -20,7 +20,7 @@
 #define PROC_FD_INO		0x50000000	/* base for FD inodes */
 #define PROC_FD_LEV		2	/* array level for FDs */
 
-#define PROC_ARRAY_ENTRIES	25
+#define PROC_ARRAY_ENTRIES	28
 
 enum pid_dir_inodes {
 	PROC_PID_FD = PROC_PID_INO + 1001,
@@ -48,11 +48,13 @@ struct procfs_dir_entry {
 	unsigned short int name_len;
 	char *name;
 	int (*data_fn)(char *, __pid_t);
+	int (*write_fn)(const char *, __size_t);	/* only writable entries */
 };
 
 extern struct procfs_dir_entry procfs_array[][PROC_ARRAY_ENTRIES + 1];
 extern struct fs_operations procfs_kmsg_fsop;
 
+int data_proc_blkstats(char *, __pid_t);
 int data_proc_buddyinfo(char *, __pid_t);
 int data_proc_cmdline(char *, __pid_t);
 int data_proc_cpuinfo(char *, __pid_t);
@@ -68,6 +70,7 @@ int data_proc_partitions(char *, __pid_t);
 int data_proc_pci(char *, __pid_t);
 int data_proc_rtc(char *, __pid_t);
 int data_proc_self(char *, __pid_t);
+int data_proc_slabinfo(char *, __pid_t);
 int data_proc_stat(char *, __pid_t);
 int data_proc_uptime(char *, __pid_t);
 int data_proc_fullversion(char *, __pid_t);
@@ -83,7 +86,10 @@ int data_proc_inodenr(char *, __pid_t);
 int data_proc_osrelease(char *, __pid_t);
 int data_proc_ostype(char *, __pid_t);
 int data_proc_version(char *, __pid_t);
+int data_proc_vmstat(char *, __pid_t);
 int data_proc_dirty_background_ratio(char *, __pid_t);
+int data_proc_max_readahead(char *, __pid_t);
+int data_proc_max_readahead_write(const char *, __size_t);
 
 /* PID related functions */
 int data_proc_pid_fd(char *, __pid_t, __ino_t);
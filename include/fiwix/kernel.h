@@ -13,6 +13,7 @@
 
 #define QEMU_DEBUG_PORT		0xE9	/* for Bochs-style debug console */
 #define BUDDY_MAX_LEVEL		7
+#define BUDDY_HIGH_MAX_ORDER	6
 
 #define KERN_EMERG	"<0>"		/* system is unusable */
 #define KERN_ALERT	"<1>"		/* action must be taken immediately */
@@ -96,6 +97,7 @@ struct kernel_stat {
 	int max_dirty_buffers;		/* max. number of dirty buffers */
 	int dirty_buffers;		/* dirty buffers (in KB) */
 	int nr_dirty_buffers;		/* current dirty buffers */
+	int max_readahead;		/* max. readahead window (in pages) */
 	unsigned int random_seed;	/* next random seed */
 	int pages_reclaimed;		/* last pages reclaimed from buffer */
 	int nr_flocks;			/* current allocated file locks */
@@ -105,6 +107,23 @@ struct kernel_stat {
 	int buddy_low_num_pages;	/* number of pages used */
 	int buddy_low_mem_requested;	/* total memory requested (in bytes) */
 
+	/* buddy_high algorithm statistics */
+	int buddy_high_count[BUDDY_HIGH_MAX_ORDER + 1];
+	int buddy_high_free[BUDDY_HIGH_MAX_ORDER + 1];
+	int buddy_high_num_pages;	/* number of pages used */
+
+	/* readahead statistics */
+	unsigned int ra_hits;		/* sequential pages already read ahead */
+	unsigned int ra_misses;		/* sequential pages not read ahead */
+	unsigned int ra_pages;		/* pages requested by readahead */
+
+	/* dentry cache statistics */
+	unsigned int dcache_hits;	/* lookups resolved by the dcache */
+	unsigned int dcache_misses;	/* lookups sent to the filesystem */
+	int nr_dentries;		/* current cached dentries */
+
+	unsigned int tickless_idles;	/* periodic ticks stopped by idle */
+
 	int mount_points;		/* number of fs currently mounted */
 };
 extern struct kernel_stat kstat;
@@ -23,9 +23,14 @@
 #define PAGE_ALIGN(addr)	(((addr) + (PAGE_SIZE - 1)) & PAGE_MASK)
 #define PT_ENTRIES		(PAGE_SIZE / sizeof(unsigned int))
 #define PD_ENTRIES		(PAGE_SIZE / sizeof(unsigned int))
+#define PGDIR_SIZE		(PAGE_SIZE * 1024)	/* mapped by a Page Directory entry */
+#define FAULT_AROUND_PAGES	16	/* window of cached pages mapped per fault */
+#define TLB_FLUSH_MAX_PAGES	32	/* bigger ranges flush the whole TLB */
 
 #define PAGE_LOCKED		0x001
 #define PAGE_BUDDYLOW		0x010	/* page belongs to buddy_low */
+#define PAGE_BUDDYHIGH		0x020	/* page belongs to buddy_high */
+#define PAGE_BHFREE		0x040	/* first page of a free buddy_high block */
 #define PAGE_RESERVED		0x100	/* kernel, BIOS address, ... */
 #define PAGE_COW		0x200	/* marked for Copy-On-Write */
 
@@ -44,6 +49,8 @@ struct page {
 	__off_t offset;		/* file offset */
 	__dev_t dev;		/* device where file resides */
 	char *data;		/* page contents */
+	int order;		/* order of the buddy_high block */
+	struct buffer *buffers;	/* buffers mapped onto the page */
 	struct page *prev_hash;
 	struct page *next_hash;
 	struct page *prev_free;
@@ -74,6 +81,7 @@ static const unsigned int bl_blocksize[] = {
 
 struct bl_head {
 	unsigned char level;	/* size class (exponent of the power of 2) */
+	unsigned char free;	/* block is in its free list */
 	struct bl_head *prev;
 	struct bl_head *next;
 };
@@ -82,6 +90,50 @@ unsigned int bl_malloc(__size_t);
 void bl_free(unsigned int);
 void buddy_low_init(void);
 
+/* buddy_high.c */
+unsigned int bh_malloc(__size_t);
+void bh_free(unsigned int);
+int bh_reap(void);
+void buddy_high_init(void);
+
+/* slab.c */
+#define SLAB_COLOR_ALIGN	32	/* color step (a cache line) */
+
+struct slab {
+	struct kmem_cache *cache;	/* cache owning this slab */
+	struct slab *prev;
+	struct slab *next;
+	unsigned int objs;		/* address of the first object */
+	int inuse;			/* objects allocated */
+	int free;			/* index of the first free object */
+};
+
+struct kmem_cache {
+	const char *name;
+	int size;			/* size requested for the objects */
+	int objsize;			/* size of the objects (aligned) */
+	int objs_per_slab;		/* objects in a slab */
+	int offset;			/* offset of the first object */
+	int colors;			/* number of different colors */
+	int color_next;			/* color of the next slab */
+	void (*ctor)(void *);		/* object constructor */
+	struct slab *slabs_partial;	/* slabs with free objects */
+	struct slab *slabs_full;	/* slabs without free objects */
+	struct slab *slabs_free;	/* slabs with all objects free */
+	int nr_slabs;			/* number of slabs */
+	int nr_active;			/* objects allocated */
+	unsigned int nr_allocs;		/* allocations since boot */
+	unsigned int nr_frees;		/* frees since boot */
+	struct kmem_cache *next;
+};
+extern struct kmem_cache *kmem_cache_head;
+
+struct kmem_cache *kmem_cache_create(const char *, int, void (*)(void *));
+unsigned int kmem_cache_alloc(struct kmem_cache *);
+void kmem_cache_free(struct kmem_cache *, unsigned int);
+int kmem_cache_reap(void);
+void kmem_cache_init(void);
+
 /* alloc.c */
 unsigned int kmalloc(__size_t);
 void kfree(unsigned int);
@@ -90,14 +142,17 @@ void kfree(unsigned int);
 void page_lock(struct page *);
 void page_unlock(struct page *);
 struct page *get_free_page(void);
+struct page *get_free_pages(int);
+void get_free_areas(int *, int);
 struct page *search_page_hash(struct inode *, __off_t);
+struct page *get_cached_page(struct inode *, __off_t);
 void release_page(struct page *);
 int is_valid_page(int);
 void invalidate_inode_pages(struct inode *);
-void update_page_cache(struct inode *, __off_t, const char *, int);
 int write_page(struct page *, struct inode *, __off_t, unsigned int);
 int bread_page(struct page *, struct inode *, __off_t, char, char);
 int file_read(struct inode *, struct fd *, char *, __size_t);
+int file_write(struct inode *, struct fd *, const char *, __size_t);
 void reserve_pages(unsigned int, unsigned int);
 void page_init(int);
 
@@ -111,6 +166,8 @@ int free_page_tables(struct proc *);
 unsigned int map_page(struct proc *, unsigned int, unsigned int, unsigned int);
 unsigned int map_page_flags(struct proc *, unsigned int, unsigned int, unsigned int, int);
 int unmap_page(unsigned int);
+void invalidate_tlb_page(unsigned int);
+void invalidate_tlb_range(unsigned int, unsigned int);
 void mem_init(void);
 void mem_stats(void);
 
@@ -60,6 +60,8 @@ struct mmap {
 void show_vma_regions(struct proc *);
 void free_vma_pages(struct vma *, unsigned int, __size_t);
 void release_binary(void);
+void release_vfork(unsigned int *);
+void detach_vfork(struct proc *);
 struct vma *find_vma_region(unsigned int);
 struct vma *find_vma_intersection(unsigned int, unsigned int);
 int expand_heap(unsigned int);
@@ -68,4 +70,13 @@ int do_mmap(struct inode *, unsigned int, unsigned int, unsigned int, unsigned i
 int do_munmap(unsigned int, __size_t);
 int do_mprotect(struct vma *, unsigned int, __size_t, int);
 
+/* vma.c */
+void vma_tree_update(struct proc *, struct vma *);
+void vma_tree_insert(struct proc *, struct vma *);
+void vma_tree_remove(struct proc *, struct vma *);
+void vma_tree_build(struct proc *);
+struct vma *vma_tree_find(struct proc *, unsigned int);
+struct vma *vma_tree_find_intersection(struct proc *, unsigned int, unsigned int);
+unsigned int vma_tree_find_gap(struct proc *, unsigned int, unsigned int);
+
 #endif /* _FIWIX_MMAN_H */
@@ -13,6 +13,7 @@
 #include <fiwix/types.h>
 #include <fiwix/socket.h>
 #include <fiwix/fd.h>
+#include <fiwix/wait.h>
 #include <fiwix/net/unix.h>
 #include <fiwix/net/ipv4.h>
 
@@ -45,6 +46,7 @@ struct socket {
 	int queue_limit;		/* max. number of pending connections */
 	struct socket *queue_head;	/* first connection in queue */
 	struct socket *next_queue;	/* next connection in queue */
+	struct wait_queue wait;		/* waiting for a connection */
 	union {
 		struct unix_info unix_info;
 		struct ipv4_info ipv4_info;
@@ -12,6 +12,7 @@
 
 #include <fiwix/types.h>
 #include <fiwix/net/packet.h>
+#include <fiwix/wait.h>
 
 /* AF_UNIX */
 struct unix_info {
@@ -27,6 +28,7 @@ struct unix_info {
 	struct packet *packet_queue;
 	struct unix_info *peer;
 	struct unix_info *next;
+	struct wait_queue wait;		/* waiting for data or room */
 };
 
 extern struct unix_info *unix_socket_head;
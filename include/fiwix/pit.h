@@ -46,6 +46,7 @@
 void pit_beep_on(void);
 void pit_beep_off(unsigned int);
 int pit_getcounter0(void);
+void pit_oneshot(unsigned short int);
 void pit_init(unsigned short int);
 
 #endif /* _FIWIX_PIT_H */
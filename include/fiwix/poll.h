@@ -0,0 +1,34 @@
+/*
+ * fiwix/include/fiwix/poll.h
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#ifndef _FIWIX_POLL_H
+#define _FIWIX_POLL_H
+
+#include <fiwix/types.h>
+#include <fiwix/fd.h>
+
+#define POLLIN		0x0001		/* there is data to read */
+#define POLLPRI		0x0002		/* there is urgent data to read */
+#define POLLOUT		0x0004		/* writing now will not block */
+#define POLLERR		0x0008		/* error condition */
+#define POLLHUP		0x0010		/* hung up */
+#define POLLNVAL	0x0020		/* invalid request: fd not open */
+#define POLLRDNORM	0x0040		/* normal data may be read */
+#define POLLWRNORM	0x0100		/* writing now will not block */
+
+struct pollfd {
+	int fd;				/* file descriptor */
+	short int events;		/* requested events */
+	short int revents;		/* returned events */
+};
+
+unsigned int poll_file(struct fd *, unsigned int);
+void select_wait(void *);
+void select_notify(void *);
+int do_poll(struct pollfd *, unsigned int);
+
+#endif /* _FIWIX_POLL_H */
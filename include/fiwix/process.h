@@ -20,6 +20,12 @@ struct vma {
 	void *object;		/* generic pointer (currently only for shm) */
 	struct vma *prev;
 	struct vma *next;
+	struct vma *parent;	/* vma tree (sorted by start address) */
+	struct vma *left;
+	struct vma *right;
+	int height;
+	unsigned int gap;	/* free space before this region */
+	unsigned int max_gap;	/* biggest gap in this subtree */
 };
 
 #include <fiwix/config.h>
@@ -28,7 +34,11 @@ struct vma {
 #include <fiwix/limits.h>
 #include <fiwix/sigcontext.h>
 #include <fiwix/time.h>
+#include <fiwix/timer.h>
+#include <fiwix/clock.h>
+#include <fiwix/wait.h>
 #include <fiwix/resource.h>
+#include <fiwix/fd.h>
 #include <fiwix/tty.h>
 
 #define IDLE		0		/* PID of idle */
@@ -41,12 +51,28 @@ struct vma {
 #define PF_PEXEC	0x00000002	/* has performed a sys_execve() */
 #define PF_USEREAL	0x00000004	/* use real UID in permission checks */
 #define PF_NOTINTERRUPT	0x00000008	/* non-interruptible sleeping */
+#define PF_EXCLUSIVE	0x00000010	/* woken up alone (wait queues) */
+#define PF_VFORK	0x00000020	/* runs in the address space of its parent */
+
+/* flags of sys_clone() */
+#define CSIGNAL		0x000000FF	/* signal sent to the parent on exit */
+#define CLONE_VM	0x00000100	/* share the address space */
+#define CLONE_FS	0x00000200	/* share root, pwd and umask */
+#define CLONE_FILES	0x00000400	/* share the file descriptors */
+#define CLONE_SIGHAND	0x00000800	/* share the signal handlers */
+#define CLONE_VFORK	0x00004000	/* suspend the parent until exec or exit */
 
 #define MMAP_START	0x40000000	/* mmap()s start at 1GB */
 #define IS_SUPERUSER	(current->euid == 0)
 
 #define IO_BITMAP_SIZE	8192		/* 8192*8bit = all I/O address space */
 
+/* IDs by which the processes are hashed */
+#define PIDTYPE_PID	0
+#define PIDTYPE_PGID	1
+#define PIDTYPE_SID	2
+#define NR_PIDTYPES	3
+
 #define PG_LEADER(p)	((p)->pid == (p)->pgid)
 #define SESS_LEADER(p)	((p)->pid == (p)->pgid && (p)->pid == (p)->sid)
 
@@ -60,6 +86,7 @@ extern char any_key_to_reboot;
 extern int nr_processes;
 extern __pid_t lastpid;
 extern struct proc *proc_table_head;
+extern struct kmem_cache *vma_cache;
 
 struct binargs {
 	unsigned int page[ARG_MAX];
@@ -99,12 +126,31 @@ struct i386tss {
 	unsigned int ldt;
 	unsigned short int debug_trap;
 	unsigned short int io_bitmap_addr;
+};
+
+/*
+ * The I/O permission bitmap must follow the TSS in memory, so the processes
+ * that call sys_ioperm() get a bigger TSS of their own. The rest use the one
+ * in their proc slot, which has no bitmap at all (all ports are denied).
+ */
+struct io_tss {
+	struct i386tss tss;
 	unsigned char io_bitmap[IO_BITMAP_SIZE + 1];
 };
 
+/* signal handlers of a process, shared by the clone()s with CLONE_SIGHAND */
+struct sighand {
+	int count;			/* processes using it */
+	struct sigaction action[NSIG];
+};
+
 struct proc {
 	struct i386tss tss;
+	struct io_tss *io_tss;		/* TSS with an I/O permission bitmap */
 	struct proc *ppid;		/* pointer to parent process */
+	struct proc *first_child;	/* youngest child */
+	struct proc *prev_sibling;	/* younger sibling */
+	struct proc *next_sibling;	/* older sibling */
 	__pid_t pid;			/* process ID */
 	__pid_t pgid;			/* process group ID */
 	__pid_t sid;			/* session ID */
@@ -115,17 +161,20 @@ struct proc {
 	int state;			/* process state */
 	int priority;
 	int cpu_count;			/* time of process running */
+	int policy;			/* scheduling policy */
+	int rt_priority;		/* real-time priority */
 	__time_t start_time;
 	int exit_code;	
 	void *sleep_address;
+	struct wait_queue *sleep_queue;	/* wait queue where it sleeps */
+	struct wait_queue vfork_wait;	/* waiting for a vfork()ed child */
 	unsigned short int uid;		/* real user ID */
 	unsigned short int gid;		/* real group ID */
 	unsigned short int euid;	/* effective user ID */
 	unsigned short int egid;	/* effective group ID */
 	unsigned short int suid;	/* saved user ID */
 	unsigned short int sgid;	/* saved group ID */
-	unsigned short int fd[OPEN_MAX];
-	unsigned char fd_flags[OPEN_MAX];
+	struct files *files;		/* descriptor table */
 	struct inode *root;
 	struct inode *pwd;		/* process working directory */
 	unsigned int entry_address;
@@ -137,20 +186,24 @@ struct proc {
 	char **envp;
 	char pidstr[5];			/* PID number converted to string */
 	struct vma *vma_table;		/* virtual memory-map addresses */
+	struct vma *vma_root;		/* vma_table indexed as a tree */
+	struct vma *vma_last;		/* last vma found */
 	unsigned int brk_lower;		/* lower limit of the heap section */
 	unsigned int brk;		/* current limit of the heap */
 	__sigset_t sigpending;
 	__sigset_t sigblocked;
 	__sigset_t sigexecuting;
-	struct sigaction sigaction[NSIG];
+	struct sighand *sighand;	/* signal handlers */
 	struct sigcontext sc[NSIG];	/* each signal has its own context */
 	unsigned int sp;		/* current process' stack frame */
 	struct rusage usage;		/* process resource usage */
 	struct rusage cusage;		/* children resource usage */
-	unsigned int it_real_interval, it_real_value;
+	struct timeval it_real_interval;
+	struct hrtimer it_real_timer;	/* ITIMER_REAL expiration */
 	unsigned int it_virt_interval, it_virt_value;
 	unsigned int it_prof_interval, it_prof_value;
 	unsigned int timeout;
+	struct callout timeout_timer;	/* sleep timeout expiration */
 	struct rlimit rlim[RLIM_NLIMITS];
 	unsigned int rss;
 	__mode_t umask;
@@ -164,6 +217,12 @@ struct proc {
 	struct proc *next_sleep;
 	struct proc *prev_run;
 	struct proc *next_run;
+	struct prio_array *rq_array;	/* run queue array of the process */
+	int rq_level;			/* level in the run queue array */
+	struct proc *prev_rq;
+	struct proc *next_rq;
+	struct proc *prev_hash[NR_PIDTYPES];	/* PID, PGID and SID hashes */
+	struct proc *next_hash[NR_PIDTYPES];
 };
 
 extern struct proc *current;
@@ -180,13 +239,30 @@ __pid_t remove_zombie(struct proc *);
 int is_orphaned_pgrp(__pid_t);
 struct proc *get_proc_free(void);
 void release_proc(struct proc *);
+int dup_sighand_table(struct proc *, struct proc *);
+void free_sighand_table(struct proc *);
 int get_unused_pid(void);
 struct proc *get_proc_by_pid(__pid_t);
+struct proc *first_in_pgrp(__pid_t);
+struct proc *next_in_pgrp(struct proc *);
+struct proc *first_in_session(__pid_t);
+struct proc *next_in_session(struct proc *);
+void hash_proc(struct proc *);
+void set_pgid(struct proc *, __pid_t);
+void set_sid(struct proc *, __pid_t);
+void add_child(struct proc *, struct proc *);
+void remove_child(struct proc *);
+int get_uid_procs(__uid_t);
+int add_uid_proc(__uid_t);
+void del_uid_proc(__uid_t);
+int set_proc_uid(struct proc *, __uid_t);
 
 struct proc *kernel_process(const char *, int (*fn)(void));
 void proc_slot_init(struct proc *);
 void proc_init(void);
 
+int do_fork(unsigned int, unsigned int, struct sigcontext *);
+
 int elf_load(struct inode *, struct binargs *, struct sigcontext *, char *);
 int script_load(char *, char *, char *);
 
@@ -24,6 +24,28 @@
 #define PROC_UNINTERRUPTIBLE	2
 
 #define DEF_PRIORITY	(20 * HZ / 100)	/* 200ms of time slice */
+#define RR_TIMESLICE	(10 * HZ / 100)	/* 100ms of time slice (SCHED_RR) */
+
+/* scheduling policies */
+#define SCHED_OTHER	0
+#define SCHED_FIFO	1
+#define SCHED_RR	2
+
+#define MIN_RT_PRIO	1		/* lowest real-time priority */
+#define MAX_RT_PRIO	99		/* highest real-time priority */
+
+#define NR_RUN_LEVELS	128		/* levels in a priority array */
+#define RUN_BITMAP_SIZE	(NR_RUN_LEVELS / 32)
+
+struct sched_param {
+	int sched_priority;
+};
+
+struct prio_array {
+	unsigned int bitmap[RUN_BITMAP_SIZE];	/* non-empty levels */
+	struct proc *head[NR_RUN_LEVELS];
+	struct proc *tail[NR_RUN_LEVELS];
+};
 
 extern int need_resched;
 
@@ -48,7 +70,11 @@ extern unsigned int avenrun[3];		/* Load averages */
 /* ------------------------------------------------------------------------ */
 
 
+void enqueue_proc(struct proc *);
+void dequeue_proc(struct proc *);
 void do_sched(void);
+void yield(void);
+void set_scheduler(struct proc *, int, int);
 void set_tss(struct proc *);
 void sched_init(void);
 
@@ -22,6 +22,8 @@
 #define PAGE_PRESENT	0x001	/* Present */
 #define PAGE_RW		0x002	/* Read/Write */
 #define PAGE_USER	0x004	/* User */
+#define PAGE_PSE	0x080	/* Page Size (4MB page in a Page Directory) */
+#define PAGE_GLOBAL	0x100	/* Global (kept in TLB across CR3 loads) */
 #define PAGE_NOALLOC	0x200	/* No Page Allocated (OS managed) */
 
 #ifndef ASM_FILE
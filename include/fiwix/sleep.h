@@ -19,13 +19,17 @@ extern struct proc *proc_run_head;
 
 struct resource {
 	char locked;
-	char wanted;
+	struct wait_queue wait;		/* processes waiting for the lock */
 };
 
 void runnable(struct proc *);
 void not_runnable(struct proc *, int);
 int sleep(void *, int);
 void wakeup(void *);
+int sleep_on(struct wait_queue *, int);
+int sleep_on_exclusive(struct wait_queue *, int);
+void wake_up(struct wait_queue *);
+void wake_up_all(struct wait_queue *);
 void wakeup_proc(struct proc *);
 
 void lock_resource(struct resource *);
@@ -17,6 +17,10 @@
 #define MIN(a,b)	((a) < (b) ? (a) : (b))
 #define MAX(a,b)	((a) > (b) ? (a) : (b))
 
+#define STRING_OPS_GENERIC	0	/* plain C dword loops */
+#define STRING_OPS_REP		1	/* 'rep movsl' and 'rep stosl' */
+#define STRING_OPS_THRESHOLD	16	/* smaller sizes are moved bytewise */
+
 void swap_asc_word(char *, int);
 int strcmp(const char *, const char *);
 int strncmp(const char *, const char *, __ssize_t);
@@ -32,6 +36,7 @@ char *get_basename(const char *);
 char *remove_trailing_slash(char *);
 int is_dir(const char *);
 int atoi(const char *);
+void set_string_ops(int);
 void memcpy_b(void *, const void *, unsigned int);
 void memcpy_w(void *, const void *, unsigned int);
 void memcpy_l(void *, const void *, unsigned int);
@@ -24,6 +24,9 @@
 #include <fiwix/sigcontext.h>
 #include <fiwix/mman.h>
 #include <fiwix/ipc.h>
+#include <fiwix/sched.h>
+#include <fiwix/poll.h>
+#include <fiwix/eventpoll.h>
 
 #define NR_SYSCALLS	(sizeof(syscall_table) / sizeof(unsigned int))
 
@@ -151,6 +154,11 @@ int sys_sigreturn(unsigned int, int, int, int, int, int, struct sigcontext *);
 #else
 int sys_sigreturn(unsigned int, int, int, int, int, struct sigcontext *);
 #endif /* CONFIG_SYSCALL_6TH_ARG */
+#ifdef CONFIG_SYSCALL_6TH_ARG
+int sys_clone(unsigned int, unsigned int, int, int, int, int, struct sigcontext *);
+#else
+int sys_clone(unsigned int, unsigned int, int, int, int, struct sigcontext *);
+#endif /* CONFIG_SYSCALL_6TH_ARG */
 int sys_setdomainname(const char *, int);
 int sys_newuname(struct new_utsname *);
 int sys_mprotect(unsigned int, __size_t, int);
@@ -168,9 +176,23 @@ int sys_readv(int, struct iovec *, int);
 int sys_writev(int, struct iovec *, int);
 int sys_getsid(__pid_t);
 int sys_fdatasync(int);
+int sys_sched_setparam(__pid_t, const struct sched_param *);
+int sys_sched_getparam(__pid_t, struct sched_param *);
+int sys_sched_setscheduler(__pid_t, int, const struct sched_param *);
+int sys_sched_getscheduler(__pid_t);
+int sys_sched_yield(void);
+int sys_sched_get_priority_max(int);
+int sys_sched_get_priority_min(int);
+int sys_sched_rr_get_interval(__pid_t, struct timespec *);
 int sys_nanosleep(const struct timespec *, struct timespec *);
+int sys_poll(struct pollfd *, unsigned int, int);
 int sys_chown(const char *, __uid_t, __gid_t);
 int sys_getcwd(char *, __size_t);
+#ifdef CONFIG_SYSCALL_6TH_ARG
+int sys_vfork(int, int, int, int, int, int, struct sigcontext *);
+#else
+int sys_vfork(int, int, int, int, int, struct sigcontext *);
+#endif /* CONFIG_SYSCALL_6TH_ARG */
 #ifdef CONFIG_MMAP2
 int sys_mmap2(unsigned int, unsigned int, unsigned int, unsigned int, int, unsigned int);
 #endif /* CONFIG_MMAP2 */
@@ -182,6 +204,12 @@ int sys_fstat64(unsigned int, struct stat64 *);
 int sys_chown32(const char *, unsigned int, unsigned int);
 int sys_getdents64(unsigned int, struct dirent64 *, unsigned int);
 int sys_fcntl64(unsigned int, int, unsigned int);
+int sys_epoll_create(int);
+int sys_epoll_ctl(int, int, int, struct epoll_event *);
+int sys_epoll_wait(int, struct epoll_event *, int, int);
+int sys_clock_gettime(int, struct timespec *);
+int sys_clock_getres(int, struct timespec *);
 int sys_utimes(const char *, struct timeval times[2]);
+int sys_ppoll(struct pollfd *, unsigned int, const struct timespec *, const __sigset_t *, __size_t);
 
 #endif /* _FIWIX_SYSCALLS_H */
@@ -12,6 +12,9 @@
 #define ITIMER_VIRTUAL	1
 #define ITIMER_PROF	2
 
+#define CLOCK_REALTIME	0
+#define CLOCK_MONOTONIC	1
+
 struct timespec {
 	int tv_sec;		/* seconds since 00:00:00, 1 Jan 1970 UTC */
 	int tv_nsec;		/* nanoseconds (1000000000ns = 1sec) */
@@ -46,6 +49,7 @@ struct tm {
 
 unsigned int tv2ticks(const struct timeval *);
 void ticks2tv(int, struct timeval *);
+void getitimer_real(struct itimerval *);
 int setitimer(int, const struct itimerval *, struct itimerval *);
 unsigned int mktime(struct tm *);
 
@@ -8,6 +8,7 @@
 #ifndef _FIWIX_TIMER_H
 #define _FIWIX_TIMER_H
 
+#include <fiwix/config.h>
 #include <fiwix/types.h>
 #include <fiwix/sigcontext.h>
 
@@ -27,9 +28,11 @@
 #define INFINITE_WAIT	0xFFFFFFFF
 
 struct callout {
-	int expires;
+	unsigned int expires;		/* tick at which it expires */
 	void (*fn)(unsigned int);
 	unsigned int arg;
+	struct callout **list;		/* list where it's queued (or NULL) */
+	struct callout *prev;
 	struct callout *next;
 };
 
@@ -40,12 +43,20 @@ struct callout_req {
 
 void add_callout(struct callout_req *, unsigned int);
 void del_callout(struct callout_req *);
+void add_timer(struct callout *, unsigned int);
+void del_timer(struct callout *);
+unsigned int timer_left(struct callout *);
+void start_timeout(unsigned int);
+unsigned int stop_timeout(void);
+#ifdef CONFIG_TICKLESS
+void tickless_enter(void);
+void tickless_exit(void);
+#endif /* CONFIG_TICKLESS */
 void irq_timer(int, struct sigcontext *);
 void irq_timer_bh(struct sigcontext *);
 void do_callouts_bh(struct sigcontext *);
 void get_system_time(void);
 void set_system_time(__time_t);
-int gettimeoffset(void);
 void timer_init(void);
 
 #endif /* _FIWIX_TIMER_H */
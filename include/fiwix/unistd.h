@@ -133,7 +133,7 @@
 #define SYS_ipc			117
 #define SYS_fsync		118
 #define SYS_sigreturn		119
-/* #define SYS_clone */
+#define SYS_clone		120
 #define SYS_setdomainname	121
 #define SYS_newuname		122
 /* #define SYS_modify_ldt */
@@ -167,14 +167,14 @@
 /* #define SYS_munlock */
 /* #define SYS_mlockall */
 /* #define SYS_munlockall */
-/* #define SYS_sched_setparam */
-/* #define SYS_sched_getparam */
-/* #define SYS_sched_setscheduler */
-/* #define SYS_sched_getscheduler */
-/* #define SYS_sched_yield */
-/* #define SYS_sched_get_priority_max */
-/* #define SYS_sched_get_priority_min */
-/* #define SYS_sched_rr_get_interval */
+#define SYS_sched_setparam	154
+#define SYS_sched_getparam	155
+#define SYS_sched_setscheduler	156
+#define SYS_sched_getscheduler	157
+#define SYS_sched_yield		158
+#define SYS_sched_get_priority_max	159
+#define SYS_sched_get_priority_min	160
+#define SYS_sched_rr_get_interval	161
 #define SYS_nanosleep		162
 /* #define SYS_mremap */
 
@@ -183,7 +183,7 @@
 /* #define SYS_getresuid */
 /* #define SYS_ni_syscall */
 /* #define SYS_query_module */
-/* #define SYS_poll */
+#define SYS_poll		168
 /* #define SYS_nfsservctl */
 /* #define SYS_setresgid */
 /* #define SYS_getresgid */
@@ -221,6 +221,15 @@
 #define SYS_getdents64		220
 #define SYS_fcntl64		221
 
+#define SYS_epoll_create	254
+#define SYS_epoll_ctl		255
+#define SYS_epoll_wait		256
+
+#define SYS_clock_gettime	265
+#define SYS_clock_getres	266
+
 #define SYS_utimes		271
 
+#define SYS_ppoll		309
+
 #endif /* _FIWIX_UNISTD_H */
@@ -0,0 +1,24 @@
+/*
+ * fiwix/include/fiwix/wait.h
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#ifndef _FIWIX_WAIT_H
+#define _FIWIX_WAIT_H
+
+struct proc;
+
+/*
+ * A wait queue is embedded in the object whose state the processes wait
+ * for. The processes that sleep in exclusive mode are kept at the tail of
+ * the queue, so wake_up() wakes all the non-exclusive ones and only the
+ * first exclusive one.
+ */
+struct wait_queue {
+	struct proc *head;
+	struct proc *tail;
+};
+
+#endif /* _FIWIX_WAIT_H */
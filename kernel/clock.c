@@ -0,0 +1,329 @@
+/*
+ * fiwix/kernel/clock.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+/*
+ * clock.c implements the clocksource, which gives the time elapsed since the
+ * last tick with a resolution of nanoseconds, and the high-resolution timers
+ * built on top of it.
+ *
+ * The time of the system is kept by the tick counter, and the clocksource
+ * only interpolates the time within the current tick. It reads the TSC if
+ * the CPU has one and its frequency was calibrated at boot, otherwise it
+ * reads the counter 0 of the PIT. The TSC is checked against the ticks once
+ * per second, and if its rate drifts (i.e. because of frequency scaling) the
+ * PIT is used from then on.
+ *
+ * The hrtimers keep the absolute monotonic time of their expiration and are
+ * fired by a callout on the first tick after it. So a periodic hrtimer
+ * doesn't accumulate the rounding to ticks of each period.
+ */
+
+#include <fiwix/asm.h>
+#include <fiwix/kernel.h>
+#include <fiwix/cpu.h>
+#include <fiwix/pic.h>
+#include <fiwix/pit.h>
+#include <fiwix/clock.h>
+#include <fiwix/stdio.h>
+
+#define LATCH		(OSCIL / HZ)
+#define CLOCK_SHIFT	22		/* fixed-point scale of the multipliers */
+#define TSC_CHECK_TICKS	HZ		/* interval of the TSC stability check */
+#define TSC_MIN_HZ	1000000		/* slower TSCs don't fit the multiplier */
+
+static unsigned int pit_mult;		/* PIT cycles to ns */
+static unsigned int tsc_mult;		/* TSC cycles to ns */
+static unsigned int tsc_per_tick;
+static unsigned long long int tick_tsc;	/* TSC at the last tick */
+static unsigned long long int check_tsc;
+static unsigned int check_ticks;
+static unsigned int tick_residue_ns;	/* last tick accounted late by */
+
+static unsigned int pit_read(void);
+static unsigned int tsc_read(void);
+
+static struct clocksource pit_clocksource = { "pit", &pit_read, 0 };
+static struct clocksource tsc_clocksource = { "tsc", &tsc_read, 0 };
+struct clocksource *clocksource = &pit_clocksource;
+
+/*
+ * Returns 'n / d' with two 32-bit divisions, so it doesn't need the 64-bit
+ * division of libgcc. The quotient must fit in 32 bits.
+ */
+static unsigned int div64_32(unsigned long long int n, unsigned int d)
+{
+	unsigned int q, rem;
+
+	rem = (unsigned int)(n >> 32) % d;
+	__asm__ __volatile__(
+		"divl %3"
+		: "=a" (q), "=d" (rem)
+		: "0" ((unsigned int)n), "r" (d), "1" (rem)
+	);
+	return q;
+}
+
+static unsigned int pit_read(void)
+{
+	unsigned int cycles;
+
+	cycles = LATCH - pit_getcounter0();
+
+	/* if the tick interrupt is still pending, the counter has reloaded */
+	outport_b(PIC_MASTER, PIC_READ_IRR);
+	if(inport_b(PIC_MASTER) & (1 << TIMER_IRQ)) {
+		return NSEC_PER_TICK;
+	}
+	return ((unsigned long long int)cycles * pit_mult) >> CLOCK_SHIFT;
+}
+
+static unsigned int tsc_read(void)
+{
+	unsigned long long int delta;
+
+	delta = get_rdtsc() - tick_tsc;
+	if(delta > tsc_per_tick) {
+		return NSEC_PER_TICK;
+	}
+	return (delta * tsc_mult) >> CLOCK_SHIFT;
+}
+
+/* returns the nanoseconds elapsed since the last tick */
+static unsigned int tick_offset(void)
+{
+	unsigned int ns;
+
+	/* never reach the next tick, so the clock is always monotonic */
+	ns = clocksource->read() + tick_residue_ns;
+	if(ns >= NSEC_PER_TICK) {
+		ns = NSEC_PER_TICK - 1;
+	}
+	return ns;
+}
+
+static void tsc_unstable(void)
+{
+	printk("WARNING: %s(): TSC is unstable, switching to PIT clocksource.\n", __FUNCTION__);
+	clocksource = &pit_clocksource;
+}
+
+/* compare the TSC cycles elapsed with the ticks, allowing a 12.5% drift */
+static void tsc_check(unsigned long long int now)
+{
+	unsigned long long int elapsed, expected;
+
+	if(kstat.ticks - check_ticks < TSC_CHECK_TICKS) {
+		return;
+	}
+	elapsed = now - check_tsc;
+	expected = (unsigned long long int)tsc_per_tick * (kstat.ticks - check_ticks);
+	if(elapsed > expected + (expected >> 3) || elapsed < expected - (expected >> 3)) {
+		tsc_unstable();
+		return;
+	}
+	check_tsc = now;
+	check_ticks = kstat.ticks;
+}
+
+void timespec_add(struct timespec *ts, const struct timespec *inc)
+{
+	ts->tv_sec += inc->tv_sec;
+	ts->tv_nsec += inc->tv_nsec;
+	if(ts->tv_nsec >= NSEC_PER_SEC) {
+		ts->tv_sec++;
+		ts->tv_nsec -= NSEC_PER_SEC;
+	}
+	if(ts->tv_sec < 0) {
+		/* saturate instead of wrapping around into the past */
+		ts->tv_sec = 0x7FFFFFFF;
+	}
+}
+
+/* returns true if 'a' is earlier than 'b' */
+int timespec_before(const struct timespec *a, const struct timespec *b)
+{
+	if(a->tv_sec != b->tv_sec) {
+		return a->tv_sec < b->tv_sec;
+	}
+	return a->tv_nsec < b->tv_nsec;
+}
+
+void get_monotonic_time(struct timespec *ts)
+{
+	unsigned int flags, ticks, ns;
+
+	SAVE_FLAGS(flags); CLI();
+	ticks = kstat.ticks;
+	ns = tick_offset();
+	RESTORE_FLAGS(flags);
+	ts->tv_sec = ticks / HZ;
+	ts->tv_nsec = ((ticks % HZ) * NSEC_PER_TICK) + ns;
+}
+
+void get_real_time(struct timespec *ts)
+{
+	unsigned int flags, ticks, ns;
+
+	SAVE_FLAGS(flags); CLI();
+	ts->tv_sec = CURRENT_TIME;
+	ticks = kstat.ticks;
+	ns = tick_offset();
+	RESTORE_FLAGS(flags);
+	ts->tv_nsec = ((ticks % HZ) * NSEC_PER_TICK) + ns;
+}
+
+/*
+ * This is called by the timer interrupt after accounting the ticks, with the
+ * PIT cycles that passed since the last tick boundary until the interrupt
+ * was handled (only non-zero when coming from a tickless idle period).
+ */
+void clock_tick(unsigned int residue)
+{
+	unsigned long long int now;
+
+	tick_residue_ns = ((unsigned long long int)residue * pit_mult) >> CLOCK_SHIFT;
+	if(clocksource == &tsc_clocksource) {
+		now = get_rdtsc();
+		if(now < tick_tsc) {
+			tsc_unstable();
+			return;
+		}
+		tick_tsc = now;
+		tsc_check(now);
+	}
+}
+
+/*
+ * Returns the number of ticks until the last tick boundary before the
+ * monotonic time 'ts', and in 'rest' the nanoseconds left beyond it. So the
+ * first tick not earlier than 'ts' is the returned value plus one if 'rest'
+ * is not zero.
+ */
+unsigned int hrtimer_ticks(const struct timespec *ts, unsigned int *rest)
+{
+	unsigned int ticks;
+	int sec, nsec;
+
+	ticks = kstat.ticks;
+	sec = ts->tv_sec - (ticks / HZ);
+	nsec = ts->tv_nsec - ((ticks % HZ) * NSEC_PER_TICK);
+	if(nsec < 0) {
+		sec--;
+		nsec += NSEC_PER_SEC;
+	}
+	*rest = 0;
+	if(sec < 0) {
+		return 0;
+	}
+	if(sec >= (INFINITE_WAIT / HZ) - 1) {
+		return INFINITE_WAIT - 1;
+	}
+	*rest = nsec % NSEC_PER_TICK;
+	return (sec * HZ) + (nsec / NSEC_PER_TICK);
+}
+
+/* returns in 'left' the time until the monotonic time 'ts' */
+void hrtimer_left(const struct timespec *ts, struct timespec *left)
+{
+	struct timespec now;
+
+	get_monotonic_time(&now);
+	left->tv_sec = left->tv_nsec = 0;
+	if(!timespec_before(&now, ts)) {
+		return;
+	}
+	left->tv_sec = ts->tv_sec - now.tv_sec;
+	left->tv_nsec = ts->tv_nsec - now.tv_nsec;
+	if(left->tv_nsec < 0) {
+		left->tv_sec--;
+		left->tv_nsec += NSEC_PER_SEC;
+	}
+}
+
+/* busy-wait until the monotonic time 'ts' */
+void hrtimer_spin(const struct timespec *ts)
+{
+	struct timespec now;
+
+	for(;;) {
+		get_monotonic_time(&now);
+		if(!timespec_before(&now, ts)) {
+			break;
+		}
+	}
+}
+
+static void hrtimer_arm(struct hrtimer *h)
+{
+	unsigned int flags, ticks, rest;
+
+	SAVE_FLAGS(flags); CLI();
+	ticks = hrtimer_ticks(&h->expires, &rest);
+	if(rest) {
+		ticks++;
+	}
+	add_timer(&h->timer, ticks);
+	RESTORE_FLAGS(flags);
+}
+
+/* arm the hrtimer to expire after the time 'ts' */
+void hrtimer_start(struct hrtimer *h, const struct timespec *ts)
+{
+	get_monotonic_time(&h->expires);
+	timespec_add(&h->expires, ts);
+	hrtimer_arm(h);
+}
+
+/*
+ * Re-arm an expired hrtimer 'ts' after its previous expiration. If the new
+ * expiration has already passed, the periods missed are skipped.
+ */
+void hrtimer_forward(struct hrtimer *h, const struct timespec *ts)
+{
+	struct timespec now;
+
+	timespec_add(&h->expires, ts);
+	get_monotonic_time(&now);
+	if(timespec_before(&h->expires, &now)) {
+		h->expires = now;
+		timespec_add(&h->expires, ts);
+	}
+	hrtimer_arm(h);
+}
+
+void hrtimer_cancel(struct hrtimer *h)
+{
+	del_timer(&h->timer);
+}
+
+/* returns in 'left' the time until the hrtimer expires (zero if not armed) */
+void hrtimer_get_left(struct hrtimer *h, struct timespec *left)
+{
+	if(!h->timer.list) {
+		left->tv_sec = left->tv_nsec = 0;
+		return;
+	}
+	hrtimer_left(&h->expires, left);
+}
+
+void clock_init(void)
+{
+	pit_mult = ((unsigned long long int)NSEC_PER_SEC << CLOCK_SHIFT) / OSCIL;
+	pit_clocksource.resolution = (NSEC_PER_SEC + OSCIL - 1) / OSCIL;
+
+	if((cpu_table.flags & CPU_TSC) && cpu_table.hz >= TSC_MIN_HZ) {
+		tsc_mult = div64_32((unsigned long long int)NSEC_PER_SEC << CLOCK_SHIFT, cpu_table.hz);
+		tsc_per_tick = cpu_table.hz / HZ;
+		tsc_clocksource.resolution = NSEC_PER_SEC / cpu_table.hz;
+		if(!tsc_clocksource.resolution) {
+			tsc_clocksource.resolution = 1;
+		}
+		tick_tsc = check_tsc = get_rdtsc();
+		check_ticks = kstat.ticks;
+		clocksource = &tsc_clocksource;
+	}
+}
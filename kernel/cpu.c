@@ -261,4 +261,12 @@ void cpu_init(void)
 	strcpy(UTS_MACHINE, "i386");
 	strncpy(sys_utsname.machine, UTS_MACHINE, _UTSNAME_LENGTH);
 	cpu_table.has_fpu = getfpu();
+
+	/*
+	 * The P6 family and later implement 'rep movs' and 'rep stos' as fast
+	 * strings, which outperform any unrolled loop on bulk transfers.
+	 */
+	if(cpu_table.family >= 6) {
+		set_string_ops(STRING_OPS_REP);
+	}
 }
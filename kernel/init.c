@@ -75,8 +75,9 @@ void init_init(void)
 	init->uid = init->gid = 0;
 	init->euid = init->egid = 0;
 	init->suid = init->sgid = 0;
-	memset_b(init->fd, 0, sizeof(init->fd));
-	memset_b(init->fd_flags, 0, sizeof(init->fd_flags));
+	if(dup_user_fd_table(init, current) || dup_sighand_table(init, current)) {
+		goto init_init__die;
+	}
 	init->root = current->root;
 	init->pwd = current->pwd;
 	strcpy(init->argv0, init_argv[0]);
@@ -85,7 +86,6 @@ void init_init(void)
 	init->sigpending = 0;
 	init->sigblocked = 0;
 	init->sigexecuting = 0;
-	memset_b(init->sigaction, 0, sizeof(init->sigaction));
 	memset_b(&init->usage, 0, sizeof(struct rusage));
 	memset_b(&init->cusage, 0, sizeof(struct rusage));
 	init->timeout = 0;
@@ -95,7 +95,7 @@ void init_init(void)
 	init->rlim[RLIMIT_NOFILE].rlim_cur = OPEN_MAX;
 	init->rlim[RLIMIT_NOFILE].rlim_max = NR_OPENS;
 	init->rlim[RLIMIT_NPROC].rlim_cur = CHILD_MAX;
-	init->rlim[RLIMIT_NPROC].rlim_max = NR_PROCS;
+	init->rlim[RLIMIT_NPROC].rlim_max = MAX_PROCS;
 	init->umask = 0022;
 
 	/* setup the stack */
@@ -14,6 +14,7 @@
 #include <fiwix/string.h>
 #include <fiwix/sigcontext.h>
 #include <fiwix/sleep.h>
+#include <fiwix/timer.h>
 
 struct interrupt *irq_table[NR_IRQS];
 static struct bh *bh_table = NULL;
@@ -93,6 +94,13 @@ void irq_handler(int num, struct sigcontext sc)
 
 	disable_irq(num);
 
+#ifdef CONFIG_TICKLESS
+	/* catch up the ticks elapsed if the CPU was idle without them */
+	if(num != TIMER_IRQ) {
+		tickless_exit();
+	}
+#endif /* CONFIG_TICKLESS */
+
 	irq = irq_table[num];
 
 	/* spurious interrupt treatment */
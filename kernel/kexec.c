@@ -8,6 +8,7 @@
  */
 
 #include <fiwix/asm.h>
+#include <fiwix/cpu.h>
 #include <fiwix/kernel.h>
 #include <fiwix/system.h>
 #include <fiwix/config.h>
@@ -206,6 +207,16 @@ static void multiboot1_trampoline(unsigned int ramdisk_addr, unsigned int kernel
 	/* not reached */
 }
 
+static void disable_global_pages(void)
+{
+	unsigned int cr4;
+
+	if(cpu_table.flags & CPU_PGE) {
+		GET_CR4(cr4);
+		SET_CR4(cr4 & ~CR4_PGE);
+	}
+}
+
 void kexec_multiboot1(void)
 {
 	unsigned int *esp, ramdisk_addr;
@@ -298,6 +309,8 @@ void kexec_multiboot1(void)
 	idle->tss.esp = (unsigned int)esp;
 
 	printk("%s(): jumping to multiboot1_trampoline() ...\n", __FUNCTION__);
+	/* the next kernel must not inherit global entries in the TLB */
+	disable_global_pages();
 	prev = current;
 	set_tss(idle);
 	do_switch(&prev->tss.esp, &prev->tss.eip, idle->tss.esp, idle->tss.eip, idle->tss.cr3, TSS);
@@ -636,6 +649,8 @@ void kexec_linux(void)
 	printk("kexec_linux: kernel_src_addr: %x\n", V2P(kernel_src_addr + real_mode_code_size));
 
 	printk("kexec_linux: jumping to linux_trampoline() ...\n");
+	/* the next kernel must not inherit global entries in the TLB */
+	disable_global_pages();
 	prev = current;
 	set_tss(idle);
 	do_switch(&prev->tss.esp, &prev->tss.eip, idle->tss.esp, idle->tss.eip, idle->tss.cr3, TSS);
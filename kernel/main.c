@@ -27,6 +27,7 @@
 #include <fiwix/timer.h>
 #include <fiwix/sleep.h>
 #include <fiwix/locks.h>
+#include <fiwix/dcache.h>
 #include <fiwix/ps2.h>
 #include <fiwix/keyboard.h>
 #include <fiwix/sched.h>
@@ -110,6 +111,7 @@ void start_kernel(unsigned int magic, unsigned int info, unsigned int last_boot_
 	buffer_init();
 	sched_init();
 	inode_init();
+	dcache_init();
 	fd_init();
 
 	/*
@@ -128,6 +130,8 @@ void start_kernel(unsigned int magic, unsigned int info, unsigned int last_boot_
 	init = get_proc_free();
 	proc_slot_init(init);
 	init->pid = get_unused_pid();
+	hash_proc(init);
+	add_uid_proc(0);
 
 	kernel_process("kswapd", kswapd);	/* PID 2 */
 	kernel_process("kbdflushd", kbdflushd);	/* PID 3 */
@@ -192,6 +196,15 @@ void cpu_idle(void)
 		if(need_resched) {
 			do_sched();
 		}
+#ifdef CONFIG_TICKLESS
+		CLI();
+		if(!need_resched) {
+			tickless_enter();
+			STI_HLT();
+		}
+		STI();
+#else
 		HLT();
+#endif /* CONFIG_TICKLESS */
 	}
 }
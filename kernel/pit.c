@@ -32,6 +32,14 @@ int pit_getcounter0(void)
 	return count;
 }
 
+/* program the counter 0 to interrupt only once after 'count' cycles */
+void pit_oneshot(unsigned short int count)
+{
+	outport_b(MODEREG, SEL_CHAN0 | LSB_MSB | TERM_COUNT | BINARY_CTR);
+	outport_b(CHANNEL0, count & 0xFF);	/* LSB */
+	outport_b(CHANNEL0, count >> 8);	/* MSB */
+}
+
 void pit_init(unsigned short int hertz)
 {
 	outport_b(MODEREG, SEL_CHAN0 | LSB_MSB | RATE_GEN | BINARY_CTR);
@@ -19,13 +19,30 @@
 struct proc *proc_table;
 struct proc *current;
 
+#define PROC_GROW_SLOTS	8	/* slots added each time the table grows */
+#define PID_HASH(id)	((id) & (NR_PID_HASH - 1))
+#define UID_HASH(uid)	((uid) & (NR_UID_HASH - 1))
+
+/* number of processes of a real UID, checked against RLIMIT_NPROC */
+struct uid_count {
+	__uid_t uid;
+	int count;
+	struct uid_count *next;
+};
+
 struct proc *proc_pool_head;
 struct proc *proc_table_head;
 struct proc *proc_table_tail;
 unsigned int free_proc_slots = 0;
+unsigned int nr_proc_slots = 0;
+struct kmem_cache *vma_cache;
+static struct kmem_cache *sighand_cache;
+
+static struct proc *pid_hash_table[NR_PIDTYPES][NR_PID_HASH];
+static struct uid_count *uid_hash_table[NR_UID_HASH];
 
-static struct resource slot_resource = { 0, 0 };
-static struct resource pid_resource = { 0, 0 };
+static struct resource slot_resource = { 0 };
+static struct resource pid_resource = { 0 };
 
 int nr_processes = 0;
 __pid_t lastpid = 0;
@@ -70,7 +87,7 @@ void get_rusage(struct proc *p, struct rusage *ru)
 	 * then the child statistics should not be added to the values returned
 	 * by RUSAGE_CHILDREN.
 	 */
-	if(current->sigaction[SIGCHLD - 1].sa_handler == SIG_IGN) {
+	if(current->sighand->action[SIGCHLD - 1].sa_handler == SIG_IGN) {
 		return;
 	}
 
@@ -112,15 +129,217 @@ void add_rusage(struct proc *p)
 	current->cusage.ru_nivcsw += cru.ru_nivcsw;
 }
 
+static __pid_t get_proc_id(struct proc *p, int type)
+{
+	switch(type) {
+		case PIDTYPE_PGID:
+			return p->pgid;
+		case PIDTYPE_SID:
+			return p->sid;
+	}
+	return p->pid;
+}
+
+static void insert_on_pid_hash(struct proc *p, int type)
+{
+	struct proc **head;
+
+	head = &pid_hash_table[type][PID_HASH(get_proc_id(p, type))];
+	p->prev_hash[type] = NULL;
+	p->next_hash[type] = *head;
+	if(*head) {
+		(*head)->prev_hash[type] = p;
+	}
+	*head = p;
+}
+
+static void remove_from_pid_hash(struct proc *p, int type)
+{
+	struct proc **head;
+
+	head = &pid_hash_table[type][PID_HASH(get_proc_id(p, type))];
+	if(p->next_hash[type]) {
+		p->next_hash[type]->prev_hash[type] = p->prev_hash[type];
+	}
+	if(p->prev_hash[type]) {
+		p->prev_hash[type]->next_hash[type] = p->next_hash[type];
+	}
+	if(p == *head) {
+		*head = p->next_hash[type];
+	}
+	p->prev_hash[type] = p->next_hash[type] = NULL;
+}
+
+/* returns the first process from 'p' onwards in its chain with the ID 'id' */
+static struct proc *search_pid_hash(struct proc *p, int type, __pid_t id)
+{
+	while(p) {
+		if(get_proc_id(p, type) == id) {
+			return p;
+		}
+		p = p->next_hash[type];
+	}
+	return NULL;
+}
+
+struct proc *get_proc_by_pid(__pid_t pid)
+{
+	return search_pid_hash(pid_hash_table[PIDTYPE_PID][PID_HASH(pid)], PIDTYPE_PID, pid);
+}
+
+struct proc *first_in_pgrp(__pid_t pgid)
+{
+	return search_pid_hash(pid_hash_table[PIDTYPE_PGID][PID_HASH(pgid)], PIDTYPE_PGID, pgid);
+}
+
+struct proc *next_in_pgrp(struct proc *p)
+{
+	return search_pid_hash(p->next_hash[PIDTYPE_PGID], PIDTYPE_PGID, p->pgid);
+}
+
+struct proc *first_in_session(__pid_t sid)
+{
+	return search_pid_hash(pid_hash_table[PIDTYPE_SID][PID_HASH(sid)], PIDTYPE_SID, sid);
+}
+
+struct proc *next_in_session(struct proc *p)
+{
+	return search_pid_hash(p->next_hash[PIDTYPE_SID], PIDTYPE_SID, p->sid);
+}
+
+/* makes the process visible by its PID, PGID and SID once it has a PID */
+void hash_proc(struct proc *p)
+{
+	int n;
+
+	for(n = 0; n < NR_PIDTYPES; n++) {
+		insert_on_pid_hash(p, n);
+	}
+}
+
+void set_pgid(struct proc *p, __pid_t pgid)
+{
+	remove_from_pid_hash(p, PIDTYPE_PGID);
+	p->pgid = pgid;
+	insert_on_pid_hash(p, PIDTYPE_PGID);
+}
+
+void set_sid(struct proc *p, __pid_t sid)
+{
+	remove_from_pid_hash(p, PIDTYPE_SID);
+	p->sid = sid;
+	insert_on_pid_hash(p, PIDTYPE_SID);
+}
+
+void add_child(struct proc *parent, struct proc *p)
+{
+	p->ppid = parent;
+	p->prev_sibling = NULL;
+	p->next_sibling = parent->first_child;
+	if(parent->first_child) {
+		parent->first_child->prev_sibling = p;
+	}
+	parent->first_child = p;
+	parent->children++;
+}
+
+void remove_child(struct proc *p)
+{
+	struct proc *parent;
+
+	if(!(parent = p->ppid)) {
+		return;
+	}
+	if(p->next_sibling) {
+		p->next_sibling->prev_sibling = p->prev_sibling;
+	}
+	if(p->prev_sibling) {
+		p->prev_sibling->next_sibling = p->next_sibling;
+	}
+	if(p == parent->first_child) {
+		parent->first_child = p->next_sibling;
+	}
+	p->prev_sibling = p->next_sibling = NULL;
+	parent->children--;
+}
+
+static struct uid_count *search_uid_count(__uid_t uid)
+{
+	struct uid_count *uc;
+
+	for(uc = uid_hash_table[UID_HASH(uid)]; uc; uc = uc->next) {
+		if(uc->uid == uid) {
+			return uc;
+		}
+	}
+	return NULL;
+}
+
+int get_uid_procs(__uid_t uid)
+{
+	struct uid_count *uc;
+
+	if((uc = search_uid_count(uid))) {
+		return uc->count;
+	}
+	return 0;
+}
+
+int add_uid_proc(__uid_t uid)
+{
+	struct uid_count *uc;
+
+	if(!(uc = search_uid_count(uid))) {
+		if(!(uc = (struct uid_count *)kmalloc(sizeof(struct uid_count)))) {
+			return -EAGAIN;
+		}
+		uc->uid = uid;
+		uc->count = 0;
+		uc->next = uid_hash_table[UID_HASH(uid)];
+		uid_hash_table[UID_HASH(uid)] = uc;
+	}
+	uc->count++;
+	return 0;
+}
+
+void del_uid_proc(__uid_t uid)
+{
+	struct uid_count **uc, *tmp;
+
+	for(uc = &uid_hash_table[UID_HASH(uid)]; *uc; uc = &(*uc)->next) {
+		if((*uc)->uid == uid) {
+			if(!--(*uc)->count) {
+				tmp = *uc;
+				*uc = tmp->next;
+				kfree((unsigned int)tmp);
+			}
+			return;
+		}
+	}
+}
+
+/* changes the real UID of the process, moving it to the count of 'uid' */
+int set_proc_uid(struct proc *p, __uid_t uid)
+{
+	if(p->uid == uid) {
+		return 0;
+	}
+	if(add_uid_proc(uid)) {
+		return -EAGAIN;
+	}
+	del_uid_proc(p->uid);
+	p->uid = uid;
+	return 0;
+}
+
 struct proc *get_next_zombie(struct proc *parent)
 {
 	struct proc *p;
 
-	FOR_EACH_PROCESS(p) {
-		if(p->ppid == parent && p->state == PROC_ZOMBIE) {
+	for(p = parent->first_child; p; p = p->next_sibling) {
+		if(p->state == PROC_ZOMBIE) {
 			return p;
 		}
-		p = p->next;
 	}
 
 	return NULL;
@@ -128,19 +347,20 @@ struct proc *get_next_zombie(struct proc *parent)
 
 __pid_t remove_zombie(struct proc *p)
 {
-	struct proc *pp;
 	__pid_t pid;
 
 	pid = p->pid;
 	kfree(p->tss.esp0);
 	p->rss--;
-	kfree(P2V(p->tss.cr3));
-	p->rss--;
-	pp = p->ppid;
-	release_proc(p);
-	if(pp) {
-		pp->children--;
+	if(p->io_tss) {
+		kfree((unsigned int)p->io_tss);
+	}
+	if(p->tss.cr3 != V2P((unsigned int)kpage_dir)) {
+		kfree(P2V(p->tss.cr3));
+		p->rss--;
 	}
+	remove_child(p);
+	release_proc(p);
 	return pid;
 }
 
@@ -157,34 +377,55 @@ int is_orphaned_pgrp(__pid_t pgid)
 	retval = 0;
 	lock_resource(&slot_resource);
 
-	FOR_EACH_PROCESS(p) {
-		if(p->pgid == pgid) {
-			if(p->state != PROC_ZOMBIE) {
-				pp = p->ppid;
-				/* return if only one is found that breaks the rule */
-				if(pp->pgid != pgid || pp->sid == p->sid) {
-					break;
-				}
+	for(p = first_in_pgrp(pgid); p; p = next_in_pgrp(p)) {
+		if(p->state != PROC_ZOMBIE) {
+			pp = p->ppid;
+			/* return if only one is found that breaks the rule */
+			if(pp->pgid != pgid || pp->sid == p->sid) {
+				break;
 			}
 		}
-		p = p->next;
 	}
 
 	unlock_resource(&slot_resource);
 	return retval;
 }
 
+/* adds a chunk of slots to the free list, as the proc_table is full */
+static void grow_proc_table(void)
+{
+	struct proc *p;
+	int n;
+
+	if(nr_proc_slots + PROC_GROW_SLOTS > MAX_PROCS) {
+		return;
+	}
+	if(!(p = (struct proc *)kmalloc(sizeof(struct proc) * PROC_GROW_SLOTS))) {
+		return;
+	}
+	memset_b(p, 0, sizeof(struct proc) * PROC_GROW_SLOTS);
+	for(n = 0; n < PROC_GROW_SLOTS; n++, p++) {
+		p->next = proc_pool_head;
+		proc_pool_head = p;
+	}
+	free_proc_slots += PROC_GROW_SLOTS;
+	nr_proc_slots += PROC_GROW_SLOTS;
+}
+
 struct proc *get_proc_free(void)
 {
 	struct proc *p = NULL;
 
-	if(free_proc_slots <= SAFE_SLOTS && !IS_SUPERUSER) {
+	if(free_proc_slots + (MAX_PROCS - nr_proc_slots) <= SAFE_SLOTS && !IS_SUPERUSER) {
 		printk("WARNING: %s(): the remaining slots are only for root user!\n", __FUNCTION__);
 		return NULL;
 	}
 
 	lock_resource(&slot_resource);
 
+	if(!proc_pool_head) {
+		grow_proc_table();
+	}
 	if(proc_pool_head) {
 
 		/* get (remove) a process slot from the free list */
@@ -202,6 +443,8 @@ struct proc *get_proc_free(void)
 
 void release_proc(struct proc *p)
 {
+	int n;
+
 	lock_resource(&slot_resource);
 
 	/* remove a process from the proc_table */
@@ -217,6 +460,15 @@ void release_proc(struct proc *p)
 		p->next->prev = p->prev;
 	}
 
+	if(p->pid) {
+		for(n = 0; n < NR_PIDTYPES; n++) {
+			remove_from_pid_hash(p, n);
+		}
+		del_uid_proc(p->uid);
+	}
+	free_user_fd_table(p);
+	free_sighand_table(p);
+
 	/* initialize and put a process slot back in the free list */
 	memset_b(p, 0, sizeof(struct proc));
 	p->next = proc_pool_head;
@@ -226,10 +478,48 @@ void release_proc(struct proc *p)
 	unlock_resource(&slot_resource);
 }
 
+/*
+ * Gives the child its own copy of the signal handlers of the parent (all
+ * SIG_DFL if the parent has none). The child might be the parent itself, to
+ * stop sharing its handlers.
+ */
+int dup_sighand_table(struct proc *child, struct proc *parent)
+{
+	struct sighand *old, *new;
+
+	if(!(new = (struct sighand *)kmem_cache_alloc(sighand_cache))) {
+		return -ENOMEM;
+	}
+	if((old = parent->sighand)) {
+		memcpy_b(new->action, old->action, sizeof(new->action));
+	} else {
+		memset_b(new->action, 0, sizeof(new->action));
+	}
+	new->count = 1;
+	if(child == parent) {
+		old->count--;
+	}
+	child->sighand = new;
+	return 0;
+}
+
+/* drops the signal handlers of the process, they're freed by the last user */
+void free_sighand_table(struct proc *p)
+{
+	struct sighand *s;
+
+	if(!(s = p->sighand)) {
+		return;
+	}
+	p->sighand = NULL;
+	if(!--s->count) {
+		kmem_cache_free(sighand_cache, (unsigned int)s);
+	}
+}
+
 int get_unused_pid(void)
 {
 	short int loop;
-	struct proc *p;
 
 	loop = 0;
 	lock_resource(&pid_resource);
@@ -244,42 +534,30 @@ loop:
 		printk("WARNING: %s(): system ran out of PID numbers!\n");
 		return 0;
 	}
-	FOR_EACH_PROCESS(p) {
-		/*
-		 * Make sure the kernel never reuses active pid, pgid
-		 * or sid values.
-		 */
-		if(lastpid == p->pid || lastpid == p->pgid || lastpid == p->sid) {
-			goto loop;
-		}
-		p = p->next;
+
+	/* make sure the kernel never reuses active pid, pgid or sid values */
+	if(get_proc_by_pid(lastpid) || first_in_pgrp(lastpid) || first_in_session(lastpid)) {
+		goto loop;
 	}
 
 	unlock_resource(&pid_resource);
 	return lastpid;
 }
 
-struct proc *get_proc_by_pid(__pid_t pid)
-{
-	struct proc *p;
-
-	FOR_EACH_PROCESS(p) {
-		if(p->pid == pid) {
-			return p;
-		}
-		p = p->next;
-	}
-
-	return NULL;
-}
-
 struct proc *kernel_process(const char *name, int (*fn)(void))
 {
 	struct proc *p;
 
-	p = get_proc_free();
+	if(add_uid_proc(0)) {
+		return NULL;
+	}
+	if(!(p = get_proc_free())) {
+		del_uid_proc(0);
+		return NULL;
+	}
 	proc_slot_init(p);
 	p->pid = get_unused_pid();
+	hash_proc(p);
 	p->ppid = &proc_table[IDLE];
 	p->flags |= PF_KPROC;
 	p->priority = DEF_PRIORITY;
@@ -316,15 +594,20 @@ void proc_slot_init(struct proc *p)
 	}
 	p->prev_sleep = p->next_sleep = NULL;
 	p->prev_run = p->next_run = NULL;
+	p->prev_rq = p->next_rq = NULL;
+	p->rq_array = NULL;
+	memset_b(&p->timeout_timer, 0, sizeof(struct callout));
+	memset_b(&p->it_real_timer, 0, sizeof(struct hrtimer));
 	unlock_resource(&slot_resource);
 
-	memset_b(&p->tss, 0, sizeof(struct i386tss) - IO_BITMAP_SIZE);
-	p->tss.io_bitmap_addr = offsetof(struct i386tss, io_bitmap);
+	memset_b(&p->tss, 0, sizeof(struct i386tss));
+
+	/* the bitmap is beyond the TSS limit, so the access to all ports is denied */
+	p->tss.io_bitmap_addr = sizeof(struct i386tss);
 
 	/* I/O permissions are not inherited by the child */
-	memset_l(&p->tss.io_bitmap, ~0, IO_BITMAP_SIZE / sizeof(unsigned int));
+	p->io_tss = NULL;
 
-	p->tss.io_bitmap[IO_BITMAP_SIZE] = ~0;	/* extra byte must be all 1's */
 	p->state = PROC_IDLE;
 }
 
@@ -345,6 +628,16 @@ void proc_init(void)
 		p->next = proc_pool_head;
 		proc_pool_head = p;
 		free_proc_slots++;
+		nr_proc_slots++;
 	} while(n--);
 	proc_table_head = proc_table_tail = NULL;
+	memset_b(pid_hash_table, 0, sizeof(pid_hash_table));
+	memset_b(uid_hash_table, 0, sizeof(uid_hash_table));
+
+	if(!(vma_cache = kmem_cache_create("vma", sizeof(struct vma), NULL))) {
+		PANIC("Unable to create the vma cache.\n");
+	}
+	if(!(sighand_cache = kmem_cache_create("sighand", sizeof(struct sighand), NULL))) {
+		PANIC("Unable to create the sighand cache.\n");
+	}
 }
@@ -19,6 +19,129 @@
 extern struct seg_desc gdt[NR_GDT_ENTRIES];
 int need_resched = 0;
 
+/*
+ * The run queue is made of three priority arrays. The real-time processes
+ * (SCHED_FIFO and SCHED_RR) are kept in their own array, indexed by their
+ * static priority, and always run before any other process.
+ *
+ * The rest of processes use two arrays: the active one keeps the processes
+ * that still have time slice left, and the expired one keeps those that
+ * have consumed it, already refilled. The level in these arrays is the time
+ * slice left when the process was queued. When the active array becomes
+ * empty both arrays are just swapped.
+ *
+ * Each array has a FIFO list per level and a bitmap of the non-empty levels,
+ * so the next process is found with a 'bsr' on the few words of the bitmap.
+ */
+static struct prio_array prio_arrays[3];
+static struct prio_array *active, *expired, *rt_array;
+
+static int highest_level(struct prio_array *a)
+{
+	int n, level;
+
+	for(n = RUN_BITMAP_SIZE - 1; n >= 0; n--) {
+		if(a->bitmap[n]) {
+			__asm__ __volatile__("bsrl %1, %0" : "=r" (level) : "rm" (a->bitmap[n]));
+			return (n * 32) + level;
+		}
+	}
+	return -1;
+}
+
+/* returns 1 if a real-time process must preempt the current process */
+static int rt_preempt(void)
+{
+	int level;
+
+	if((level = highest_level(rt_array)) < 0) {
+		return 0;
+	}
+	if(current->policy == SCHED_OTHER) {
+		return 1;
+	}
+	return level > current->rt_priority;
+}
+
+static struct proc *pick_next_proc(void)
+{
+	struct prio_array *a;
+	int level;
+
+	if((level = highest_level(rt_array)) >= 0) {
+		return rt_array->head[level];
+	}
+	if((level = highest_level(active)) < 0) {
+		a = active;
+		active = expired;
+		expired = a;
+		level = highest_level(active);
+	}
+	if(level >= 0) {
+		return active->head[level];
+	}
+	return &proc_table[IDLE];
+}
+
+void enqueue_proc(struct proc *p)
+{
+	struct prio_array *a;
+	int level;
+
+	if(p->policy != SCHED_OTHER) {
+		if(p->cpu_count <= 0) {
+			p->cpu_count = RR_TIMESLICE;
+		}
+		a = rt_array;
+		level = p->rt_priority;
+	} else {
+		if(p->cpu_count > 0) {
+			a = active;
+		} else {
+			p->cpu_count = p->priority;
+			a = expired;
+		}
+		level = MIN(p->cpu_count, NR_RUN_LEVELS - 1);
+	}
+	p->rq_array = a;
+	p->rq_level = level;
+	p->prev_rq = a->tail[level];
+	p->next_rq = NULL;
+	if(a->tail[level]) {
+		a->tail[level]->next_rq = p;
+	} else {
+		a->head[level] = p;
+	}
+	a->tail[level] = p;
+	a->bitmap[level / 32] |= 1 << (level % 32);
+}
+
+void dequeue_proc(struct proc *p)
+{
+	struct prio_array *a;
+	int level;
+
+	if(!(a = p->rq_array)) {
+		return;
+	}
+	level = p->rq_level;
+	if(p->next_rq) {
+		p->next_rq->prev_rq = p->prev_rq;
+	} else {
+		a->tail[level] = p->prev_rq;
+	}
+	if(p->prev_rq) {
+		p->prev_rq->next_rq = p->next_rq;
+	} else {
+		a->head[level] = p->next_rq;
+	}
+	if(!a->head[level]) {
+		a->bitmap[level / 32] &= ~(1 << (level % 32));
+	}
+	p->prev_rq = p->next_rq = NULL;
+	p->rq_array = NULL;
+}
+
 static void context_switch(struct proc *next)
 {
 	struct proc *prev;
@@ -35,54 +158,106 @@ static void context_switch(struct proc *next)
 void set_tss(struct proc *p)
 {
 	struct seg_desc *g;
+	struct i386tss *tss;
+	unsigned int limit;
 
 	g = &gdt[TSS / sizeof(struct seg_desc)];
 
-	g->sd_lobase = (unsigned int)&p->tss;
+	tss = &p->tss;
+	limit = sizeof(struct i386tss) - 1;
+	if(p->io_tss) {
+		/* the CPU only reads the kernel stack and the I/O bitmap */
+		p->io_tss->tss.esp0 = p->tss.esp0;
+		p->io_tss->tss.ss0 = p->tss.ss0;
+		tss = &p->io_tss->tss;
+		limit = sizeof(struct io_tss) - 1;
+	}
+
+	g->sd_lolimit = limit & 0xFFFF;
+	g->sd_lobase = (unsigned int)tss;
 	g->sd_loflags = SD_TSSPRESENT;
-	g->sd_hibase = (char)(((unsigned int)&p->tss) >> 24);
+	g->sd_hibase = (char)(((unsigned int)tss) >> 24);
 }
 
-/* Round Robin algorithm */
 void do_sched(void)
 {
-	int count;
-	struct proc *p, *selected;
+	unsigned int flags;
+	struct proc *selected;
 
-	/* let the current running process consume its time slice */
-	if(current->state == PROC_RUNNING && current->cpu_count > 0) {
-		return;
+	/*
+	 * Let the current running process consume its time slice, unless a
+	 * real-time process with a higher priority is waiting to run.
+	 * SCHED_FIFO processes have no time slice at all.
+	 */
+	if(current->state == PROC_RUNNING && !rt_preempt()) {
+		if(current->policy == SCHED_FIFO || current->cpu_count > 0) {
+			return;
+		}
 	}
 
+	SAVE_FLAGS(flags); CLI();
 	need_resched = 0;
-	for(;;) {
-		count = -1;
-		selected = &proc_table[IDLE];
-
-		FOR_EACH_PROCESS_RUNNING(p) {
-			if(p->cpu_count > count) {
-				count = p->cpu_count;
-				selected = p;
-			}
-			p = p->next_run;
-		}
-		if(count) {
-			break;
+
+	/* the time slice of the current process has expired */
+	if(current->state == PROC_RUNNING && current->policy != SCHED_FIFO) {
+		if(current->cpu_count <= 0) {
+			dequeue_proc(current);
+			enqueue_proc(current);
 		}
+	}
+	selected = pick_next_proc();
+	RESTORE_FLAGS(flags);
 
-		/* reassigns new quantum to all running processes */
-		FOR_EACH_PROCESS_RUNNING(p) {
-			p->cpu_count = p->priority;
-			p = p->next_run;
+	if(current != selected) {
+		context_switch(selected);
+	}
+}
+
+/* move the current process to the end of its queue and reschedule */
+void yield(void)
+{
+	unsigned int flags;
+	struct proc *selected;
+
+	SAVE_FLAGS(flags); CLI();
+	need_resched = 0;
+	if(current->state == PROC_RUNNING) {
+		dequeue_proc(current);
+		if(current->policy == SCHED_OTHER) {
+			current->cpu_count = 0;
 		}
+		enqueue_proc(current);
 	}
+	selected = pick_next_proc();
+	RESTORE_FLAGS(flags);
+
 	if(current != selected) {
 		context_switch(selected);
 	}
 }
 
+void set_scheduler(struct proc *p, int policy, int rt_priority)
+{
+	unsigned int flags;
+
+	SAVE_FLAGS(flags); CLI();
+	dequeue_proc(p);
+	p->policy = policy;
+	p->rt_priority = rt_priority;
+	if(p->state == PROC_RUNNING) {
+		enqueue_proc(p);
+	}
+	need_resched = 1;
+	RESTORE_FLAGS(flags);
+}
+
 void sched_init(void)
 {
+	memset_b(prio_arrays, 0, sizeof(prio_arrays));
+	active = &prio_arrays[0];
+	expired = &prio_arrays[1];
+	rt_array = &prio_arrays[2];
+
 	get_system_time();
 
 	/* this should be more unpredictable */
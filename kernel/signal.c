@@ -72,13 +72,13 @@ int send_sig(struct proc *p, __sigset_t signum)
 	switch(signum) {
 		case SIGFPE:
 		case SIGSEGV:
-			if(p->sigaction[signum - 1].sa_handler == SIG_IGN) {
-				p->sigaction[signum - 1].sa_handler = SIG_DFL;
+			if(p->sighand->action[signum - 1].sa_handler == SIG_IGN) {
+				p->sighand->action[signum - 1].sa_handler = SIG_DFL;
 			}
 			break;
 	}
 
-	if(p->sigaction[signum - 1].sa_handler == SIG_DFL) {
+	if(p->sighand->action[signum - 1].sa_handler == SIG_DFL) {
 		/*
 		 * INIT process is special, it only gets signals that have the
 		 * signal handler installed. This avoids to bring down the
@@ -98,7 +98,7 @@ int send_sig(struct proc *p, __sigset_t signum)
 		}
 	}
 
-	if(p->sigaction[signum - 1].sa_handler == SIG_IGN) {
+	if(p->sighand->action[signum - 1].sa_handler == SIG_IGN) {
 		/* if SIGCHLD is ignored reap its children (prevent zombies) */
 		if(signum == SIGCHLD) {
 			while(sys_waitpid(-1, NULL, WNOHANG) > 0) {
@@ -132,18 +132,18 @@ int issig(void)
 	for(signum = 1, mask = 1; signum < NSIG; signum++, mask <<= 1) {
 		if(current->sigpending & mask) {
 			if(signum == SIGCHLD) {
-				if(current->sigaction[signum - 1].sa_handler == SIG_IGN) {
+				if(current->sighand->action[signum - 1].sa_handler == SIG_IGN) {
 					/* this process ignores SIGCHLD */
 					while((p = get_next_zombie(current))) {
 						remove_zombie(p);
 					}
 				} else {
-					if(current->sigaction[signum - 1].sa_handler != SIG_DFL) {
+					if(current->sighand->action[signum - 1].sa_handler != SIG_DFL) {
 						return signum;
 					}
 				}
 			} else {
-				if(current->sigaction[signum - 1].sa_handler != SIG_IGN) {
+				if(current->sighand->action[signum - 1].sa_handler != SIG_IGN) {
 					return signum;
 				}
 			}
@@ -166,7 +166,7 @@ void psig(unsigned int stack)
 		if(current->sigpending & mask) {
 			current->sigpending &= ~mask;
 
-			if((unsigned int)current->sigaction[signum - 1].sa_handler) {
+			if((unsigned int)current->sighand->action[signum - 1].sa_handler) {
 
 				/*
 				 * page_not_present() may have raised a SIGSEGV if it
@@ -183,7 +183,7 @@ void psig(unsigned int stack)
 				}
 
 				current->sigexecuting = mask;
-				if(!(current->sigaction[signum - 1].sa_flags & SA_NODEFER)) {
+				if(!(current->sighand->action[signum - 1].sa_flags & SA_NODEFER)) {
 					current->sigblocked |= mask;
 				}
 
@@ -195,16 +195,16 @@ void psig(unsigned int stack)
 				sc->oldesp -= 4;
 				sc->oldesp &= ~3;	/* round up */
 				memcpy_b((void *)sc->oldesp, sighandler_trampoline, len);
-				sc->ecx = (unsigned int)current->sigaction[signum - 1].sa_handler;
+				sc->ecx = (unsigned int)current->sighand->action[signum - 1].sa_handler;
 				sc->eax= signum;
 				sc->eip = sc->oldesp;
 
-				if(current->sigaction[signum - 1].sa_flags & SA_RESETHAND) {
-					current->sigaction[signum - 1].sa_handler = SIG_DFL;
+				if(current->sighand->action[signum - 1].sa_flags & SA_RESETHAND) {
+					current->sighand->action[signum - 1].sa_handler = SIG_DFL;
 				}
 				return;
 			}
-			if(current->sigaction[signum - 1].sa_handler == SIG_DFL) {
+			if(current->sighand->action[signum - 1].sa_handler == SIG_DFL) {
 				switch(signum) {
 					case SIGCONT:
 						runnable(current);
@@ -216,7 +216,7 @@ void psig(unsigned int stack)
 					case SIGTTOU:
 						current->exit_code = signum;
 						not_runnable(current, PROC_STOPPED);
-						if(!(current->sigaction[signum - 1].sa_flags & SA_NOCLDSTOP)) {
+						if(!(current->sighand->action[signum - 1].sa_flags & SA_NOCLDSTOP)) {
 							p = current->ppid;
 							send_sig(p, SIGCHLD);
 							/* needed for job control */
@@ -246,16 +246,13 @@ int kill_pid(__pid_t pid, __sigset_t signum, int sender)
 {
 	struct proc *p;
 
-	FOR_EACH_PROCESS(p) {
-		if(p->pid == pid && p->state != PROC_ZOMBIE) {
-			if(sender == USER) {
-				if(!can_signal(p)) {
-					return -EPERM;
-				}
+	if((p = get_proc_by_pid(pid)) && p->state != PROC_ZOMBIE) {
+		if(sender == USER) {
+			if(!can_signal(p)) {
+				return -EPERM;
 			}
-			return send_sig(p, signum);
 		}
-		p = p->next;
+		return send_sig(p, signum);
 	}
 	return -ESRCH;
 }
@@ -266,18 +263,16 @@ int kill_pgrp(__pid_t pgid, __sigset_t signum, int sender)
 	int found;
 
 	found = 0;
-	FOR_EACH_PROCESS(p) {
-		if(p->pgid == pgid && p->state != PROC_ZOMBIE) {
+	for(p = first_in_pgrp(pgid); p; p = next_in_pgrp(p)) {
+		if(p->state != PROC_ZOMBIE) {
 			if(sender == USER) {
 				if(!can_signal(p)) {
-					p = p->next;
 					continue;
 				}
 			}
 			send_sig(p, signum);
 			found = 1;
 		}
-		p = p->next;
 	}
 
 	if(!found) {
@@ -15,8 +15,13 @@
 #include <fiwix/stdio.h>
 #include <fiwix/string.h>
 
-#define NR_BUCKETS		(NR_PROCS >= 10 ? (NR_PROCS * 10) / 100 : 1)
-#define SLEEP_HASH(addr)	((addr) % (NR_BUCKETS))
+/*
+ * The processes that sleep on an address are kept in a hash table. The hot
+ * paths (locks, buffers, inodes, pipes and sockets) use the wait queues
+ * embedded in their objects instead.
+ */
+#define NR_BUCKETS		64
+#define SLEEP_HASH(addr)	(((addr) >> 2) & (NR_BUCKETS - 1))
 
 struct proc *sleep_hash_table[NR_BUCKETS];
 struct proc *proc_run_head;
@@ -38,6 +43,7 @@ void runnable(struct proc *p)
 	}
 	proc_run_head = p;
 	p->state = PROC_RUNNING;
+	enqueue_proc(p);
 	RESTORE_FLAGS(flags);
 }
 
@@ -46,6 +52,7 @@ void not_runnable(struct proc *p, int state)
 	unsigned int flags;
 
 	SAVE_FLAGS(flags); CLI();
+	dequeue_proc(p);
 	if(p->next_run) {
 		p->next_run->prev_run = p->prev_run;
 	}
@@ -60,42 +67,28 @@ void not_runnable(struct proc *p, int state)
 	RESTORE_FLAGS(flags);
 }
 
-int sleep(void *address, int state)
+/* returns false (and the signal pending, if any) if it can't go to sleep */
+static int can_sleep(int state, int *signum)
 {
-	unsigned int flags;
-	struct proc **h;
-	int signum, i;
-
-	SAVE_FLAGS(flags); CLI();
+	*signum = 0;
 
 	/* return if it has signals */
 	if(state == PROC_INTERRUPTIBLE) {
-		if((signum = issig())) {
-			RESTORE_FLAGS(flags);
-			return signum;
+		if((*signum = issig())) {
+			return 0;
 		}
 	}
 
 	if(current->state == PROC_SLEEPING) {
 		printk("WARNING: %s(): process with pid '%d' is already sleeping!\n", __FUNCTION__, current->pid);
-		RESTORE_FLAGS(flags);
 		return 0;
 	}
+	return 1;
+}
 
-	i = SLEEP_HASH((unsigned int)address);
-	h = &sleep_hash_table[i];
-
-	/* insert process in the head */
-	if(!*h) {
-		*h = current;
-		(*h)->prev_sleep = (*h)->next_sleep = NULL;
-	} else {
-		current->prev_sleep = NULL;
-		current->next_sleep = *h;
-		(*h)->prev_sleep = current;
-		*h = current;
-	}
-	current->sleep_address = address;
+/* the process is already queued, so give up the CPU until it's woken up */
+static int do_sleep(int state)
+{
 	if(state == PROC_UNINTERRUPTIBLE) {
 		current->flags |= PF_NOTINTERRUPT;
 	}
@@ -103,11 +96,107 @@ int sleep(void *address, int state)
 
 	do_sched();
 
-	signum = 0;
 	if(state == PROC_INTERRUPTIBLE) {
-		signum = issig();
+		return issig();
+	}
+	return 0;
+}
+
+static void add_wait_queue(struct wait_queue *wq, struct proc *p, int exclusive)
+{
+	p->sleep_queue = wq;
+	if(exclusive) {
+		p->flags |= PF_EXCLUSIVE;
+		p->prev_sleep = wq->tail;
+		p->next_sleep = NULL;
+		if(wq->tail) {
+			wq->tail->next_sleep = p;
+		} else {
+			wq->head = p;
+		}
+		wq->tail = p;
+	} else {
+		p->flags &= ~PF_EXCLUSIVE;
+		p->prev_sleep = NULL;
+		p->next_sleep = wq->head;
+		if(wq->head) {
+			wq->head->prev_sleep = p;
+		} else {
+			wq->tail = p;
+		}
+		wq->head = p;
+	}
+}
+
+static void remove_wait_queue(struct proc *p)
+{
+	struct wait_queue *wq;
+
+	wq = p->sleep_queue;
+	if(p->next_sleep) {
+		p->next_sleep->prev_sleep = p->prev_sleep;
+	} else {
+		wq->tail = p->prev_sleep;
+	}
+	if(p->prev_sleep) {
+		p->prev_sleep->next_sleep = p->next_sleep;
+	} else {
+		wq->head = p->next_sleep;
+	}
+	p->prev_sleep = p->next_sleep = NULL;
+	p->sleep_queue = NULL;
+	p->flags &= ~PF_EXCLUSIVE;
+}
+
+static void remove_sleep_hash(struct proc *p)
+{
+	struct proc **h;
+
+	if(p->next_sleep) {
+		p->next_sleep->prev_sleep = p->prev_sleep;
+	}
+	if(p->prev_sleep) {
+		p->prev_sleep->next_sleep = p->next_sleep;
+	}
+	h = &sleep_hash_table[SLEEP_HASH((unsigned int)p->sleep_address)];
+	if(*h == p) {	/* if it's the head */
+		*h = p->next_sleep;
+	}
+	p->prev_sleep = p->next_sleep = NULL;
+	p->sleep_address = NULL;
+}
+
+static void wake_proc(struct proc *p)
+{
+	p->flags &= ~PF_NOTINTERRUPT;
+	p->cpu_count = p->priority;
+	runnable(p);
+}
+
+int sleep(void *address, int state)
+{
+	unsigned int flags;
+	struct proc **h;
+	int signum;
+
+	SAVE_FLAGS(flags); CLI();
+	if(!can_sleep(state, &signum)) {
+		RESTORE_FLAGS(flags);
+		return signum;
+	}
+
+	h = &sleep_hash_table[SLEEP_HASH((unsigned int)address)];
+
+	/* insert process in the head */
+	current->prev_sleep = NULL;
+	current->next_sleep = *h;
+	if(*h) {
+		(*h)->prev_sleep = current;
 	}
+	*h = current;
+	current->sleep_address = address;
 
+	signum = do_sleep(state);
 	RESTORE_FLAGS(flags);
 	return signum;
 }
@@ -115,33 +204,20 @@ int sleep(void *address, int state)
 void wakeup(void *address)
 {
 	unsigned int flags;
-	struct proc **h;
-	int i, found;
+	struct proc *p, *next;
+	int found;
 
 	SAVE_FLAGS(flags); CLI();
-	i = SLEEP_HASH((unsigned int)address);
-	h = &sleep_hash_table[i];
 	found = 0;
-
-	while(*h) {
-		if((*h)->sleep_address == address) {
-			(*h)->sleep_address = NULL;
-			(*h)->flags &= ~PF_NOTINTERRUPT;
-			(*h)->cpu_count = (*h)->priority;
-			runnable(*h);
+	p = sleep_hash_table[SLEEP_HASH((unsigned int)address)];
+	while(p) {
+		next = p->next_sleep;
+		if(p->sleep_address == address) {
+			remove_sleep_hash(p);
+			wake_proc(p);
 			found = 1;
-			if((*h)->next_sleep) {
-				(*h)->next_sleep->prev_sleep = (*h)->prev_sleep;
-			}
-			if((*h)->prev_sleep) {
-				(*h)->prev_sleep->next_sleep = (*h)->next_sleep;
-			}
-			if(h == &sleep_hash_table[i]) {	/* if it's the head */
-				*h = (*h)->next_sleep;
-			}
-			continue;
 		}
-		h = &(*h)->next_sleep;
+		p = next;
 	}
 	RESTORE_FLAGS(flags);
 	if(found) {
@@ -149,11 +225,78 @@ void wakeup(void *address)
 	}
 }
 
+static int sleep_on_queue(struct wait_queue *wq, int state, int exclusive)
+{
+	unsigned int flags;
+	int signum;
+
+	SAVE_FLAGS(flags); CLI();
+	if(!can_sleep(state, &signum)) {
+		RESTORE_FLAGS(flags);
+		return signum;
+	}
+	add_wait_queue(wq, current, exclusive);
+	signum = do_sleep(state);
+	RESTORE_FLAGS(flags);
+	return signum;
+}
+
+int sleep_on(struct wait_queue *wq, int state)
+{
+	return sleep_on_queue(wq, state, 0);
+}
+
+/*
+ * The exclusive sleepers are woken up one at a time, so they must always
+ * retry to take the object they wait for, or wake up the next one.
+ */
+int sleep_on_exclusive(struct wait_queue *wq, int state)
+{
+	return sleep_on_queue(wq, state, 1);
+}
+
+/* wake up all non-exclusive sleepers and the first exclusive one */
+void wake_up(struct wait_queue *wq)
+{
+	unsigned int flags;
+	struct proc *p;
+	int exclusive;
+
+	SAVE_FLAGS(flags); CLI();
+	if(!(p = wq->head)) {
+		RESTORE_FLAGS(flags);
+		return;
+	}
+	do {
+		exclusive = p->flags & PF_EXCLUSIVE;
+		remove_wait_queue(p);
+		wake_proc(p);
+	} while(!exclusive && (p = wq->head));
+	RESTORE_FLAGS(flags);
+	need_resched = 1;
+}
+
+void wake_up_all(struct wait_queue *wq)
+{
+	unsigned int flags;
+	struct proc *p;
+
+	SAVE_FLAGS(flags); CLI();
+	if(!(p = wq->head)) {
+		RESTORE_FLAGS(flags);
+		return;
+	}
+	do {
+		remove_wait_queue(p);
+		wake_proc(p);
+	} while((p = wq->head));
+	RESTORE_FLAGS(flags);
+	need_resched = 1;
+}
+
 void wakeup_proc(struct proc *p)
 {
 	unsigned int flags;
-	struct proc **h;
-	int i;
 
 	if(p->state != PROC_SLEEPING && p->state != PROC_STOPPED) {
 		return;
@@ -166,23 +309,12 @@ void wakeup_proc(struct proc *p)
 
 	SAVE_FLAGS(flags); CLI();
 
-	/* stopped processes don't have sleep address */
-	if(p->sleep_address) {
-		if(p->next_sleep) {
-			p->next_sleep->prev_sleep = p->prev_sleep;
-		}
-		if(p->prev_sleep) {
-			p->prev_sleep->next_sleep = p->next_sleep;
-		}
-
-		i = SLEEP_HASH((unsigned int)p->sleep_address);
-		h = &sleep_hash_table[i];
-
-		if(*h == p) {	/* if it's the head */
-			*h = (*h)->next_sleep;
-		}
+	/* stopped processes are neither in a wait queue nor in the hash */
+	if(p->sleep_queue) {
+		remove_wait_queue(p);
+	} else if(p->sleep_address) {
+		remove_sleep_hash(p);
 	}
-	p->sleep_address = NULL;
 	p->cpu_count = p->priority;
 	runnable(p);
 	need_resched = 1;
@@ -190,19 +322,18 @@ void wakeup_proc(struct proc *p)
 	RESTORE_FLAGS(flags);
 }
 
+/*
+ * The lock is handed off to a single waiter at a time. A waiter that finds
+ * it taken again by someone else goes back to sleep, and it will be woken
+ * up when that one releases the lock.
+ */
 void lock_resource(struct resource *resource)
 {
 	unsigned int flags;
 
-	for(;;) {
-		SAVE_FLAGS(flags); CLI();
-		if(resource->locked) {
-			resource->wanted = 1;
-			RESTORE_FLAGS(flags);
-			sleep(resource, PROC_UNINTERRUPTIBLE);
-		} else {
-			break;
-		}
+	SAVE_FLAGS(flags); CLI();
+	while(resource->locked) {
+		sleep_on_exclusive(&resource->wait, PROC_UNINTERRUPTIBLE);
 	}
 	resource->locked = 1;
 	RESTORE_FLAGS(flags);
@@ -214,10 +345,7 @@ void unlock_resource(struct resource *resource)
 
 	SAVE_FLAGS(flags); CLI();
 	resource->locked = 0;
-	if(resource->wanted) {
-		resource->wanted = 0;
-		wakeup(resource);
-	}
+	wake_up(&resource->wait);
 	RESTORE_FLAGS(flags);
 }
 
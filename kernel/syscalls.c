@@ -323,7 +323,7 @@ void *syscall_table[] = {
 #endif /* CONFIG_SYSVIPC */
 	sys_fsync,
 	sys_sigreturn,
-	NULL,	/* sys_clone */		/* 120 */
+	sys_clone,			/* 120 */
 	sys_setdomainname,
 	sys_newuname,
 	NULL,	/* sys_modify_ldt */
@@ -357,21 +357,21 @@ void *syscall_table[] = {
 	NULL,	/* sys_munlock */
 	NULL,	/* sys_mlockall */
 	NULL,	/* sys_munlockall */
-	NULL,	/* sys_sched_setparam */
-	NULL,	/* sys_sched_getparam */	/* 155 */
-	NULL,	/* sys_sched_setscheduler */
-	NULL,	/* sys_sched_getscheduler */
-	NULL,	/* sys_sched_yield */
-	NULL,	/* sys_sched_get_priority_max */
-	NULL,	/* sys_sched_get_priority_min */	/* 160 */
-	NULL,	/* sys_sched_rr_get_interval */
+	sys_sched_setparam,
+	sys_sched_getparam,		/* 155 */
+	sys_sched_setscheduler,
+	sys_sched_getscheduler,
+	sys_sched_yield,
+	sys_sched_get_priority_max,
+	sys_sched_get_priority_min,	/* 160 */
+	sys_sched_rr_get_interval,
 	sys_nanosleep,
 	NULL,	/* sys_mremap */
 	NULL,
 	NULL,				/* 165 */
 	NULL,
 	NULL,
-	NULL,
+	sys_poll,
 	NULL,
 	NULL,				/* 170 */
 	NULL,
@@ -393,7 +393,7 @@ void *syscall_table[] = {
 	NULL,
 	NULL,
 	NULL,
-	sys_fork,			/* 190 (sys_vfork) */
+	sys_vfork,			/* 190 */
 	NULL,
 #ifdef CONFIG_MMAP2
 	sys_mmap2,
@@ -461,9 +461,9 @@ void *syscall_table[] = {
 	NULL,
 	NULL,
 	NULL,
-	NULL,
-	NULL,				/* 255 */
-	NULL,
+	sys_epoll_create,
+	sys_epoll_ctl,			/* 255 */
+	sys_epoll_wait,
 	NULL,
 	NULL,
 	NULL,
@@ -472,13 +472,51 @@ void *syscall_table[] = {
 	NULL,
 	NULL,
 	NULL,
-	NULL,				/* 265 */
-	NULL,
+	sys_clock_gettime,		/* 265 */
+	sys_clock_getres,
 	NULL,
 	NULL,
 	NULL,
 	NULL,				/* 270 */
 	sys_utimes,
+	NULL,
+	NULL,
+	NULL,
+	NULL,				/* 275 */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,				/* 280 */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,				/* 285 */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,				/* 290 */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,				/* 295 */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,				/* 300 */
+	NULL,
+	NULL,
+	NULL,
+	NULL,
+	NULL,				/* 305 */
+	NULL,
+	NULL,
+	NULL,
+	sys_ppoll,
 };
 
 static void do_bad_syscall(unsigned int num)
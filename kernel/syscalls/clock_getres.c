@@ -0,0 +1,37 @@
+/*
+ * fiwix/kernel/syscalls/clock_getres.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/fs.h>
+#include <fiwix/time.h>
+#include <fiwix/clock.h>
+#include <fiwix/errno.h>
+
+#ifdef __DEBUG__
+#include <fiwix/stdio.h>
+#include <fiwix/process.h>
+#endif /*__DEBUG__ */
+
+int sys_clock_getres(int clock_id, struct timespec *res)
+{
+	int errno;
+
+#ifdef __DEBUG__
+	printk("(pid %d) sys_clock_getres(%d, 0x%08x)\n", current->pid, clock_id, (unsigned int)res);
+#endif /*__DEBUG__ */
+
+	if(clock_id != CLOCK_REALTIME && clock_id != CLOCK_MONOTONIC) {
+		return -EINVAL;
+	}
+	if(res) {
+		if((errno = check_user_area(VERIFY_WRITE, res, sizeof(struct timespec)))) {
+			return errno;
+		}
+		res->tv_sec = 0;
+		res->tv_nsec = clocksource->resolution;
+	}
+	return 0;
+}
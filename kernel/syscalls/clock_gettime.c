@@ -0,0 +1,40 @@
+/*
+ * fiwix/kernel/syscalls/clock_gettime.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/fs.h>
+#include <fiwix/time.h>
+#include <fiwix/clock.h>
+#include <fiwix/errno.h>
+
+#ifdef __DEBUG__
+#include <fiwix/stdio.h>
+#include <fiwix/process.h>
+#endif /*__DEBUG__ */
+
+int sys_clock_gettime(int clock_id, struct timespec *tp)
+{
+	int errno;
+
+#ifdef __DEBUG__
+	printk("(pid %d) sys_clock_gettime(%d, 0x%08x)\n", current->pid, clock_id, (unsigned int)tp);
+#endif /*__DEBUG__ */
+
+	if((errno = check_user_area(VERIFY_WRITE, tp, sizeof(struct timespec)))) {
+		return errno;
+	}
+	switch(clock_id) {
+		case CLOCK_REALTIME:
+			get_real_time(tp);
+			break;
+		case CLOCK_MONOTONIC:
+			get_monotonic_time(tp);
+			break;
+		default:
+			return -EINVAL;
+	}
+	return 0;
+}
@@ -0,0 +1,43 @@
+/*
+ * fiwix/kernel/syscalls/clone.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/types.h>
+#include <fiwix/sigcontext.h>
+#include <fiwix/process.h>
+#include <fiwix/errno.h>
+
+#ifdef __DEBUG__
+#include <fiwix/stdio.h>
+#endif /*__DEBUG__ */
+
+#ifdef CONFIG_SYSCALL_6TH_ARG
+int sys_clone(unsigned int flags, unsigned int newsp, int arg3, int arg4, int arg5, int arg6, struct sigcontext *sc)
+#else
+int sys_clone(unsigned int flags, unsigned int newsp, int arg3, int arg4, int arg5, struct sigcontext *sc)
+#endif /* CONFIG_SYSCALL_6TH_ARG */
+{
+#ifdef __DEBUG__
+	printk("(pid %d) sys_clone(0x%08x, 0x%08x)\n", current->pid, flags, newsp);
+#endif /*__DEBUG__ */
+
+	/* the exit signal is always SIGCHLD */
+	flags &= ~CSIGNAL;
+
+	/*
+	 * The descriptor table and the signal handlers can be shared, but the
+	 * filesystem information is kept inside each process. The address
+	 * space can only be borrowed while the parent is suspended (vfork), as
+	 * there are no threads sharing it.
+	 */
+	if(flags & ~(CLONE_VM | CLONE_FILES | CLONE_SIGHAND | CLONE_VFORK)) {
+		return -EINVAL;
+	}
+	if((flags & CLONE_VM) && !(flags & CLONE_VFORK)) {
+		return -EINVAL;
+	}
+	return do_fork(flags, newsp, sc);
+}
@@ -31,7 +31,7 @@ int sys_dup(unsigned int ufd)
 	printk(" -> %d\n", new_ufd);
 #endif /*__DEBUG__ */
 
-	current->fd[new_ufd] = current->fd[ufd];
-	fd_table[current->fd[new_ufd]].count++;
+	current->files->fd[new_ufd] = current->files->fd[ufd];
+	fd_table[current->files->fd[new_ufd]].count++;
 	return new_ufd;
 }
@@ -0,0 +1,74 @@
+/*
+ * fiwix/kernel/syscalls/epoll_ctl.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/fs.h>
+#include <fiwix/eventpoll.h>
+#include <fiwix/errno.h>
+#include <fiwix/stdio.h>
+#include <fiwix/string.h>
+
+int sys_epoll_ctl(int epfd, int op, int ufd, struct epoll_event *event)
+{
+	struct inode *i;
+	struct eventpoll *ep;
+	struct epitem *item;
+	struct fd *f;
+	struct epoll_event ev;
+	int errno;
+
+#ifdef __DEBUG__
+	printk("(pid %d) sys_epoll_ctl(%d, %d, %d, 0x%08x)\n", current->pid, epfd, op, ufd, (int)event);
+#endif /*__DEBUG__ */
+
+	CHECK_UFD(epfd);
+	CHECK_UFD(ufd);
+	i = fd_table[current->files->fd[epfd]].inode;
+	if(i->fsop != &epollfs_fsop) {
+		return -EINVAL;
+	}
+	ep = &i->u.epollfs.ep;
+	f = &fd_table[current->files->fd[ufd]];
+
+	/* nested instances are not supported */
+	if(f->inode->fsop == &epollfs_fsop) {
+		return -EINVAL;
+	}
+	if(!f->inode->fsop || !f->inode->fsop->select) {
+		return -EPERM;
+	}
+
+	if(op != EPOLL_CTL_DEL) {
+		if((errno = check_user_area(VERIFY_READ, event, sizeof(struct epoll_event)))) {
+			return errno;
+		}
+		memcpy_b(&ev, event, sizeof(struct epoll_event));
+	}
+
+	item = ep_find(ep, f);
+	switch(op) {
+		case EPOLL_CTL_ADD:
+			if(item) {
+				return -EEXIST;
+			}
+			return ep_insert(ep, f, &ev);
+		case EPOLL_CTL_DEL:
+			if(!item) {
+				return -ENOENT;
+			}
+			ep_remove(item);
+			break;
+		case EPOLL_CTL_MOD:
+			if(!item) {
+				return -ENOENT;
+			}
+			ep_modify(item, &ev);
+			break;
+		default:
+			return -EINVAL;
+	}
+	return 0;
+}
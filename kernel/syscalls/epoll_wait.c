@@ -0,0 +1,49 @@
+/*
+ * fiwix/kernel/syscalls/epoll_wait.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/fs.h>
+#include <fiwix/eventpoll.h>
+#include <fiwix/timer.h>
+#include <fiwix/errno.h>
+#include <fiwix/stdio.h>
+
+int sys_epoll_wait(int epfd, struct epoll_event *events, int maxevents, int timeout)
+{
+	struct inode *i;
+	struct timeval tv;
+	unsigned int t;
+	int errno;
+
+#ifdef __DEBUG__
+	printk("(pid %d) sys_epoll_wait(%d, 0x%08x, %d, %d)\n", current->pid, epfd, (int)events, maxevents, timeout);
+#endif /*__DEBUG__ */
+
+	CHECK_UFD(epfd);
+	i = fd_table[current->files->fd[epfd]].inode;
+	if(i->fsop != &epollfs_fsop) {
+		return -EINVAL;
+	}
+	if(maxevents <= 0 || maxevents > 0x7FFFFFFF / sizeof(struct epoll_event)) {
+		return -EINVAL;
+	}
+	if((errno = check_user_area(VERIFY_WRITE, events, maxevents * sizeof(struct epoll_event)))) {
+		return errno;
+	}
+
+	if(timeout < 0) {
+		t = INFINITE_WAIT;
+	} else {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		t = tv2ticks(&tv);
+	}
+
+	start_timeout(t);
+	errno = ep_poll(&i->u.epollfs.ep, events, maxevents);
+	stop_timeout();
+	return errno;
+}
@@ -353,14 +353,19 @@ int sys_execve(const char *filename, char *argv[], char *envp[], int arg4, int a
 	if((errno = malloc_name(filename, &tmp_name)) < 0) {
 		return errno;
 	}
+	/* the new program doesn't share the descriptors nor the handlers */
+	if(unshare_user_fd_table() || (current->sighand->count > 1 && dup_sighand_table(current, current))) {
+		free_name(tmp_name);
+		return -ENOMEM;
+	}
 	if((errno = do_execve(tmp_name, &(*argv), &(*envp), sc))) {
 		free_name(tmp_name);
 		return errno;
 	}
 
 	strncpy(current->argv0, tmp_name, NAME_MAX);
-	for(n = 0; n < OPEN_MAX; n++) {
-		if(current->fd[n] && (current->fd_flags[n] & FD_CLOEXEC)) {
+	for(n = 0; n < current->files->fd_max; n++) {
+		if(current->files->fd[n] && (current->files->fd_flags[n] & FD_CLOEXEC)) {
 			sys_close(n);
 		}
 	}
@@ -370,10 +375,10 @@ int sys_execve(const char *filename, char *argv[], char *envp[], int arg4, int a
 	current->sigpending = 0;
 	current->sigexecuting = 0;
 	for(n = 0; n < NSIG; n++) {
-		current->sigaction[n].sa_mask = 0;
-		current->sigaction[n].sa_flags = 0;
-		if(current->sigaction[n].sa_handler != SIG_IGN) {
-			current->sigaction[n].sa_handler = SIG_DFL;
+		current->sighand->action[n].sa_mask = 0;
+		current->sighand->action[n].sa_flags = 0;
+		if(current->sighand->action[n].sa_handler != SIG_IGN) {
+			current->sighand->action[n].sa_handler = SIG_DFL;
 		}
 	}
 	current->sleep_address = NULL;
@@ -10,8 +10,10 @@
 #include <fiwix/syscalls.h>
 #include <fiwix/process.h>
 #include <fiwix/sched.h>
+#include <fiwix/mm.h>
 #include <fiwix/mman.h>
 #include <fiwix/sleep.h>
+#include <fiwix/timer.h>
 #include <fiwix/stdio.h>
 #include <fiwix/string.h>
 #include <fiwix/buffer.h>
@@ -23,7 +25,7 @@
 void do_exit(int exit_code)
 {
 	int n;
-	struct proc *p, *init;
+	struct proc *p, *next, *init;
 
 #ifdef __DEBUG__
 	printk("\n");
@@ -37,46 +39,54 @@ void do_exit(int exit_code)
 	}
 #endif /* CONFIG_SYSVIPC */
 
+	if(current->flags & PF_VFORK) {
+		release_vfork(kpage_dir);
+	}
 	release_binary();
 	current->argv = NULL;
 	current->envp = NULL;
 
 	init = &proc_table[INIT];
-	FOR_EACH_PROCESS(p) {
-		if(SESS_LEADER(current)) {
-			if(p->sid == current->sid && p->state != PROC_ZOMBIE) {
-				p->pgid = 0;
-				p->sid = 0;
+	if(SESS_LEADER(current)) {
+		p = first_in_session(current->sid);
+		while(p) {
+			next = next_in_session(p);
+			if(p->state != PROC_ZOMBIE) {
+				set_pgid(p, 0);
+				set_sid(p, 0);
 				p->ctty = NULL;
 				send_sig(p, SIGHUP);
 				send_sig(p, SIGCONT);
 			}
+			p = next;
 		}
+	}
 
-		/* make INIT inherit the children of this exiting process */
-		if(p->ppid == current) {
-			p->ppid = init;
-			init->children++;
-			current->children--;
-			if(p->state == PROC_ZOMBIE) {
-				send_sig(init, SIGCHLD);
-				if(init->sleep_address == &sys_wait4) {
-					wakeup_proc(init);
-				}
+	/* make INIT inherit the children of this exiting process */
+	while((p = current->first_child)) {
+		remove_child(p);
+		add_child(init, p);
+		if(p->state == PROC_ZOMBIE) {
+			send_sig(init, SIGCHLD);
+			if(init->sleep_address == &sys_wait4) {
+				wakeup_proc(init);
 			}
 		}
-		p = p->next;
 	}
 
 	if(SESS_LEADER(current)) {
 		disassociate_ctty(current->ctty);
 	}
 
-	for(n = 0; n < OPEN_MAX; n++) {
-		if(current->fd[n]) {
-			sys_close(n);
+	/* the descriptors shared with other processes are kept for them */
+	if(current->files->count == 1) {
+		for(n = 0; n < current->files->fd_max; n++) {
+			if(current->files->fd[n]) {
+				sys_close(n);
+			}
 		}
 	}
+	free_user_fd_table(current);
 
 	iput(current->root);
 	current->root = NULL;
@@ -99,13 +109,17 @@ void do_exit(int exit_code)
 		wakeup_proc(p);
 	}
 
+	del_timer(&current->timeout_timer);
+	hrtimer_cancel(&current->it_real_timer);
 	current->sigpending = 0;
 	current->sigblocked = 0;
 	current->sigexecuting = 0;
-	for(n = 0; n < NSIG; n++) {
-		current->sigaction[n].sa_mask = 0;
-		current->sigaction[n].sa_flags = 0;
-		current->sigaction[n].sa_handler = SIG_IGN;
+	if(current->sighand->count == 1) {
+		for(n = 0; n < NSIG; n++) {
+			current->sighand->action[n].sa_mask = 0;
+			current->sighand->action[n].sa_flags = 0;
+			current->sighand->action[n].sa_handler = SIG_IGN;
+		}
 	}
 
 	not_runnable(current, PROC_ZOMBIE);
@@ -25,7 +25,7 @@ int sys_fchmod(unsigned int ufd, __mode_t mode)
 #endif /*__DEBUG__ */
 
 	CHECK_UFD(ufd);
-	i = fd_table[current->fd[ufd]].inode;
+	i = fd_table[current->files->fd[ufd]].inode;
 
 	if(IS_RDONLY_FS(i)) {
 		return -EROFS;
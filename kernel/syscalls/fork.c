@@ -14,6 +14,7 @@
 #include <fiwix/sched.h>
 #include <fiwix/sleep.h>
 #include <fiwix/mm.h>
+#include <fiwix/mman.h>
 #include <fiwix/errno.h>
 #include <fiwix/stdio.h>
 #include <fiwix/string.h>
@@ -26,45 +27,75 @@ static void free_vma_table(struct proc *p)
 	while(vma) {
 		tmp = vma;
 		vma = vma->next;
-		kfree((unsigned int)tmp);
+		kmem_cache_free(vma_cache, (unsigned int)tmp);
 	}
 }
 
-#ifdef CONFIG_SYSCALL_6TH_ARG
-int sys_fork(int arg1, int arg2, int arg3, int arg4, int arg5, int arg6, struct sigcontext *sc)
-#else
-int sys_fork(int arg1, int arg2, int arg3, int arg4, int arg5, struct sigcontext *sc)
-#endif /* CONFIG_SYSCALL_6TH_ARG */
+/* returns the pending signal that will kill the current process, if any */
+static int fatal_signal(void)
+{
+	__sigset_t signum;
+	unsigned int mask, pending;
+
+	pending = current->sigpending & ~current->sigblocked;
+	for(signum = 1, mask = 1; signum < NSIG; signum++, mask <<= 1) {
+		if(!(pending & mask)) {
+			continue;
+		}
+		if(signum == SIGKILL) {
+			return signum;
+		}
+		if(current->sighand->action[signum - 1].sa_handler != SIG_DFL) {
+			continue;
+		}
+		switch(signum) {
+			case SIGCONT:
+			case SIGWINCH:
+			case SIGCHLD:
+			case SIGURG:
+			case SIGSTOP:
+			case SIGTSTP:
+			case SIGTTIN:
+			case SIGTTOU:
+				break;
+			default:
+				return signum;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Creates a copy of the current process. With CLONE_VM the child doesn't get
+ * a copy of the address space but it borrows the one of the parent, which
+ * remains suspended until the child calls execve() or exits (vfork).
+ */
+int do_fork(unsigned int flags, unsigned int newsp, struct sigcontext *sc)
 {
-	int count, pages;
+	int pages;
 	unsigned int n;
 	unsigned int *child_pgdir;
 	struct sigcontext *stack;
-	struct proc *child, *p;
+	struct proc *child;
 	struct vma *vma, *child_vma;
+	__sigset_t sigblocked;
 	__pid_t pid;
 
-#ifdef __DEBUG__
-	printk("(pid %d) sys_fork()\n", current->pid);
-#endif /*__DEBUG__ */
-
 	/* check the number of processes already allocated by this UID */
-	count = 0;
-	FOR_EACH_PROCESS(p) {
-		if(p->uid == current->uid) {
-			count++;
-		}
-		p = p->next;
-	}
-	if(count > current->rlim[RLIMIT_NPROC].rlim_cur) {
+	if(get_uid_procs(current->uid) > current->rlim[RLIMIT_NPROC].rlim_cur) {
 		printk("WARNING: %s(): RLIMIT_NPROC exceeded.\n", __FUNCTION__);
 		return -EAGAIN;
 	}
 
+	if(add_uid_proc(current->uid)) {
+		return -EAGAIN;
+	}
 	if(!(pid = get_unused_pid())) {
+		del_uid_proc(current->uid);
 		return -EAGAIN;
 	}
 	if(!(child = get_proc_free())) {
+		del_uid_proc(current->uid);
 		return -EAGAIN;
 	}
 
@@ -77,44 +108,76 @@ int sys_fork(int arg1, int arg2, int arg3, int arg4, int arg5, struct sigcontext
 	proc_slot_init(child);
 	child->pid = pid;
 	sprintk(child->pidstr, "%d", child->pid);
+	hash_proc(child);
 
-	if(!(child_pgdir = (void *)kmalloc(PAGE_SIZE))) {
+	/* the tables of the parent are not referenced yet */
+	child->files = NULL;
+	child->sighand = NULL;
+	if(flags & CLONE_FILES) {
+		child->files = current->files;
+		child->files->count++;
+	} else if(dup_user_fd_table(child, current)) {
+		release_proc(child);
+		return -ENOMEM;
+	}
+	if(flags & CLONE_SIGHAND) {
+		child->sighand = current->sighand;
+		child->sighand->count++;
+	} else if(dup_sighand_table(child, current)) {
 		release_proc(child);
 		return -ENOMEM;
 	}
-	child->rss++;
-	memcpy_b(child_pgdir, kpage_dir, PAGE_SIZE);
-	child->tss.cr3 = V2P((unsigned int)child_pgdir);
 
-	child->ppid = current;
+	child->first_child = NULL;
 	child->flags = 0;
 	child->children = 0;
 	child->cpu_count = (current->cpu_count >>= 1);
 	child->start_time = CURRENT_TICKS;
 	child->sleep_address = NULL;
+	child->vfork_wait.head = child->vfork_wait.tail = NULL;
 
-	vma = current->vma_table;
-	child->vma_table = NULL;
-	while(vma) {
-		if(!(child_vma = (struct vma *)kmalloc(sizeof(struct vma)))) {
-			kfree((unsigned int)child_pgdir);
-			free_vma_table(child);
+	child_pgdir = NULL;
+	if(flags & CLONE_VM) {
+		/* the parent has no address space until the child gives it back */
+		child->flags |= PF_VFORK;
+		child->tss.cr3 = current->tss.cr3;
+		child->vma_table = current->vma_table;
+		child->vma_root = current->vma_root;
+		child->vma_last = current->vma_last;
+	} else {
+		if(!(child_pgdir = (void *)kmalloc(PAGE_SIZE))) {
 			release_proc(child);
 			return -ENOMEM;
 		}
-		*child_vma = *vma;
-		child_vma->prev = child_vma->next = NULL;
-		if(child_vma->inode) {
-			child_vma->inode->count++;
-		}
-		if(!child->vma_table) {
-			child->vma_table = child_vma;
-		} else {
-			child_vma->prev = child->vma_table->prev;
-			child->vma_table->prev->next = child_vma;
+		child->rss++;
+		memcpy_b(child_pgdir, kpage_dir, PAGE_SIZE);
+		child->tss.cr3 = V2P((unsigned int)child_pgdir);
+
+		vma = current->vma_table;
+		child->vma_table = NULL;
+		child->vma_root = child->vma_last = NULL;
+		while(vma) {
+			if(!(child_vma = (struct vma *)kmem_cache_alloc(vma_cache))) {
+				kfree((unsigned int)child_pgdir);
+				free_vma_table(child);
+				release_proc(child);
+				return -ENOMEM;
+			}
+			*child_vma = *vma;
+			child_vma->prev = child_vma->next = NULL;
+			if(child_vma->inode) {
+				child_vma->inode->count++;
+			}
+			if(!child->vma_table) {
+				child->vma_table = child_vma;
+			} else {
+				child_vma->prev = child->vma_table->prev;
+				child->vma_table->prev->next = child_vma;
+			}
+			child->vma_table->prev = child_vma;
+			vma = vma->next;
 		}
-		child->vma_table->prev = child_vma;
-		vma = vma->next;
+		vma_tree_build(child);
 	}
 
 	child->sigpending = 0;
@@ -122,8 +185,7 @@ int sys_fork(int arg1, int arg2, int arg3, int arg4, int arg5, struct sigcontext
 	memset_b(&child->sc, 0, sizeof(struct sigcontext));
 	memset_b(&child->usage, 0, sizeof(struct rusage));
 	memset_b(&child->cusage, 0, sizeof(struct rusage));
-	child->it_real_interval = 0;
-	child->it_real_value = 0;
+	memset_b(&child->it_real_interval, 0, sizeof(struct timeval));
 	child->it_virt_interval = 0;
 	child->it_virt_value = 0;
 	child->it_prof_interval = 0;
@@ -134,22 +196,27 @@ int sys_fork(int arg1, int arg2, int arg3, int arg4, int arg5, struct sigcontext
 
 
 	if(!(child->tss.esp0 = kmalloc(PAGE_SIZE))) {
-		kfree((unsigned int)child_pgdir);
-		free_vma_table(child);
+		if(child_pgdir) {
+			kfree((unsigned int)child_pgdir);
+			free_vma_table(child);
+		}
 		release_proc(child);
 		return -ENOMEM;
 	}
 
-	if(!(pages = clone_pages(child))) {
-		printk("WARNING: %s(): not enough memory when cloning pages.\n", __FUNCTION__);
-		free_page_tables(child);
-		kfree((unsigned int)child_pgdir);
-		free_vma_table(child);
-		release_proc(child);
-		return -ENOMEM;
+	if(child_pgdir) {
+		if(!(pages = clone_pages(child))) {
+			printk("WARNING: %s(): not enough memory when cloning pages.\n", __FUNCTION__);
+			kfree(child->tss.esp0);
+			free_page_tables(child);
+			kfree((unsigned int)child_pgdir);
+			free_vma_table(child);
+			release_proc(child);
+			return -ENOMEM;
+		}
+		child->rss += pages;
+		invalidate_tlb();
 	}
-	child->rss += pages;
-	invalidate_tlb();
 
 	child->tss.esp0 += PAGE_SIZE - 4;
 	child->rss++;
@@ -161,11 +228,16 @@ int sys_fork(int arg1, int arg2, int arg3, int arg4, int arg5, struct sigcontext
 	child->tss.eip = (unsigned int)return_from_syscall;
 	child->tss.esp = (unsigned int)stack;
 	stack->eax = 0;		/* child returns 0 */
+	if(newsp) {
+		stack->oldesp = newsp;
+	}
 
-	/* increase file descriptors usage */
-	for(n = 0; n < OPEN_MAX; n++) {
-		if(current->fd[n]) {
-			fd_table[current->fd[n]].count++;
+	/* increase file descriptors usage, unless the table is shared */
+	if(!(flags & CLONE_FILES)) {
+		for(n = 0; n < child->files->fd_max; n++) {
+			if(child->files->fd[n]) {
+				fd_table[child->files->fd[n]].count++;
+			}
 		}
 	}
 	if(current->root) {
@@ -177,8 +249,44 @@ int sys_fork(int arg1, int arg2, int arg3, int arg4, int arg5, struct sigcontext
 
 	kstat.processes++;
 	nr_processes++;
-	current->children++;
+	add_child(current, child);
+	if(flags & CLONE_VM) {
+		current->vma_table = current->vma_root = current->vma_last = NULL;
+	}
 	runnable(child);
 
-	return child->pid;	/* parent returns child's PID */
+	/*
+	 * The parent can't return to user mode without its address space, so
+	 * only a signal that will kill it stops the wait. In that case the
+	 * child keeps the address space for itself. The other signals are
+	 * blocked until the wait ends, so they don't wake up the parent again.
+	 */
+	if(flags & CLONE_VFORK) {
+		sigblocked = current->sigblocked;
+		while(child->pid == pid && (child->flags & PF_VFORK)) {
+			if(sleep_on(&current->vfork_wait, PROC_INTERRUPTIBLE)) {
+				if(fatal_signal()) {
+					detach_vfork(child);
+					break;
+				}
+				current->sigblocked |= current->sigpending & SIG_MASK(SIGKILL);
+			}
+		}
+		current->sigblocked = sigblocked;
+	}
+
+	return pid;	/* parent returns child's PID */
+}
+
+#ifdef CONFIG_SYSCALL_6TH_ARG
+int sys_fork(int arg1, int arg2, int arg3, int arg4, int arg5, int arg6, struct sigcontext *sc)
+#else
+int sys_fork(int arg1, int arg2, int arg3, int arg4, int arg5, struct sigcontext *sc)
+#endif /* CONFIG_SYSCALL_6TH_ARG */
+{
+#ifdef __DEBUG__
+	printk("(pid %d) sys_fork()\n", current->pid);
+#endif /*__DEBUG__ */
+
+	return do_fork(0, 0, sc);
 }
@@ -29,7 +29,7 @@ int sys_fstat64(unsigned int ufd, struct stat64 *statbuf)
 	if((errno = check_user_area(VERIFY_WRITE, statbuf, sizeof(struct stat64)))) {
 		return errno;
 	}
-	i = fd_table[current->fd[ufd]].inode;
+	i = fd_table[current->files->fd[ufd]].inode;
 	statbuf->st_dev = i->dev;
 	statbuf->st_ino = i->inode;
 	statbuf->st_mode = i->i_mode;
@@ -7,6 +7,7 @@
 
 #include <fiwix/fs.h>
 #include <fiwix/time.h>
+#include <fiwix/timer.h>
 #include <fiwix/process.h>
 #include <fiwix/errno.h>
 
@@ -30,8 +31,7 @@ int sys_getitimer(int which, struct itimerval *curr_value)
 
 	switch(which) {
 		case ITIMER_REAL:
-			ticks2tv(current->it_real_interval, &curr_value->it_interval);
-			ticks2tv(current->it_real_value, &curr_value->it_value);
+			getitimer_real(curr_value);
 			break;
 		case ITIMER_VIRTUAL:
 			ticks2tv(current->it_virt_interval, &curr_value->it_interval);
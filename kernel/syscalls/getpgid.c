@@ -28,11 +28,8 @@ int sys_getpgid(__pid_t pid)
 	if(!pid) {
 		return current->pgid;
 	}
-	FOR_EACH_PROCESS(p) {
-		if(p->pid == pid) {
-			return p->pgid;
-		}
-		p = p->next;
+	if((p = get_proc_by_pid(pid))) {
+		return p->pgid;
 	}
 	return -ESRCH;
 }
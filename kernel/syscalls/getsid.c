@@ -29,11 +29,8 @@ int sys_getsid(__pid_t pid)
 		return current->sid;
 	}
 
-	FOR_EACH_PROCESS(p) {
-		if(p->pid == pid) {
-			return p->sid;
-		}
-		p = p->next;
+	if((p = get_proc_by_pid(pid))) {
+		return p->sid;
 	}
 	return -ESRCH;
 }
@@ -10,6 +10,7 @@
 #include <fiwix/process.h>
 #include <fiwix/time.h>
 #include <fiwix/timer.h>
+#include <fiwix/clock.h>
 
 #ifdef __DEBUG__
 #include <fiwix/stdio.h>
@@ -18,6 +19,7 @@
 int sys_gettimeofday(struct timeval *tv, struct timezone *tz)
 {
 	int errno;
+	struct timespec ts;
 
 #ifdef __DEBUG__
 	printk("(pid %d) sys_gettimeofday()\n", current->pid);
@@ -27,9 +29,9 @@ int sys_gettimeofday(struct timeval *tv, struct timezone *tz)
 		if((errno = check_user_area(VERIFY_WRITE, tv, sizeof(struct timeval)))) {
 			return errno;
 		}
-		tv->tv_sec = CURRENT_TIME;
-		tv->tv_usec = ((kstat.ticks % HZ) * 1000000) / HZ;
-		tv->tv_usec += gettimeoffset();
+		get_real_time(&ts);
+		tv->tv_sec = ts.tv_sec;
+		tv->tv_usec = ts.tv_nsec / NSEC_PER_USEC;
 	}
 	if(tz) {
 		if((errno = check_user_area(VERIFY_WRITE, tz, sizeof(struct timezone)))) {
@@ -5,8 +5,14 @@
  * Distributed under the terms of the Fiwix License.
  */
 
+#include <fiwix/asm.h>
 #include <fiwix/process.h>
+#include <fiwix/segments.h>
+#include <fiwix/sched.h>
+#include <fiwix/mm.h>
 #include <fiwix/errno.h>
+#include <fiwix/stddef.h>
+#include <fiwix/string.h>
 
 #ifdef __DEBUG__
 #include <fiwix/stdio.h>
@@ -17,9 +23,32 @@
  * the I/O address space. That is, up to 65536 I/O ports can be specified using
  * this system call, which makes sys_iopl() not needed anymore.
  */
+static int alloc_io_tss(void)
+{
+	unsigned int flags;
+	struct io_tss *io_tss;
+
+	if(!(io_tss = (struct io_tss *)kmalloc(sizeof(struct io_tss)))) {
+		return -ENOMEM;
+	}
+	memcpy_b(&io_tss->tss, &current->tss, sizeof(struct i386tss));
+	io_tss->tss.io_bitmap_addr = offsetof(struct io_tss, io_bitmap);
+	memset_l(io_tss->io_bitmap, ~0, IO_BITMAP_SIZE / sizeof(unsigned int));
+	io_tss->io_bitmap[IO_BITMAP_SIZE] = ~0;	/* extra byte must be all 1's */
+
+	/* switch to the new TSS right now */
+	SAVE_FLAGS(flags); CLI();
+	current->io_tss = io_tss;
+	set_tss(current);
+	load_tr(TSS);
+	RESTORE_FLAGS(flags);
+	return 0;
+}
+
 int sys_ioperm(unsigned int from, unsigned int num, int turn_on)
 {
 	unsigned int n;
+	int errno;
 
 #ifdef __DEBUG__
 	printk("(pid %d) sys_ioperm(0x%08x, 0x%08x, 0x%08x)\n", current->pid, from, num, turn_on);
@@ -44,11 +73,21 @@ int sys_ioperm(unsigned int from, unsigned int num, int turn_on)
 	 */
 	turn_on = !turn_on;
 
+	/* without a bitmap all ports are already denied */
+	if(!current->io_tss) {
+		if(turn_on) {
+			return 0;
+		}
+		if((errno = alloc_io_tss())) {
+			return errno;
+		}
+	}
+
 	for(n = from; n < (from + num); n++) {
 		if(!turn_on) {
-			current->tss.io_bitmap[n / 8] &= ~(1 << (n % 8));
+			current->io_tss->io_bitmap[n / 8] &= ~(1 << (n % 8));
 		} else {
-			current->tss.io_bitmap[n / 8] |= ~(1 << (n % 8));
+			current->io_tss->io_bitmap[n / 8] |= 1 << (n % 8);
 		}
 	}
 
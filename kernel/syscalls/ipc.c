@@ -20,7 +20,7 @@
 #endif /*__DEBUG__ */
 
 #ifdef CONFIG_SYSVIPC
-struct resource ipcmsg_resource = { 0, 0 };
+struct resource ipcmsg_resource = { 0 };
 
 void ipc_init(void)
 {
@@ -6,6 +6,7 @@
  */
 
 #include <fiwix/fs.h>
+#include <fiwix/dcache.h>
 #include <fiwix/stat.h>
 #include <fiwix/errno.h>
 #include <fiwix/string.h>
@@ -101,6 +102,7 @@ int sys_link(const char *oldname, const char *newname)
 
 	if(dir_new->fsop && dir_new->fsop->link) {
 		errno = dir_new->fsop->link(i, dir_new, basename);
+		dcache_remove(dir_new, basename);
 	} else {
 		errno = -EPERM;
 	}
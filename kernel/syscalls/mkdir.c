@@ -7,6 +7,7 @@
 
 #include <fiwix/types.h>
 #include <fiwix/fs.h>
+#include <fiwix/dcache.h>
 #include <fiwix/stat.h>
 #include <fiwix/errno.h>
 #include <fiwix/string.h>
@@ -57,6 +58,7 @@ int sys_mkdir(const char *dirname, __mode_t mode)
 	basename = get_basename(basename);
 	if(dir->fsop && dir->fsop->mkdir) {
 		errno = dir->fsop->mkdir(dir, basename, mode);
+		dcache_remove(dir, basename);
 	} else {
 		errno = -EPERM;
 	}
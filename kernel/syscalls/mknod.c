@@ -7,6 +7,7 @@
 
 #include <fiwix/types.h>
 #include <fiwix/fs.h>
+#include <fiwix/dcache.h>
 #include <fiwix/stat.h>
 #include <fiwix/errno.h>
 #include <fiwix/string.h>
@@ -44,6 +45,7 @@ int do_mknod(char *pathname, __mode_t mode, __dev_t dev)
 
 	if(dir->fsop && dir->fsop->mknod) {
 		errno = dir->fsop->mknod(dir, basename, mode, dev);
+		dcache_remove(dir, basename);
 	} else {
 		errno = -EPERM;
 	}
@@ -9,6 +9,7 @@
 #include <fiwix/fs.h>
 #include <fiwix/time.h>
 #include <fiwix/timer.h>
+#include <fiwix/clock.h>
 #include <fiwix/process.h>
 #include <fiwix/sched.h>
 #include <fiwix/sleep.h>
@@ -20,8 +21,9 @@
 
 int sys_nanosleep(const struct timespec *req, struct timespec *rem)
 {
-	int errno, nsec;
-	unsigned int timeout, flags;
+	int errno;
+	unsigned int timeout, rest, flags;
+	struct timespec deadline;
 
 #ifdef __DEBUG__
 	printk("(pid %d) sys_nanosleep(0x%08x, 0x%08x)\n", current->pid, (unsigned int)req, (unsigned int)rem);
@@ -33,40 +35,42 @@ int sys_nanosleep(const struct timespec *req, struct timespec *rem)
 	if(req->tv_sec < 0 || req->tv_nsec >= 1000000000L || req->tv_nsec < 0) {
 		return -EINVAL;
 	}
+	get_monotonic_time(&deadline);
+	timespec_add(&deadline, req);
 
 	/*
-	 * Since the current maximum precision of the kernel is only 10ms, we
-	 * need to convert any lower request to a minimum of 10ms, even knowing
-	 * that this might increase the sleep a bit more than the requested.
-	 */
-	nsec = req->tv_nsec;
-	if(nsec < 10000000L) {
-		nsec *= 10;
-	}
-
-	/*
-	 * Interrupts must be disabled before setting current->timeout in order
-	 * to avoid a race condition. Otherwise it might occur that timeout is
-	 * so small that it would reach zero before the call to sleep(). In this
-	 * case, the process would miss the wakeup() and would stay in the sleep
+	 * Interrupts must be disabled before starting the timeout in order to
+	 * avoid a race condition. Otherwise it might occur that timeout is so
+	 * small that it would expire before the call to sleep(). In this case,
+	 * the process would miss the wakeup() and would stay in the sleep
 	 * queue forever.
+	 *
+	 * The timeout can only expire on a tick, so the sleep lasts until the
+	 * first tick after the deadline. The real-time processes sleep until
+	 * the last tick before the deadline instead, and busy-wait the rest if
+	 * it's short enough.
 	 */
-	timeout = (req->tv_sec * HZ) + (nsec * HZ / 1000000000L);
+	SAVE_FLAGS(flags); CLI();
+	timeout = hrtimer_ticks(&deadline, &rest);
+	if(rest && (current->policy == SCHED_OTHER || rest > HRTIMER_SPIN_NSEC)) {
+		timeout++;
+	}
 	if(timeout) {
-		SAVE_FLAGS(flags); CLI();
-		current->timeout = timeout;
+		start_timeout(timeout);
 		sleep(&sys_nanosleep, PROC_INTERRUPTIBLE);
 		RESTORE_FLAGS(flags);
-		if(current->timeout) {
+		if(stop_timeout()) {
 			if(rem) {
 				if((errno = check_user_area(VERIFY_WRITE, rem, sizeof(struct timespec)))) {
 					return errno;
 				}
-				rem->tv_sec = current->timeout / HZ;
-				rem->tv_nsec = (current->timeout % HZ) * 1000000000L / HZ;
+				hrtimer_left(&deadline, rem);
 			}
 			return -EINTR;
 		}
+	} else {
+		RESTORE_FLAGS(flags);
 	}
+	hrtimer_spin(&deadline);
 	return 0;
 }
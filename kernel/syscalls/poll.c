@@ -0,0 +1,88 @@
+/*
+ * fiwix/kernel/syscalls/poll.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/types.h>
+#include <fiwix/fs.h>
+#include <fiwix/poll.h>
+#include <fiwix/process.h>
+#include <fiwix/timer.h>
+#include <fiwix/sched.h>
+#include <fiwix/sleep.h>
+#include <fiwix/errno.h>
+#include <fiwix/stdio.h>
+
+/* this must be called with the timeout of the current process started */
+int do_poll(struct pollfd *fds, unsigned int nfds)
+{
+	struct pollfd *p;
+	unsigned int n;
+	int count;
+
+	for(;;) {
+		count = 0;
+		for(n = 0; n < nfds; n++) {
+			p = &fds[n];
+			p->revents = 0;
+			if(p->fd < 0) {
+				continue;
+			}
+			if(p->fd >= current->files->fd_max || !current->files->fd[p->fd]) {
+				p->revents = POLLNVAL;
+				count++;
+				continue;
+			}
+			if((p->revents = poll_file(&fd_table[current->files->fd[p->fd]], (unsigned short int)p->events))) {
+				count++;
+			}
+		}
+
+		if(count || !current->timeout) {
+			break;
+		}
+		if(current->sigpending & ~current->sigblocked) {
+			return -EINTR;
+		}
+		if(sleep(&do_select, PROC_INTERRUPTIBLE)) {
+			return -EINTR;
+		}
+	}
+
+	return count;
+}
+
+int sys_poll(struct pollfd *fds, unsigned int nfds, int timeout)
+{
+	struct timeval tv;
+	unsigned int t;
+	int errno;
+
+#ifdef __DEBUG__
+	printk("(pid %d) sys_poll(0x%08x, %d, %d)\n", current->pid, (int)fds, nfds, timeout);
+#endif /*__DEBUG__ */
+
+	if(nfds > NR_OPENS) {
+		return -EINVAL;
+	}
+	if(nfds) {
+		if((errno = check_user_area(VERIFY_WRITE, fds, nfds * sizeof(struct pollfd)))) {
+			return errno;
+		}
+	}
+
+	if(timeout < 0) {
+		t = INFINITE_WAIT;
+	} else {
+		tv.tv_sec = timeout / 1000;
+		tv.tv_usec = (timeout % 1000) * 1000;
+		t = tv2ticks(&tv);
+	}
+
+	start_timeout(t);
+	errno = do_poll(fds, nfds);
+	stop_timeout();
+	return errno;
+}
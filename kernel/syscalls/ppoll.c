@@ -0,0 +1,67 @@
+/*
+ * fiwix/kernel/syscalls/ppoll.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/types.h>
+#include <fiwix/fs.h>
+#include <fiwix/poll.h>
+#include <fiwix/signal.h>
+#include <fiwix/process.h>
+#include <fiwix/timer.h>
+#include <fiwix/errno.h>
+#include <fiwix/stdio.h>
+
+int sys_ppoll(struct pollfd *fds, unsigned int nfds, const struct timespec *tmo, const __sigset_t *sigmask, __size_t sigsetsize)
+{
+	struct timeval tv;
+	__sigset_t old_mask;
+	unsigned int t;
+	int errno;
+
+#ifdef __DEBUG__
+	printk("(pid %d) sys_ppoll(0x%08x, %d, 0x%08x, 0x%08x, %d)\n", current->pid, (int)fds, nfds, (int)tmo, (int)sigmask, sigsetsize);
+#endif /*__DEBUG__ */
+
+	if(nfds > NR_OPENS) {
+		return -EINVAL;
+	}
+	if(nfds) {
+		if((errno = check_user_area(VERIFY_WRITE, fds, nfds * sizeof(struct pollfd)))) {
+			return errno;
+		}
+	}
+
+	if(tmo) {
+		if((errno = check_user_area(VERIFY_READ, tmo, sizeof(struct timespec)))) {
+			return errno;
+		}
+		if(tmo->tv_sec < 0 || tmo->tv_nsec >= 1000000000L || tmo->tv_nsec < 0) {
+			return -EINVAL;
+		}
+		tv.tv_sec = tmo->tv_sec;
+		tv.tv_usec = (tmo->tv_nsec + 999) / 1000;
+		t = tv2ticks(&tv);
+	} else {
+		t = INFINITE_WAIT;
+	}
+
+	old_mask = current->sigblocked;
+	if(sigmask) {
+		if(sigsetsize < sizeof(__sigset_t)) {
+			return -EINVAL;
+		}
+		if((errno = check_user_area(VERIFY_READ, sigmask, sizeof(__sigset_t)))) {
+			return errno;
+		}
+		current->sigblocked = *sigmask & SIG_BLOCKABLE;
+	}
+
+	start_timeout(t);
+	errno = do_poll(fds, nfds);
+	stop_timeout();
+	current->sigblocked = old_mask;
+	return errno;
+}
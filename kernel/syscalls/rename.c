@@ -6,6 +6,7 @@
  */
 
 #include <fiwix/fs.h>
+#include <fiwix/dcache.h>
 #include <fiwix/stat.h>
 #include <fiwix/errno.h>
 #include <fiwix/string.h>
@@ -102,6 +103,14 @@ int sys_rename(const char *oldpath, const char *newpath)
 
 	if(dir_new->fsop && dir_new->fsop->rename) {
 		errno = dir_new->fsop->rename(i, dir, i_new, dir_new, oldbasename, newbasename);
+		dcache_remove(dir, oldbasename);
+		dcache_remove(dir_new, newbasename);
+		if(S_ISDIR(i->i_mode)) {
+			dcache_remove(i, "..");
+		}
+		if(i_new && S_ISDIR(i_new->i_mode)) {
+			dcache_purge(i_new);
+		}
 	} else {
 		errno = -EPERM;
 	}
@@ -6,6 +6,7 @@
  */
 
 #include <fiwix/fs.h>
+#include <fiwix/dcache.h>
 #include <fiwix/stat.h>
 #include <fiwix/errno.h>
 
@@ -73,6 +74,7 @@ int sys_rmdir(const char *dirname)
 
 	if(i->fsop && i->fsop->rmdir) {
 		errno = i->fsop->rmdir(dir, i);
+		dcache_purge(i);
 	} else {
 		errno = -EPERM;
 	}
@@ -0,0 +1,31 @@
+/*
+ * fiwix/kernel/syscalls/sched_get_priority_max.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/types.h>
+#include <fiwix/process.h>
+#include <fiwix/sched.h>
+#include <fiwix/errno.h>
+
+#ifdef __DEBUG__
+#include <fiwix/stdio.h>
+#endif /*__DEBUG__ */
+
+int sys_sched_get_priority_max(int policy)
+{
+#ifdef __DEBUG__
+	printk("(pid %d) sys_sched_get_priority_max(%d)\n", current->pid, policy);
+#endif /*__DEBUG__ */
+
+	switch(policy) {
+		case SCHED_FIFO:
+		case SCHED_RR:
+			return MAX_RT_PRIO;
+		case SCHED_OTHER:
+			return 0;
+	}
+	return -EINVAL;
+}
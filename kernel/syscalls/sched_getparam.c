@@ -0,0 +1,40 @@
+/*
+ * fiwix/kernel/syscalls/sched_getparam.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/types.h>
+#include <fiwix/fs.h>
+#include <fiwix/process.h>
+#include <fiwix/sched.h>
+#include <fiwix/errno.h>
+
+#ifdef __DEBUG__
+#include <fiwix/stdio.h>
+#endif /*__DEBUG__ */
+
+int sys_sched_getparam(__pid_t pid, struct sched_param *param)
+{
+	struct proc *p;
+	int errno;
+
+#ifdef __DEBUG__
+	printk("(pid %d) sys_sched_getparam(%d, 0x%08x)\n", current->pid, pid, (unsigned int)param);
+#endif /*__DEBUG__ */
+
+	if(pid < 0) {
+		return -EINVAL;
+	}
+	if((errno = check_user_area(VERIFY_WRITE, param, sizeof(struct sched_param)))) {
+		return errno;
+	}
+	if(!pid) {
+		p = current;
+	} else if(!(p = get_proc_by_pid(pid))) {
+		return -ESRCH;
+	}
+	param->sched_priority = p->rt_priority;
+	return 0;
+}
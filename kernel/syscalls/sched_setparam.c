@@ -0,0 +1,35 @@
+/*
+ * fiwix/kernel/syscalls/sched_setparam.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/types.h>
+#include <fiwix/syscalls.h>
+#include <fiwix/process.h>
+#include <fiwix/sched.h>
+#include <fiwix/errno.h>
+
+#ifdef __DEBUG__
+#include <fiwix/stdio.h>
+#endif /*__DEBUG__ */
+
+int sys_sched_setparam(__pid_t pid, const struct sched_param *param)
+{
+	struct proc *p;
+
+#ifdef __DEBUG__
+	printk("(pid %d) sys_sched_setparam(%d, 0x%08x)\n", current->pid, pid, (unsigned int)param);
+#endif /*__DEBUG__ */
+
+	if(pid < 0) {
+		return -EINVAL;
+	}
+	if(!pid) {
+		p = current;
+	} else if(!(p = get_proc_by_pid(pid))) {
+		return -ESRCH;
+	}
+	return sys_sched_setscheduler(pid, p->policy, param);
+}
@@ -0,0 +1,63 @@
+/*
+ * fiwix/kernel/syscalls/sched_setscheduler.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/types.h>
+#include <fiwix/fs.h>
+#include <fiwix/process.h>
+#include <fiwix/sched.h>
+#include <fiwix/errno.h>
+
+#ifdef __DEBUG__
+#include <fiwix/stdio.h>
+#endif /*__DEBUG__ */
+
+int sys_sched_setscheduler(__pid_t pid, int policy, const struct sched_param *param)
+{
+	struct proc *p;
+	int errno;
+
+#ifdef __DEBUG__
+	printk("(pid %d) sys_sched_setscheduler(%d, %d, 0x%08x)\n", current->pid, pid, policy, (unsigned int)param);
+#endif /*__DEBUG__ */
+
+	if(pid < 0) {
+		return -EINVAL;
+	}
+	if((errno = check_user_area(VERIFY_READ, param, sizeof(struct sched_param)))) {
+		return errno;
+	}
+	if(!pid) {
+		p = current;
+	} else if(!(p = get_proc_by_pid(pid))) {
+		return -ESRCH;
+	}
+
+	switch(policy) {
+		case SCHED_OTHER:
+			if(param->sched_priority) {
+				return -EINVAL;
+			}
+			break;
+		case SCHED_FIFO:
+		case SCHED_RR:
+			if(param->sched_priority < MIN_RT_PRIO || param->sched_priority > MAX_RT_PRIO) {
+				return -EINVAL;
+			}
+			if(!IS_SUPERUSER) {
+				return -EPERM;
+			}
+			break;
+		default:
+			return -EINVAL;
+	}
+	if(!IS_SUPERUSER && current->euid != p->uid && current->euid != p->euid) {
+		return -EPERM;
+	}
+
+	set_scheduler(p, policy, param->sched_priority);
+	return 0;
+}
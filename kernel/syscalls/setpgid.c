@@ -46,11 +46,10 @@ int sys_setpgid(__pid_t pid, __pid_t pgid)
 	{
 		struct proc *p;
 
-		FOR_EACH_PROCESS(p) {
-			if(p->pgid == pgid && p->sid != current->sid) {
+		for(p = first_in_pgrp(pgid); p; p = next_in_pgrp(p)) {
+			if(p->sid != current->sid) {
 				return -EPERM;
 			}
-			p = p->next;
 		}
 	}
 
@@ -58,7 +57,7 @@ int sys_setpgid(__pid_t pid, __pid_t pgid)
 		return -EACCES;
 	}
 
-	p->pgid = pgid;
+	set_pgid(p, pgid);
 
 #ifdef __DEBUG__
 	printk(" -> 0\n");
@@ -27,7 +27,9 @@ int sys_setreuid(__uid_t uid, __uid_t euid)
 			current->euid = euid;
 		}
 		if(uid != (__uid_t)-1) {
-			current->uid = uid;
+			if(set_proc_uid(current, uid)) {
+				return -EAGAIN;
+			}
 		}
 	} else {
 		if(euid != (__uid_t)-1 && (current->uid == euid || current->euid == euid || current->suid == euid)) {
@@ -39,7 +41,9 @@ int sys_setreuid(__uid_t uid, __uid_t euid)
 			return -EPERM;
 		}
 		if(uid != (__uid_t)-1 && (current->uid == uid || current->euid == uid)) {
-			current->uid = uid;
+			if(set_proc_uid(current, uid)) {
+				return -EAGAIN;
+			}
 		} else {
 			return -EPERM;
 		}
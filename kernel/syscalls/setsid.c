@@ -24,14 +24,15 @@ int sys_setsid(void)
 	if(PG_LEADER(current)) {
 		return -EPERM;
 	}
-	FOR_EACH_PROCESS(p) {	/* POSIX ANSI/IEEE Std 1003.1-1996 4.3.2 */
-		if(p != current && p->pgid == current->pid) {
+	/* POSIX ANSI/IEEE Std 1003.1-1996 4.3.2 */
+	for(p = first_in_pgrp(current->pid); p; p = next_in_pgrp(p)) {
+		if(p != current) {
 			return -EPERM;
 		}
-		p = p->next;
 	}
 
-	current->sid = current->pgid = current->pid;
+	set_sid(current, current->pid);
+	set_pgid(current, current->pid);
 	current->ctty = NULL;
 	return current->sid;
 }
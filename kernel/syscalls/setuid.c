@@ -20,7 +20,10 @@ int sys_setuid(__uid_t uid)
 #endif /*__DEBUG__ */
 
 	if(IS_SUPERUSER) {
-		current->uid = current->suid = uid;
+		if(set_proc_uid(current, uid)) {
+			return -EAGAIN;
+		}
+		current->suid = uid;
 	} else {
 		if((current->uid != uid) && (current->suid != uid)) {
 			return -EPERM;
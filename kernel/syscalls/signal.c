@@ -40,14 +40,14 @@ unsigned int sys_signal(__sigset_t signum, void(* sighandler)(int))
 	s.sa_handler = sighandler;
 	s.sa_mask = 0;
 	s.sa_flags = SA_RESETHAND;
-	sighandler = current->sigaction[signum - 1].sa_handler;
-	current->sigaction[signum - 1] = s;
-	if(current->sigaction[signum - 1].sa_handler == SIG_IGN) {
+	sighandler = current->sighand->action[signum - 1].sa_handler;
+	current->sighand->action[signum - 1] = s;
+	if(current->sighand->action[signum - 1].sa_handler == SIG_IGN) {
 		if(signum != SIGCHLD) {
 			current->sigpending &= SIG_MASK(signum);
 		}
 	}
-	if(current->sigaction[signum - 1].sa_handler == SIG_DFL) {
+	if(current->sighand->action[signum - 1].sa_handler == SIG_DFL) {
 		if(signum != SIGCHLD) {
 			current->sigpending &= SIG_MASK(signum);
 		}
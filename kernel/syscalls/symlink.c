@@ -6,6 +6,7 @@
  */
 
 #include <fiwix/fs.h>
+#include <fiwix/dcache.h>
 #include <fiwix/stat.h>
 #include <fiwix/errno.h>
 #include <fiwix/string.h>
@@ -63,6 +64,7 @@ int sys_symlink(const char *oldpath, const char *newpath)
 
 	if(dir->fsop && dir->fsop->symlink) {
 		errno = dir->fsop->symlink(dir, basename, tmp_oldpath);
+		dcache_remove(dir, basename);
 	} else {
 		errno = -EPERM;
 	}
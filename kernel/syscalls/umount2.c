@@ -7,6 +7,7 @@
 
 #include <fiwix/types.h>
 #include <fiwix/fs.h>
+#include <fiwix/dcache.h>
 #include <fiwix/filesystems.h>
 #include <fiwix/stat.h>
 #include <fiwix/sleep.h>
@@ -16,7 +17,7 @@
 #include <fiwix/stdio.h>
 #include <fiwix/string.h>
 
-static struct resource umount_resource = { 0, 0 };
+static struct resource umount_resource = { 0 };
 
 int sys_umount2(const char *target, int flags)
 {
@@ -108,6 +109,7 @@ int sys_umount2(const char *target, int flags)
 	sync_buffers(dev);
 	invalidate_buffers(dev);
 	invalidate_inodes(dev);
+	invalidate_dentries(dev);
 
 	del_mount_point(mp);
 	unlock_resource(&umount_resource);
@@ -6,6 +6,7 @@
  */
 
 #include <fiwix/fs.h>
+#include <fiwix/dcache.h>
 #include <fiwix/syscalls.h>
 #include <fiwix/stat.h>
 #include <fiwix/errno.h>
@@ -68,6 +69,7 @@ int sys_unlink(const char *filename)
 	basename = get_basename(filename);
 	if(dir->fsop && dir->fsop->unlink) {
 		errno = dir->fsop->unlink(dir, i, basename);
+		dcache_remove(dir, basename);
 	} else {
 		errno = -EPERM;
 	}
@@ -0,0 +1,27 @@
+/*
+ * fiwix/kernel/syscalls/vfork.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+#include <fiwix/types.h>
+#include <fiwix/sigcontext.h>
+#include <fiwix/process.h>
+
+#ifdef __DEBUG__
+#include <fiwix/stdio.h>
+#endif /*__DEBUG__ */
+
+#ifdef CONFIG_SYSCALL_6TH_ARG
+int sys_vfork(int arg1, int arg2, int arg3, int arg4, int arg5, int arg6, struct sigcontext *sc)
+#else
+int sys_vfork(int arg1, int arg2, int arg3, int arg4, int arg5, struct sigcontext *sc)
+#endif /* CONFIG_SYSCALL_6TH_ARG */
+{
+#ifdef __DEBUG__
+	printk("(pid %d) sys_vfork()\n", current->pid);
+#endif /*__DEBUG__ */
+
+	return do_fork(CLONE_VM | CLONE_VFORK, 0, sc);
+}
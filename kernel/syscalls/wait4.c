@@ -34,11 +34,7 @@ int sys_wait4(__pid_t pid, int *status, int options, struct rusage *ru)
 	}
 	while(current->children) {
 		flag = 0;
-		FOR_EACH_PROCESS(p) {
-			if(p->ppid != current) {
-				p = p->next;
-				continue;
-			}
+		for(p = current->first_child; p; p = p->next_sibling) {
 			if(pid > 0) {
 				if(p->pid == pid) {
 					flag = 1;
@@ -60,7 +56,6 @@ int sys_wait4(__pid_t pid, int *status, int options, struct rusage *ru)
 			if(flag) {
 				if(p->state == PROC_STOPPED) {
 					if(!p->exit_code) {
-						p = p->next;
 						continue;
 					}
 					if(status) {
@@ -83,7 +78,6 @@ int sys_wait4(__pid_t pid, int *status, int options, struct rusage *ru)
 					return remove_zombie(p);
 				}
 			}
-			p = p->next;
 			flag = 0;
 		}
 		if(options & WNOHANG) {
@@ -38,15 +38,15 @@ int sys_writev(int ufd, const struct iovec *iov, int iovcnt)
 		if((errno = check_user_area(VERIFY_READ, io_write->iov_base, io_write->iov_len))) {
 			return errno;
 		}
-		if(fd_table[current->fd[ufd]].flags & O_RDONLY) {
+		if(fd_table[current->files->fd[ufd]].flags & O_RDONLY) {
 			return -EBADF;
 		}
 		if(io_write->iov_len < 0) {
 			return -EINVAL;
 		}
-		i = fd_table[current->fd[ufd]].inode;
+		i = fd_table[current->files->fd[ufd]].inode;
 		if(i->fsop && i->fsop->write) {
-			errno = i->fsop->write(i, &fd_table[current->fd[ufd]], io_write->iov_base, io_write->iov_len);
+			errno = i->fsop->write(i, &fd_table[current->files->fd[ufd]], io_write->iov_base, io_write->iov_len);
 			if (errno < 0) {
 				return errno;
 			}
@@ -12,6 +12,7 @@
 #include <fiwix/pit.h>
 #include <fiwix/timer.h>
 #include <fiwix/time.h>
+#include <fiwix/clock.h>
 #include <fiwix/irq.h>
 #include <fiwix/sched.h>
 #include <fiwix/pic.h>
@@ -24,21 +25,65 @@
 #include <fiwix/string.h>
 
 /*
- * timer.c implements a callout table using a singly linked list.
+ * timer.c implements the callouts as a hierarchical timer wheel.
  *
- *  head
- * +---------+  ----------+  ...  ----------+
- * |data|next|  |data|next|  ...  |data|next|
- * |    |  -->  |    |  -->  ...  |    |  / |
- * +---------+  ----------+  ...  ----------+
- *  (callout)    (callout)         (callout)
+ * The first wheel (tv1) has a slot for each one of the next 256 ticks, and
+ * each one of the other four wheels (tvn) covers 64 times the range of the
+ * previous one. A callout is placed in the slot of its expiration tick in
+ * the smallest wheel that reaches it. Every time the first wheel completes
+ * a turn, the next slot of the second wheel is cascaded down into it, and
+ * so on. So adding or removing a callout and processing a tick don't depend
+ * on the number of callouts pending.
+ *
+ *  tv1              tvn[0]           tvn[1]               tvn[3]
+ * +-----+          +-----+          +-----+              +-----+
+ * |  0 --> ...     |  0  |          |  0  |              |  0  |
+ * |  1  |          |  1 --> ...     | ... |     ...      | ... |
+ * | ... |          | ... |          | ... |              | ... |
+ * | 255 |          |  63 |          |  63 |              |  63 |
+ * +-----+          +-----+          +-----+              +-----+
+ * (1 tick)       (256 ticks)     (16384 ticks)        (2^26 ticks)
+ *
+ * The callouts that expire are moved to a list which is run by callouts_bh.
+ * Besides the callouts requested by the drivers through add_callout(), every
+ * process embeds a callout for its sleep timeout and another one for its
+ * ITIMER_REAL timer, so the timer doesn't need to walk the process table.
  */
 
 #define LATCH	(OSCIL / HZ)
 
+#define TVR_BITS	8
+#define TVN_BITS	6
+#define TVR_SIZE	(1 << TVR_BITS)
+#define TVN_SIZE	(1 << TVN_BITS)
+#define TVR_MASK	(TVR_SIZE - 1)
+#define TVN_MASK	(TVN_SIZE - 1)
+#define TVN_LEVELS	4
+#define TVN_INDEX(t, n)	(((t) >> (TVR_BITS + ((n) * TVN_BITS))) & TVN_MASK)
+
+#define IS_POOL_CALLOUT(c)	((c) >= callout_pool && (c) < callout_pool + NR_CALLOUTS)
+
+/*
+ * The counter 0 of the PIT is only 16bit wide, so a single one-shot can't
+ * last more than 54ms. A few ticks more are left as margin to detect whether
+ * the counter has already wrapped around after the terminal count.
+ */
+#define TICKLESS_MAX_TICKS	((0xFFFF / LATCH) - 1)
+
 struct callout callout_pool[NR_CALLOUTS];
 struct callout *callout_pool_head;
-struct callout *callout_head;
+
+static struct callout *tv1[TVR_SIZE];
+static struct callout *tvn[TVN_LEVELS][TVN_SIZE];
+static struct callout *callout_expired;	/* callouts ready to run */
+static unsigned int timer_ticks;	/* next tick to be processed */
+
+#ifdef CONFIG_TICKLESS
+static int tick_oneshot;		/* PIT in one-shot mode */
+static unsigned int oneshot_count;	/* PIT cycles programmed */
+static unsigned int tick_residue;	/* PIT cycles not accounted yet */
+static int tick_stale;			/* the pending tick is already accounted */
+#endif /* CONFIG_TICKLESS */
 
 static char month[12] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
 unsigned int avenrun[3] = { 0, 0, 0 };
@@ -66,13 +111,14 @@ static unsigned int count_active_procs(void)
 static void calc_load(void)
 {
 	unsigned int active_procs;
-	static int count = LOAD_FREQ;
+	static unsigned int next_load = LOAD_FREQ;
 
-	if(count-- >= 0) {
+	/* the ticks might come in bursts after a tickless idle period */
+	if((int)(kstat.ticks - next_load) < 0) {
 		return;
 	}
 
-	count = LOAD_FREQ;
+	next_load = kstat.ticks + LOAD_FREQ;
 	active_procs = count_active_procs();
 	CALC_LOAD(avenrun[0], EXP_1, active_procs);
 	CALC_LOAD(avenrun[1], EXP_5, active_procs);
@@ -94,36 +140,133 @@ static struct callout *get_free_callout(void)
 
 static void put_free_callout(struct callout *old)
 {
+	old->fn = NULL;
 	old->next = callout_pool_head;
 	callout_pool_head = old;
 }
 
-static void do_del_callout(struct callout *c)
+static void link_callout(struct callout **list, struct callout *c)
+{
+	c->list = list;
+	c->prev = NULL;
+	c->next = *list;
+	if(*list) {
+		(*list)->prev = c;
+	}
+	*list = c;
+}
+
+static void unlink_callout(struct callout *c)
 {
-	struct callout **tmp;
+	if(c->next) {
+		c->next->prev = c->prev;
+	}
+	if(c->prev) {
+		c->prev->next = c->next;
+	} else {
+		*c->list = c->next;
+	}
+	c->list = NULL;
+	c->prev = c->next = NULL;
+}
 
-	if(callout_head) {
-		tmp = &callout_head;
-		while(*tmp) {
-			if((*tmp) == c) {
-				if((*tmp)->next != NULL) {
-					*tmp = (*tmp)->next;
-					(*tmp)->expires += c->expires;
-				} else {
-					*tmp = NULL;
+/* place the callout in the wheel slot of its expiration tick */
+static void queue_callout(struct callout *c)
+{
+	unsigned int delta;
+	int n;
+
+	delta = c->expires - timer_ticks;
+	if((int)delta < 0) {
+		/* it has already expired, run it in the next tick */
+		link_callout(&tv1[timer_ticks & TVR_MASK], c);
+		return;
+	}
+	if(delta < TVR_SIZE) {
+		link_callout(&tv1[c->expires & TVR_MASK], c);
+		return;
+	}
+	for(n = 0; n < TVN_LEVELS - 1; n++) {
+		if(delta < 1 << (TVR_BITS + ((n + 1) * TVN_BITS))) {
+			break;
+		}
+	}
+	link_callout(&tvn[n][TVN_INDEX(c->expires, n)], c);
+}
+
+/* move the callouts of the current slot of the wheel 'n' to lower wheels */
+static int cascade(int n)
+{
+	struct callout *c, *next;
+	int index;
+
+	index = TVN_INDEX(timer_ticks, n);
+	c = tvn[n][index];
+	tvn[n][index] = NULL;
+	while(c) {
+		next = c->next;
+		queue_callout(c);
+		c = next;
+	}
+	return index;
+}
+
+/* process all ticks elapsed since the last call */
+static void run_timer_wheel(void)
+{
+	unsigned int flags;
+	struct callout *c;
+	int index, n;
+
+	SAVE_FLAGS(flags); CLI();
+	while((int)(kstat.ticks - timer_ticks) >= 0) {
+		index = timer_ticks & TVR_MASK;
+		if(!index) {
+			for(n = 0; n < TVN_LEVELS; n++) {
+				if(cascade(n)) {
+					break;
 				}
-				put_free_callout(c);
-				break;
 			}
-			tmp = &(*tmp)->next;
 		}
+		while((c = tv1[index])) {
+			unlink_callout(c);
+			link_callout(&callout_expired, c);
+		}
+		timer_ticks++;
+	}
+	if(callout_expired) {
+		callouts_bh.flags |= BH_ACTIVE;
+	}
+	RESTORE_FLAGS(flags);
+}
+
+static void proc_timeout(unsigned int arg)
+{
+	struct proc *p;
+
+	p = (struct proc *)arg;
+	p->timeout = 0;
+	wakeup_proc(p);
+}
+
+static void proc_itimer_real(unsigned int arg)
+{
+	struct proc *p;
+	struct timespec ts;
+
+	p = (struct proc *)arg;
+	if(p->it_real_interval.tv_sec || p->it_real_interval.tv_usec) {
+		ts.tv_sec = p->it_real_interval.tv_sec;
+		ts.tv_nsec = p->it_real_interval.tv_usec * NSEC_PER_USEC;
+		hrtimer_forward(&p->it_real_timer, &ts);
 	}
+	send_sig(p, SIGALRM);
 }
 
 void add_callout(struct callout_req *creq, unsigned int ticks)
 {
 	unsigned int flags;
-	struct callout *c, **tmp;
+	struct callout *c;
 
 	del_callout(creq);
 	SAVE_FLAGS(flags); CLI();
@@ -136,25 +279,10 @@ void add_callout(struct callout_req *creq, unsigned int ticks)
 
 	/* setup the new callout */
 	memset_b(c, 0, sizeof(struct callout));
-	c->expires = ticks;
+	c->expires = kstat.ticks + ticks;
 	c->fn = creq->fn;
 	c->arg = creq->arg;
-
-	if(!callout_head) {
-		callout_head = c;
-	} else {
-		tmp = &callout_head;
-		while(*tmp) {
-			if((*tmp)->expires > c->expires) {
-				(*tmp)->expires -= c->expires;
-				c->next = *tmp;
-				break;
-			}
-			c->expires -= (*tmp)->expires;
-			tmp = &(*tmp)->next;
-		}
-		*tmp = c;
-	}
+	queue_callout(c);
 	RESTORE_FLAGS(flags);
 }
 
@@ -164,30 +292,209 @@ void del_callout(struct callout_req *creq)
 	struct callout *c;
 
 	SAVE_FLAGS(flags); CLI();
-	c = callout_head;
-	while(c) {
-		if(c->fn == creq->fn && c->arg == creq->arg) {
-			do_del_callout(c);
+	for(c = callout_pool; c < callout_pool + NR_CALLOUTS; c++) {
+		if(c->list && c->fn == creq->fn && c->arg == creq->arg) {
+			unlink_callout(c);
+			put_free_callout(c);
 			break;
 		}
-		c = c->next;
 	}
 	RESTORE_FLAGS(flags);
 }
 
-void irq_timer(int num, struct sigcontext *sc)
+/* (re)arm a callout embedded in another structure */
+void add_timer(struct callout *c, unsigned int ticks)
+{
+	unsigned int flags;
+
+	SAVE_FLAGS(flags); CLI();
+	if(c->list) {
+		unlink_callout(c);
+	}
+	c->expires = kstat.ticks + ticks;
+	queue_callout(c);
+	RESTORE_FLAGS(flags);
+}
+
+void del_timer(struct callout *c)
+{
+	unsigned int flags;
+
+	SAVE_FLAGS(flags); CLI();
+	if(c->list) {
+		unlink_callout(c);
+	}
+	RESTORE_FLAGS(flags);
+}
+
+/* returns the ticks left before the callout expires */
+unsigned int timer_left(struct callout *c)
+{
+	unsigned int flags, left;
+
+	SAVE_FLAGS(flags); CLI();
+	left = 0;
+	if(c->list && c->list != &callout_expired) {
+		left = c->expires - kstat.ticks;
+		if((int)left < 0) {
+			left = 0;
+		}
+	}
+	RESTORE_FLAGS(flags);
+	return left;
+}
+
+/* wake up the current process after 'ticks' if it is still sleeping */
+void start_timeout(unsigned int ticks)
 {
-	if((++kstat.ticks % HZ) == 0) {
-		CURRENT_TIME++;
-		kstat.uptime++;
+	current->timeout = ticks;
+	if(ticks && ticks != INFINITE_WAIT) {
+		current->timeout_timer.fn = proc_timeout;
+		current->timeout_timer.arg = (unsigned int)current;
+		add_timer(&current->timeout_timer, ticks);
 	}
+}
+
+/* cancel the timeout of the current process and return the ticks left */
+unsigned int stop_timeout(void)
+{
+	unsigned int left;
+
+	left = current->timeout;
+	if(left && left != INFINITE_WAIT) {
+		left = timer_left(&current->timeout_timer);
+		del_timer(&current->timeout_timer);
+	}
+	current->timeout = 0;
+	return left;
+}
+
+static void account_ticks(unsigned int ticks)
+{
+	while(ticks--) {
+		if((++kstat.ticks % HZ) == 0) {
+			CURRENT_TIME++;
+			kstat.uptime++;
+		}
+	}
+#ifdef CONFIG_TICKLESS
+	clock_tick(tick_residue);
+#else
+	clock_tick(0);
+#endif /* CONFIG_TICKLESS */
+}
+
+#ifdef CONFIG_TICKLESS
+/* returns the ticks until the next callout expires, up to 'max' */
+static unsigned int next_callout_ticks(unsigned int max)
+{
+	unsigned int n, t;
+
+	if(callout_expired || (int)(kstat.ticks - timer_ticks) >= 0) {
+		return 0;
+	}
+	for(n = 1; n < max; n++) {
+		t = kstat.ticks + n;
+
+		/* stop at the end of the first wheel, it may cascade callouts */
+		if(tv1[t & TVR_MASK] || !(t & TVR_MASK)) {
+			break;
+		}
+	}
+	return n;
+}
+
+/* switch the PIT back to periodic mode and catch up the ticks elapsed */
+static void oneshot_end(void)
+{
+	unsigned int count, elapsed;
+
+	count = pit_getcounter0();
+	if(count > oneshot_count) {
+		/* the counter wrapped around after the terminal count */
+		elapsed = oneshot_count + (0x10000 - count);
+	} else {
+		elapsed = oneshot_count - count;
+	}
+	elapsed += tick_residue;
+	pit_init(HZ);
+	tick_oneshot = 0;
+	tick_residue = elapsed % LATCH;
+	account_ticks(elapsed / LATCH);
+	timer_bh.flags |= BH_ACTIVE;
+}
+
+/*
+ * This is called by the idle process with the interrupts disabled. If no
+ * callout expires during the next ticks, the periodic interrupt is replaced
+ * by a single interrupt at the tick of the next expiration. The time elapsed
+ * since the last tick is carried in 'tick_residue' so the expiration is
+ * aligned to the original tick boundaries.
+ */
+void tickless_enter(void)
+{
+	unsigned int ticks, phase;
+
+	if(tick_oneshot) {
+		return;
+	}
+	if((ticks = next_callout_ticks(TICKLESS_MAX_TICKS)) < 2) {
+		return;
+	}
+
+	/* don't lose a tick that is already pending */
+	outport_b(PIC_MASTER, PIC_READ_IRR);
+	if(inport_b(PIC_MASTER) & (1 << TIMER_IRQ)) {
+		return;
+	}
+
+	phase = LATCH - pit_getcounter0();
+	oneshot_count = (ticks * LATCH) - phase;
+	tick_residue += phase;
+	pit_oneshot(oneshot_count);
+	tick_oneshot = 1;
+	kstat.tickless_idles++;
+}
 
+/*
+ * This is called on every interrupt other than the timer, before its
+ * handlers run, so they (and the bottom halves) don't see the time as it was
+ * before the tickless idle period. If the one-shot has already expired, its
+ * timer interrupt is still pending and it must not account a tick again.
+ */
+void tickless_exit(void)
+{
+	if(!tick_oneshot) {
+		return;
+	}
+	outport_b(PIC_MASTER, PIC_READ_IRR);
+	if(inport_b(PIC_MASTER) & (1 << TIMER_IRQ)) {
+		tick_stale = 1;
+	}
+	oneshot_end();
+}
+#endif /* CONFIG_TICKLESS */
+
+void irq_timer(int num, struct sigcontext *sc)
+{
+#ifdef CONFIG_TICKLESS
+	if(tick_oneshot) {
+		oneshot_end();
+		return;
+	}
+	if(tick_stale) {
+		tick_stale = 0;
+		return;
+	}
+#endif /* CONFIG_TICKLESS */
+	account_ticks(1);
 	timer_bh.flags |= BH_ACTIVE;
 }
 
+/* a timeout must not expire before its time, so it's rounded up to ticks */
 unsigned int tv2ticks(const struct timeval *tv)
 {
-	return((tv->tv_sec * HZ) + tv->tv_usec * HZ / 1000000);
+	return((tv->tv_sec * HZ) + ((tv->tv_usec * HZ) + 999999) / 1000000);
 }
 
 void ticks2tv(int ticks, struct timeval *tv)
@@ -196,16 +503,38 @@ void ticks2tv(int ticks, struct timeval *tv)
 	tv->tv_usec = (ticks % HZ) * 1000000 / HZ;
 }
 
+void getitimer_real(struct itimerval *curr_value)
+{
+	struct timespec ts;
+
+	hrtimer_get_left(&current->it_real_timer, &ts);
+	curr_value->it_interval = current->it_real_interval;
+	curr_value->it_value.tv_sec = ts.tv_sec;
+	curr_value->it_value.tv_usec = (ts.tv_nsec + NSEC_PER_USEC - 1) / NSEC_PER_USEC;
+	if(curr_value->it_value.tv_usec >= 1000000) {
+		curr_value->it_value.tv_sec++;
+		curr_value->it_value.tv_usec -= 1000000;
+	}
+}
+
 int setitimer(int which, const struct itimerval *new_value, struct itimerval *old_value)
 {
+	struct timespec ts;
+
 	switch(which) {
 		case ITIMER_REAL:
 			if((unsigned int)old_value) {
-				ticks2tv(current->it_real_interval, &old_value->it_interval);
-				ticks2tv(current->it_real_value, &old_value->it_value);
+				getitimer_real(old_value);
+			}
+			hrtimer_cancel(&current->it_real_timer);
+			current->it_real_interval = new_value->it_interval;
+			if(new_value->it_value.tv_sec || new_value->it_value.tv_usec) {
+				ts.tv_sec = new_value->it_value.tv_sec;
+				ts.tv_nsec = new_value->it_value.tv_usec * NSEC_PER_USEC;
+				current->it_real_timer.timer.fn = proc_itimer_real;
+				current->it_real_timer.timer.arg = (unsigned int)current;
+				hrtimer_start(&current->it_real_timer, &ts);
 			}
-			current->it_real_interval = tv2ticks(&new_value->it_interval);
-			current->it_real_value = tv2ticks(&new_value->it_value);
 			break;
 		case ITIMER_VIRTUAL:
 			if((unsigned int)old_value) {
@@ -257,8 +586,6 @@ unsigned int mktime(struct tm *tm)
 
 void irq_timer_bh(struct sigcontext *sc)
 {
-	struct proc *p;
-
 	if(sc->cs == KERNEL_CS) {
 		current->usage.ru_stime.tv_usec += TICK;
 		if(current->usage.ru_stime.tv_usec >= 1000000) {
@@ -299,37 +626,9 @@ void irq_timer_bh(struct sigcontext *sc)
 	}
 
 	calc_load();
-	FOR_EACH_PROCESS(p) {
-		if(p->timeout > 0 && p->timeout < INFINITE_WAIT) {
-			p->timeout--;
-			if(!p->timeout) {
-				wakeup_proc(p);
-			}
-		}
-		if(p->it_real_value > 0) {
-			p->it_real_value--;
-			if(!p->it_real_value) {
-				p->it_real_value = p->it_real_interval;
-				send_sig(p, SIGALRM);
-			}
-		}
-		p = p->next;
-	}
-
-	/* callouts */
-	if(callout_head) {
-		if(callout_head->expires > 0) {
-			callout_head->expires--;
-			if(!callout_head->expires) {
-				callouts_bh.flags |= BH_ACTIVE;
-			}
-		} else {
-			printk("%s(): callout losing ticks.\n", __FUNCTION__);
-			callouts_bh.flags |= BH_ACTIVE;
-		}
-	}
+	run_timer_wheel();
 
-	if(current->pid > IDLE && --current->cpu_count <= 0) {
+	if(current->pid > IDLE && current->policy != SCHED_FIFO && --current->cpu_count <= 0) {
 		current->cpu_count = 0;
 		need_resched = 1;
 	}
@@ -337,23 +636,29 @@ void irq_timer_bh(struct sigcontext *sc)
 
 void do_callouts_bh(struct sigcontext *sc)
 {
+	unsigned int flags;
 	struct callout *c;
 	void (*fn)(unsigned int);
 	unsigned int arg;
 
-	while(callout_head) {
-		if(callout_head->expires) {
+	for(;;) {
+		SAVE_FLAGS(flags); CLI();
+		if(!(c = callout_expired)) {
+			RESTORE_FLAGS(flags);
 			break;
 		}
 		if(!can_lock_area(AREA_CALLOUT)) {
+			RESTORE_FLAGS(flags);
 			break;
 		}
-		fn = callout_head->fn;
-		arg = callout_head->arg;
-		c = callout_head;
-		callout_head = callout_head->next;
-		put_free_callout(c);
+		fn = c->fn;
+		arg = c->arg;
+		unlink_callout(c);
+		if(IS_POOL_CALLOUT(c)) {
+			put_free_callout(c);
+		}
 		unlock_area(AREA_CALLOUT);
+		RESTORE_FLAGS(flags);
 		fn(arg);
 	}
 }
@@ -428,17 +733,6 @@ void set_system_time(__time_t t)
 	CURRENT_TIME = t;
 }
 
-int gettimeoffset(void)
-{
-	int count;
-
-	count = pit_getcounter0();
-	count = (LATCH - count) * TICK;
-	count /= LATCH;
-
-	return count;
-}
-
 void timer_init(void)
 {
 	int n;
@@ -450,6 +744,10 @@ void timer_init(void)
 	pit_init(HZ);
 
 	memset_b(callout_pool, 0, sizeof(callout_pool));
+	memset_b(tv1, 0, sizeof(tv1));
+	memset_b(tvn, 0, sizeof(tvn));
+	callout_expired = NULL;
+	timer_ticks = kstat.ticks;
 
 	/* callout free list initialization */
 	callout_pool_head = NULL;
@@ -458,9 +756,9 @@ void timer_init(void)
 		c = &callout_pool[n];
 		put_free_callout(c);
 	}
-	callout_head = NULL;
 
-	printk("clock     -                 %d\ttype=PIT Hz=%d\n", TIMER_IRQ, HZ);
+	clock_init();
+	printk("clock     -                 %d\ttype=PIT Hz=%d clocksource=%s\n", TIMER_IRQ, HZ, clocksource->name);
 	if(!register_irq(TIMER_IRQ, &irq_config_timer)) {
 		enable_irq(TIMER_IRQ);
 	}
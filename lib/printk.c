@@ -8,6 +8,7 @@
 #include <fiwix/asm.h>
 #include <fiwix/kernel.h>
 #include <fiwix/syslog.h>
+#include <fiwix/poll.h>
 #include <fiwix/tty.h>
 #include <fiwix/sysconsole.h>
 #include <fiwix/syscalls.h>
@@ -90,7 +91,7 @@ static void puts(char *buffer, int msg_level)
 		l++;
 	}
 	wakeup(&sys_syslog);
-	wakeup(&do_select);
+	select_notify(&log_new_chars);
 }
 
 /*
@@ -267,13 +267,117 @@ int atoi(const char *str)
 	return strtol(str, (char **)NULL, 10);
 }
 
+/*
+ * The memory copy and fill functions below move 32bit words once the
+ * destination has been aligned. The bulk of the transfer is done either by a
+ * plain C loop or by the 'rep movsl' and 'rep stosl' instructions, depending
+ * on the CPU detected in cpu_init(). Builds made with tcc always use the C
+ * variant.
+ */
+static int string_ops = STRING_OPS_GENERIC;
+
+void set_string_ops(int ops)
+{
+#ifdef __TINYC__
+	ops = STRING_OPS_GENERIC;
+#endif
+	string_ops = ops;
+}
+
+static void copy_dwords(void *dest, const void *src, unsigned int count)
+{
+	unsigned int *d;
+	const unsigned int *s;
+
+#ifndef __TINYC__
+	if(string_ops == STRING_OPS_REP) {
+		int d0, d1, d2;
+
+		__asm__ __volatile__(
+			"cld\n\t"
+			"rep ; movsl\n\t"
+			: "=&c" (d0), "=&D" (d1), "=&S" (d2)
+			: "0" (count), "1" (dest), "2" (src)
+			: "memory"
+		);
+		return;
+	}
+#endif /* __TINYC__ */
+
+	d = (unsigned int *)dest;
+	s = (const unsigned int *)src;
+	while(count >= 4) {
+		d[0] = s[0];
+		d[1] = s[1];
+		d[2] = s[2];
+		d[3] = s[3];
+		d += 4;
+		s += 4;
+		count -= 4;
+	}
+	while(count--) {
+		*d = *s;
+		d++;
+		s++;
+	}
+}
+
+static void fill_dwords(void *dest, unsigned int value, unsigned int count)
+{
+	unsigned int *d;
+
+#ifndef __TINYC__
+	if(string_ops == STRING_OPS_REP) {
+		int d0, d1;
+
+		__asm__ __volatile__(
+			"cld\n\t"
+			"rep ; stosl\n\t"
+			: "=&c" (d0), "=&D" (d1)
+			: "a" (value), "0" (count), "1" (dest)
+			: "memory"
+		);
+		return;
+	}
+#endif /* __TINYC__ */
+
+	d = (unsigned int *)dest;
+	while(count >= 4) {
+		d[0] = value;
+		d[1] = value;
+		d[2] = value;
+		d[3] = value;
+		d += 4;
+		count -= 4;
+	}
+	while(count--) {
+		*d = value;
+		d++;
+	}
+}
+
 void memcpy_b(void *dest, const void *src, unsigned int count)
 {
 	unsigned char *d;
 	const unsigned char *s;
+	unsigned int n;
 
 	d = (unsigned char *)dest;
 	s = (const unsigned char *)src;
+	if(count >= STRING_OPS_THRESHOLD) {
+		/* align the destination to a dword boundary */
+		while((unsigned int)d & 3) {
+			*d = *s;
+			d++;
+			s++;
+			count--;
+		}
+		n = count >> 2;
+		copy_dwords(d, s, n);
+		d += n << 2;
+		s += n << 2;
+		count &= 3;
+	}
 	while(count--) {
 		*d = *s;
 		d++;
@@ -288,6 +392,18 @@ void memcpy_w(void *dest, const void *src, unsigned int count)
 
 	d = (unsigned short int *)dest;
 	s = (const unsigned short int *)src;
+	if(count >= STRING_OPS_THRESHOLD / 2) {
+		if((unsigned int)d & 2) {
+			*d = *s;
+			d++;
+			s++;
+			count--;
+		}
+		copy_dwords(d, s, count >> 1);
+		d += count & ~1;
+		s += count & ~1;
+		count &= 1;
+	}
 	while(count--) {
 		*d = *s;
 		d++;
@@ -297,23 +413,27 @@ void memcpy_w(void *dest, const void *src, unsigned int count)
 
 void memcpy_l(void *dest, const void *src, unsigned int count)
 {
-	unsigned int *d;
-	const unsigned int *s;
-
-	d = (unsigned int *)dest;
-	s = (const unsigned int *)src;
-	while(count--) {
-		*d = *s;
-		d++;
-		s++;
-	}
+	copy_dwords(dest, src, count);
 }
 
 void memset_b(void *dest, unsigned char value, unsigned int count)
 {
 	unsigned char *d;
+	unsigned int n;
 
 	d = (unsigned char *)dest;
+	if(count >= STRING_OPS_THRESHOLD) {
+		/* align the destination to a dword boundary */
+		while((unsigned int)d & 3) {
+			*d = value;
+			d++;
+			count--;
+		}
+		n = count >> 2;
+		fill_dwords(d, value * 0x01010101U, n);
+		d += n << 2;
+		count &= 3;
+	}
 	while(count--) {
 		*d = value;
 		d++;
@@ -325,6 +445,16 @@ void memset_w(void *dest, unsigned short int value, unsigned int count)
 	unsigned short int *d;
 
 	d = (unsigned short int *)dest;
+	if(count >= STRING_OPS_THRESHOLD / 2) {
+		if((unsigned int)d & 2) {
+			*d = value;
+			d++;
+			count--;
+		}
+		fill_dwords(d, value | ((unsigned int)value << 16), count >> 1);
+		d += count & ~1;
+		count &= 1;
+	}
 	while(count--) {
 		*d = value;
 		d++;
@@ -333,13 +463,7 @@ void memset_w(void *dest, unsigned short int value, unsigned int count)
 
 void memset_l(void *dest, unsigned int value, unsigned int count)
 {
-	unsigned int *d;
-
-	d = (unsigned int *)dest;
-	while(count--) {
-		*d = value;
-		d++;
-	}
+	fill_dwords(dest, value, count);
 }
 
 int memcmp(const void *str1, const void *str2, unsigned int count)
@@ -349,9 +473,19 @@ int memcmp(const void *str1, const void *str2, unsigned int count)
 
 	s1 = (const unsigned char *)str1;
 	s2 = (const unsigned char *)str2;
+
+	/* skip the equal leading dwords, the difference is found bytewise */
+	while(count >= 4) {
+		if(*(const unsigned int *)s1 != *(const unsigned int *)s2) {
+			break;
+		}
+		s1 += 4;
+		s2 += 4;
+		count -= 4;
+	}
 	while(count--) {
 		if(*s1 != *s2) {
-			return s1 < s2 ? -1 : 1;
+			return *s1 < *s2 ? -1 : 1;
 		}
 		s1++;
 		s2++;
@@ -11,11 +11,12 @@
 #include <fiwix/string.h>
 
 /*
- * The kmalloc() function acts like a front-end for the two
+ * The kmalloc() function acts like a front-end for the three
  * memory allocators currently supported:
  *
  * - buddy_low() for requests up to 2048KB.
  * - get_free_page() rest of requests up to PAGE_SIZE.
+ * - buddy_high() for requests bigger than PAGE_SIZE.
  */
 unsigned int kmalloc(__size_t size)
 {
@@ -30,10 +31,9 @@ unsigned int kmalloc(__size_t size)
 		return bl_malloc(size);
 	}
 
-	/* FIXME: pending to implement buddy_high */
+	/* check if size needs physically contiguous pages */
 	if(size > PAGE_SIZE) {
-		printk("WARNING: %s(): size (%d) is bigger than PAGE_SIZE!\n", __FUNCTION__, size);
-		return 0;
+		return bh_malloc(size);
 	}
 
 	if((pg = get_free_page())) {
@@ -55,6 +55,8 @@ void kfree(unsigned int addr)
 
 	if(pg->flags & PAGE_BUDDYLOW) {
 		bl_free(addr);
+	} else if(pg->flags & PAGE_BUDDYHIGH) {
+		bh_free(addr);
 	} else {
 		release_page(pg);
 	}
@@ -90,6 +90,41 @@ int is_addr_in_bios_map(unsigned int addr)
 	return retval;
 }
 
+/*
+ * Check if a range of addresses is entirely available in the memory map
+ * reported by the BIOS, so it has no holes (ACPI tables, memory-mapped
+ * devices, ...) in between.
+ */
+int is_range_in_bios_map(unsigned int from, unsigned int to)
+{
+	int n, retval;
+	unsigned int end;
+	struct bios_mem_map *bmm;
+
+	retval = 0;
+	bmm = &bios_mem_map[0];
+	for(n = 0; n < NR_BIOS_MM_ENT; n++, bmm++) {
+		if(bmm->to && bmm->type == MULTIBOOT_MEMORY_AVAILABLE && !bmm->from_hi && !bmm->to_hi) {
+			if(from >= bmm->from && to <= bmm->to) {
+				retval = 1;
+			}
+		}
+	}
+
+	/* the entries might overlap, so check that no hole is within */
+	bmm = &bios_mem_map[0];
+	for(n = 0; n < NR_BIOS_MM_ENT; n++, bmm++) {
+		if(bmm->type && bmm->type != MULTIBOOT_MEMORY_AVAILABLE && !bmm->from_hi) {
+			end = bmm->to_hi ? 0xFFFFFFFF : bmm->to;
+			if(from < end && to > bmm->from) {
+				retval = 0;
+			}
+		}
+	}
+
+	return retval;
+}
+
 void bios_map_reserve(unsigned int from, unsigned int to)
 {
 	if(is_addr_in_bios_map(from)) {
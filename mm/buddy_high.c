@@ -0,0 +1,172 @@
+/*
+ * fiwix/mm/buddy_high.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+/*
+ * This buddy algorithm is intended to handle memory requests bigger than a
+ * PAGE_SIZE, which need physically contiguous pages.
+ *
+ * A block is made of (1 << order) pages taken from the page pool and aligned
+ * to its own size, so the buddy of a block starts at the page number that
+ * results from flipping the bit 'order' of the first page of the block.
+ * All the pages of a block have the flag PAGE_BUDDYHIGH, and the first page
+ * keeps the order of the block. The free blocks are also flagged PAGE_BHFREE
+ * and linked through the 'prev_free' and 'next_free' fields of their first
+ * page, which are not used while the page is out of the page pool.
+ */
+
+#include <fiwix/asm.h>
+#include <fiwix/kernel.h>
+#include <fiwix/mm.h>
+#include <fiwix/stdio.h>
+#include <fiwix/string.h>
+
+static struct page *freelist[BUDDY_HIGH_MAX_ORDER + 1];
+
+static void add_block(struct page *pg, int order)
+{
+	pg->order = order;
+	pg->flags |= PAGE_BHFREE;
+	pg->prev_free = NULL;
+	pg->next_free = freelist[order];
+	if(freelist[order]) {
+		freelist[order]->prev_free = pg;
+	}
+	freelist[order] = pg;
+	kstat.buddy_high_free[order]++;
+}
+
+static void del_block(struct page *pg, int order)
+{
+	pg->flags &= ~PAGE_BHFREE;
+	if(pg->next_free) {
+		pg->next_free->prev_free = pg->prev_free;
+	}
+	if(pg->prev_free) {
+		pg->prev_free->next_free = pg->next_free;
+	}
+	if(pg == freelist[order]) {
+		freelist[order] = pg->next_free;
+	}
+	pg->prev_free = pg->next_free = NULL;
+	kstat.buddy_high_free[order]--;
+}
+
+static int get_order(__size_t size)
+{
+	int order;
+
+	for(order = 0; (PAGE_SIZE << order) < size; order++);
+	return order;
+}
+
+unsigned int bh_malloc(__size_t size)
+{
+	unsigned int flags, addr;
+	struct page *pg;
+	int n, order;
+
+	if((order = get_order(size)) > BUDDY_HIGH_MAX_ORDER) {
+		printk("WARNING: %s(): size (%d) is bigger than %d!\n", __FUNCTION__, size, PAGE_SIZE << BUDDY_HIGH_MAX_ORDER);
+		return 0;
+	}
+
+	SAVE_FLAGS(flags); CLI();
+	for(n = order; n <= BUDDY_HIGH_MAX_ORDER; n++) {
+		if(freelist[n]) {
+			break;
+		}
+	}
+	if(n <= BUDDY_HIGH_MAX_ORDER) {
+		pg = freelist[n];
+		del_block(pg, n);
+		/* split the block, keeping the upper halves as free blocks */
+		while(n > order) {
+			n--;
+			add_block(&page_table[pg->page + (1 << n)], n);
+		}
+	} else {
+		RESTORE_FLAGS(flags);
+		if(!(pg = get_free_pages(order))) {
+			return 0;
+		}
+		SAVE_FLAGS(flags); CLI();
+		for(n = 0; n < (1 << order); n++) {
+			page_table[pg->page + n].flags |= PAGE_BUDDYHIGH;
+		}
+		kstat.buddy_high_num_pages += 1 << order;
+	}
+	pg->order = order;
+	kstat.buddy_high_count[order]++;
+	RESTORE_FLAGS(flags);
+
+	addr = pg->page << PAGE_SHIFT;
+	return P2V(addr);
+}
+
+void bh_free(unsigned int addr)
+{
+	unsigned int flags;
+	struct page *pg, *buddy;
+	int page, order;
+
+	pg = &page_table[V2P(addr) >> PAGE_SHIFT];
+	if(!(pg->flags & PAGE_BUDDYHIGH) || pg->flags & PAGE_BHFREE) {
+		printk("WARNING: %s(): trying to free a wrong block (0x%x)!\n", __FUNCTION__, addr);
+		return;
+	}
+
+	SAVE_FLAGS(flags); CLI();
+	order = pg->order;
+	kstat.buddy_high_count[order]--;
+
+	/* coalesce the block with its buddies as long as they are free */
+	page = pg->page;
+	while(order < BUDDY_HIGH_MAX_ORDER) {
+		if(!is_valid_page(page ^ (1 << order))) {
+			break;
+		}
+		buddy = &page_table[page ^ (1 << order)];
+		if(!(buddy->flags & PAGE_BHFREE) || buddy->order != order) {
+			break;
+		}
+		del_block(buddy, order);
+		page &= ~(1 << order);
+		order++;
+	}
+	add_block(&page_table[page], order);
+	RESTORE_FLAGS(flags);
+}
+
+/* give back all the free blocks to the page pool */
+int bh_reap(void)
+{
+	unsigned int flags;
+	struct page *pg, *p;
+	int n, order, reaped;
+
+	reaped = 0;
+	SAVE_FLAGS(flags); CLI();
+	for(order = 0; order <= BUDDY_HIGH_MAX_ORDER; order++) {
+		while((pg = freelist[order])) {
+			del_block(pg, order);
+			for(n = 0; n < (1 << order); n++) {
+				p = &page_table[pg->page + n];
+				p->flags &= ~PAGE_BUDDYHIGH;
+				release_page(p);
+			}
+			kstat.buddy_high_num_pages -= 1 << order;
+			reaped += 1 << order;
+		}
+	}
+	RESTORE_FLAGS(flags);
+	return reaped;
+}
+
+void buddy_high_init(void)
+{
+	memset_b(freelist, 0, sizeof(freelist));
+}
@@ -25,9 +25,14 @@ static struct bl_head *get_buddy(struct bl_head *block)
 	return (struct bl_head *)((unsigned int)block ^ mask);
 }
 
+/*
+ * The buddy of a block always starts with the header of a block, so its
+ * 'free' and 'level' fields tell, without searching the free list, whether
+ * the whole buddy is free and can be coalesced.
+ */
 static void deallocate(struct bl_head *block)
 {
-	struct bl_head **h, *buddy, *p;
+	struct bl_head **h, *buddy;
 	struct page *pg;
 	unsigned int addr, paddr;
 	int level;
@@ -35,16 +40,9 @@ static void deallocate(struct bl_head *block)
 	level = block->level;
 	buddy = get_buddy(block);
 
-	p = freelist[level];
-	while(p != NULL) {
-		if(p == buddy) {
-			break;
-		}
-		p = p->next;
-	}
-
-	if(p == buddy) {
+	if(buddy->free && buddy->level == level) {
 		/* remove buddy from its free list */
+		buddy->free = 0;
 		if(buddy->next) {
 			buddy->next->prev = buddy->prev;
 		}
@@ -75,6 +73,7 @@ static void deallocate(struct bl_head *block)
 		}
 	} else {
 		/* buddy not free, put block on its free list */
+		block->free = 1;
 		h = &freelist[level];
 
 		if(!*h) {
@@ -104,6 +103,7 @@ static struct bl_head *allocate(int size)
 			pg = &page_table[paddr >> PAGE_SHIFT];
 			pg->flags |= PAGE_BUDDYLOW;
 			block = (struct bl_head *)addr;
+			block->free = 0;
 		} else {
 			printk("WARNING: %s(): not enough memory!\n", __FUNCTION__);
 			return NULL;
@@ -123,6 +123,7 @@ static struct bl_head *allocate(int size)
 			block->prev->next = block->next;
 		}
 		freelist[level] = block->next;
+		block->free = 0;
 	} else {
 		/* split a bigger block */
 		block = allocate(bl_blocksize[level + 1]);
@@ -132,6 +133,7 @@ static struct bl_head *allocate(int size)
 			block->level = level;
 			buddy = get_buddy(block);
 			buddy->level = level;
+			buddy->free = 1;
 			buddy->prev = buddy->next = NULL;
 			freelist[level] = buddy;
 		}
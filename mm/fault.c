@@ -14,11 +14,16 @@
 #include <fiwix/sched.h>
 #include <fiwix/fs.h>
 #include <fiwix/mman.h>
+#include <fiwix/stat.h>
 #include <fiwix/errno.h>
 #include <fiwix/stdio.h>
 #include <fiwix/string.h>
 #include <fiwix/syscalls.h>
 #include <fiwix/shm.h>
+#include <fiwix/buffer.h>
+
+/* shared by all the anonymous pages that have been read but not written */
+static unsigned int zero_page = 0;
 
 /* send the SIGSEGV signal to the ofending process */
 static void send_sigsegv(struct sigcontext *sc)
@@ -31,6 +36,75 @@ static void send_sigsegv(struct sigcontext *sc)
 	send_sig(current, SIGSEGV);
 }
 
+static unsigned int get_zero_page(void)
+{
+	if(!zero_page) {
+		if(!(zero_page = kmalloc(PAGE_SIZE))) {
+			return 0;
+		}
+		memset_b((void *)zero_page, 0, PAGE_SIZE);
+		/* this makes sure it will never be freed or copied on fork */
+		page_table[V2P(zero_page) >> PAGE_SHIFT].flags |= PAGE_RESERVED;
+	}
+	return zero_page;
+}
+
+static int is_page_mapped(unsigned int addr)
+{
+	unsigned int *pgdir, *pgtbl;
+	unsigned int pde, pte;
+
+	pgdir = (unsigned int *)P2V(current->tss.cr3);
+	pde = GET_PGDIR(addr);
+	pte = GET_PGTBL(addr);
+	if(!(pgdir[pde] & PAGE_PRESENT)) {
+		return 0;
+	}
+	pgtbl = (unsigned int *)P2V((pgdir[pde] & PAGE_MASK));
+	return pgtbl[pte] & PAGE_PRESENT;
+}
+
+/*
+ * Maps the pages around 'cr2' which are already in the page cache, so the
+ * process won't trap for them later. It never waits for I/O, the pages not
+ * yet cached or still being read are left to their own page faults.
+ */
+static void fault_around(struct vma *vma, unsigned int cr2)
+{
+	unsigned int start, end, addr, file_offset;
+	struct page *pg;
+
+	if(!S_ISREG(vma->inode->i_mode)) {
+		return;
+	}
+
+	start = cr2 & ~((FAULT_AROUND_PAGES * PAGE_SIZE) - 1);
+	end = start + (FAULT_AROUND_PAGES * PAGE_SIZE);
+	start = MAX(start, vma->start);
+	end = MIN(end, vma->end);
+
+	for(addr = start; addr < end; addr += PAGE_SIZE) {
+		if(addr == (cr2 & PAGE_MASK) || is_page_mapped(addr)) {
+			continue;
+		}
+		file_offset = addr - vma->start + vma->offset;
+		if(file_offset >= vma->inode->i_size) {
+			break;
+		}
+		if(!(pg = search_page_hash(vma->inode, file_offset))) {
+			continue;
+		}
+		if(pg->flags & PAGE_LOCKED || !page_buffers_uptodate(pg)) {
+			release_page(pg);
+			continue;
+		}
+		if(!map_page(current, addr, (unsigned int)V2P(pg->data), vma->prot)) {
+			release_page(pg);
+			break;
+		}
+	}
+}
+
 static int page_protection_violation(struct vma *vma, unsigned int cr2, struct sigcontext *sc)
 {
 	unsigned int *pgdir;
@@ -47,6 +121,23 @@ static int page_protection_violation(struct vma *vma, unsigned int cr2, struct s
 
 	pg = &page_table[page];
 
+	/* the shared zero page gets a private page on the first write */
+	if(zero_page && page == (V2P(zero_page) >> PAGE_SHIFT)) {
+		if(!(vma->prot & PROT_WRITE)) {
+			send_sigsegv(sc);
+			return 0;
+		}
+		if(!(addr = kmalloc(PAGE_SIZE))) {
+			printk("%s(): not enough memory!\n", __FUNCTION__);
+			return 1;
+		}
+		current->rss++;
+		memset_b((void *)addr, 0, PAGE_SIZE);
+		pgtbl[pte] = V2P(addr) | PAGE_PRESENT | PAGE_RW | PAGE_USER;
+		invalidate_tlb_page(cr2);
+		return 0;
+	}
+
 	/* Copy On Write feature */
 	if(pg->count > 1) {
 		/* a page not marked as copy-on-write means it's read-only */
@@ -64,7 +155,7 @@ static int page_protection_violation(struct vma *vma, unsigned int cr2, struct s
 		pgtbl[pte] = V2P(addr) | PAGE_PRESENT | PAGE_RW | PAGE_USER;
 		kfree(P2V((page << PAGE_SHIFT)));
 		current->rss--;
-		invalidate_tlb();
+		invalidate_tlb_page(cr2);
 		return 0;
 	} else {
 		/* last page of Copy On Write procedure */
@@ -76,7 +167,7 @@ static int page_protection_violation(struct vma *vma, unsigned int cr2, struct s
 				return 0;
 			}
 			pgtbl[pte] = (page << PAGE_SHIFT) | PAGE_PRESENT | PAGE_RW | PAGE_USER;
-			invalidate_tlb();
+			invalidate_tlb_page(cr2);
 			return 0;
 		}
 	}
@@ -99,6 +190,7 @@ static int page_not_present(struct vma *vma, unsigned int cr2, struct sigcontext
 				/* assuming stack will never reach heap */
 				vma->start = cr2;
 				vma->start = vma->start & PAGE_MASK;
+				vma_tree_update(current, vma);
 			}
 		}
 	}
@@ -117,7 +209,7 @@ static int page_not_present(struct vma *vma, unsigned int cr2, struct sigcontext
 
 		if(!(vma->prot & PROT_WRITE) || vma->flags & MAP_SHARED) {
 			/* check if it's already in cache */
-			if((pg = search_page_hash(vma->inode, file_offset))) {
+			if((pg = get_cached_page(vma->inode, file_offset))) {
 				if(!map_page(current, cr2, (unsigned int)V2P(pg->data), vma->prot)) {
 					printk("%s(): Oops, map_page() returned 0!\n", __FUNCTION__);
 					return 1;
@@ -139,6 +231,9 @@ static int page_not_present(struct vma *vma, unsigned int cr2, struct sigcontext
 			}
 			current->usage.ru_majflt++;
 		}
+		if(!(vma->prot & PROT_WRITE) || vma->flags & MAP_SHARED) {
+			fault_around(vma, cr2);
+		}
 	} else {
 		current->usage.ru_minflt++;
 		addr = 0;
@@ -153,6 +248,14 @@ static int page_not_present(struct vma *vma, unsigned int cr2, struct sigcontext
 
 	if(vma->flags & ZERO_PAGE) {
 		if(!addr) {
+			/* reading doesn't need a page of its own */
+			if(!(sc->err & PFAULT_W) && get_zero_page()) {
+				if(!map_page(current, cr2, V2P(zero_page), PROT_READ)) {
+					printk("%s(): Oops, map_page() returned 0!\n", __FUNCTION__);
+					return 1;
+				}
+				return 0;
+			}
 			if(!(addr = map_page(current, cr2, 0, vma->prot))) {
 				printk("%s(): Oops, map_page() returned 0!\n", __FUNCTION__);
 				return 1;
@@ -8,6 +8,7 @@
 
 #include <fiwix/kernel.h>
 #include <fiwix/asm.h>
+#include <fiwix/cpu.h>
 #include <fiwix/multiboot1.h>
 #include <fiwix/kparms.h>
 #include <fiwix/mm.h>
@@ -46,6 +47,10 @@ unsigned int map_kaddr(unsigned int *page_dir, unsigned int from, unsigned int t
 	for(n = from; n < to; n += PAGE_SIZE) {
 		pde = GET_PGDIR(n);
 		pte = GET_PGTBL(n);
+		if(page_dir[pde] & PAGE_PSE) {
+			printk("WARNING: %s(): address 0x%08x is already mapped by a 4MB page.\n", __FUNCTION__, n);
+			return 0;
+		}
 		if(!(page_dir[pde] & ~PAGE_MASK)) {
 			if (!addr) {
 				paddr = kmalloc(PAGE_SIZE);
@@ -280,6 +285,7 @@ int unmap_page(unsigned int vaddr)
 	desc = pgtbl[pte];
 	addr = desc & PAGE_MASK;
 	pgtbl[pte] = 0;
+	invalidate_tlb_page(vaddr);
 	if (!(desc & PAGE_NOALLOC)) {
 		kfree(P2V(addr));
 	}
@@ -287,6 +293,32 @@ int unmap_page(unsigned int vaddr)
 	return 0;
 }
 
+/*
+ * The 'invlpg' instruction appeared with the i486, so the i386 has no other
+ * way than flushing the whole TLB.
+ */
+void invalidate_tlb_page(unsigned int addr)
+{
+	if(cpu_table.family < 4) {
+		invalidate_tlb();
+		return;
+	}
+	INVLPG(addr & PAGE_MASK);
+}
+
+void invalidate_tlb_range(unsigned int start, unsigned int end)
+{
+	unsigned int addr;
+
+	if(cpu_table.family < 4 || ((end - start) >> PAGE_SHIFT) > TLB_FLUSH_MAX_PAGES) {
+		invalidate_tlb();
+		return;
+	}
+	for(addr = start & PAGE_MASK; addr < end; addr += PAGE_SIZE) {
+		INVLPG(addr);
+	}
+}
+
 /*
  * This function initializes and setups the kernel page directory and page
  * tables. It also reserves areas of contiguous memory spaces for internal
@@ -294,10 +326,10 @@ int unmap_page(unsigned int vaddr)
  */
 void mem_init(void)
 {
-	unsigned int sizek;
+	unsigned int sizek, global, cr4, addr;
 	unsigned int physical_memory, physical_page_tables;
 	unsigned int *pgtbl;
-	int n, pages, last_ramdisk;
+	int n, pd, pages, last_ramdisk;
 
 	physical_page_tables = (kstat.physical_pages / 1024) + ((kstat.physical_pages % 1024) ? 1 : 0);
 	physical_memory = (kstat.physical_pages << PAGE_SHIFT);	/* in bytes */
@@ -310,19 +342,49 @@ void mem_init(void)
 	memset_b(kpage_dir, 0, PAGE_SIZE);
 	_last_data_addr += PAGE_SIZE;
 
-	/* Page Tables */
-	pgtbl = (unsigned int *)_last_data_addr;
-	memset_b(pgtbl, 0, physical_page_tables * PAGE_SIZE);
-	_last_data_addr += physical_page_tables * PAGE_SIZE;
+	/*
+	 * The kernel mappings are the same in every address space, so if the
+	 * CPU supports it they are marked global and the TLB keeps them when
+	 * CR3 is reloaded on every context switch.
+	 */
+	global = 0;
+	if(cpu_table.flags & CPU_PGE) {
+		global = PAGE_GLOBAL;
+	}
 
-	/* Page Directory and Page Tables initialization */
-	for(n = 0; n < kstat.physical_pages; n++) {
-		pgtbl[n] = (n << PAGE_SHIFT) | PAGE_PRESENT | PAGE_RW;
-		if(!(n % 1024)) {
-			kpage_dir[GET_PGDIR(PAGE_OFFSET) + (n / 1024)] = (unsigned int)&pgtbl[n] | PAGE_PRESENT | PAGE_RW;
+	/*
+	 * Page Directory and Page Tables initialization.
+	 *
+	 * If the CPU supports PSE, every 4MB of physical memory with no holes
+	 * in the BIOS memory map is mapped with a single 4MB page, which takes
+	 * only one TLB entry and needs no Page Table. The rest (i.e. the first
+	 * 4MB and the end of the memory) are mapped with 4KB pages.
+	 */
+	for(pd = 0; pd < physical_page_tables; pd++) {
+		addr = pd * PGDIR_SIZE;
+		if(cpu_table.flags & CPU_PSE) {
+			if((pd + 1) * 1024 <= kstat.physical_pages && is_range_in_bios_map(addr, addr + PGDIR_SIZE)) {
+				kpage_dir[GET_PGDIR(PAGE_OFFSET) + pd] = addr | PAGE_PSE | PAGE_PRESENT | PAGE_RW | global;
+				continue;
+			}
 		}
+		pgtbl = (unsigned int *)_last_data_addr;
+		memset_b(pgtbl, 0, PAGE_SIZE);
+		_last_data_addr += PAGE_SIZE;
+		for(n = 0; n < 1024 && (pd * 1024) + n < kstat.physical_pages; n++) {
+			pgtbl[n] = (addr + (n << PAGE_SHIFT)) | PAGE_PRESENT | PAGE_RW | global;
+		}
+		kpage_dir[GET_PGDIR(PAGE_OFFSET) + pd] = (unsigned int)pgtbl | PAGE_PRESENT | PAGE_RW;
+	}
+	if(cpu_table.flags & CPU_PSE) {
+		GET_CR4(cr4);
+		SET_CR4(cr4 | CR4_PSE);
 	}
 	activate_kpage_dir();
+	if(global) {
+		GET_CR4(cr4);
+		SET_CR4(cr4 | CR4_PGE);
+	}
 
 	/* since Page Directory is now activated we can use virtual addresses */
 	kpage_dir = (unsigned int *)P2V((unsigned int)kpage_dir);
@@ -460,6 +522,8 @@ void mem_init(void)
 
 	page_init(kstat.physical_pages);
 	buddy_low_init();
+	buddy_high_init();
+	kmem_cache_init();
 }
 
 void mem_stats(void)
@@ -12,6 +12,7 @@
 #include <fiwix/fcntl.h>
 #include <fiwix/stat.h>
 #include <fiwix/process.h>
+#include <fiwix/sleep.h>
 #include <fiwix/mman.h>
 #include <fiwix/errno.h>
 #include <fiwix/stdio.h>
@@ -122,6 +123,7 @@ static void insert_vma_region(struct vma *vma)
 	if(vma->inode) {
 		vma->inode->count++;
 	}
+	vma_tree_insert(current, vma);
 
 	if(vma != vma->prev && vma->start >= vma->prev->start && vma->start <= vma->prev->end) {
 		merge_vma_regions(vma->prev, vma);
@@ -139,6 +141,7 @@ static void add_vma_region(struct vma *vma)
 		if(vma->inode) {
 			vma->inode->count++;
 		}
+		vma_tree_insert(current, vma);
 	} else {
 		insert_vma_region(vma);
 	}
@@ -148,9 +151,10 @@ static void add_vma_region(struct vma *vma)
 static void del_vma_region(struct vma *vma)
 {
 	unsigned int flags;
-	struct vma *tmp;
+	struct vma *tmp, *next;
 
 	tmp = vma;
+	next = vma->next;
 
 	if(!vma->next && !vma->prev) {
 		printk("WARNING: %s(): trying to delete an unexistent vma region (%x).\n", __FUNCTION__, vma->start);
@@ -172,9 +176,13 @@ static void del_vma_region(struct vma *vma)
 	if(vma == current->vma_table) {
 		current->vma_table = vma->next;
 	}
+	vma_tree_remove(current, vma);
+	if(next) {
+		vma_tree_update(current, next);
+	}
 	RESTORE_FLAGS(flags);
 
-	kfree((unsigned int)tmp);
+	kmem_cache_free(vma_cache, (unsigned int)tmp);
 }
 
 static int can_be_merged(struct vma *a, struct vma *b)
@@ -199,7 +207,7 @@ static int free_vma_region(struct vma *vma, unsigned int start, __ssize_t length
 	struct vma *new;
 
 	if(start + length < vma->end) {
-		if(!(new = (struct vma *)kmalloc(sizeof(struct vma)))) {
+		if(!(new = (struct vma *)kmem_cache_alloc(vma_cache))) {
 			return -ENOMEM;
 		}
 		memset_b(new, 0, sizeof(struct vma));
@@ -222,6 +230,9 @@ static int free_vma_region(struct vma *vma, unsigned int start, __ssize_t length
 		del_vma_region(vma);
 	} else {
 		vma->end = start;
+		if(vma->next) {
+			vma_tree_update(current, vma->next);
+		}
 	}
 
 	if(new) {
@@ -245,7 +256,7 @@ void merge_vma_regions(struct vma *a, struct vma *b)
 	}
 
 	if((b->start < a->end)) {
-		if(!(new = (struct vma *)kmalloc(sizeof(struct vma)))) {
+		if(!(new = (struct vma *)kmem_cache_alloc(vma_cache))) {
 			return;
 		}
 		memset_b(new, 0, sizeof(struct vma));
@@ -258,13 +269,14 @@ void merge_vma_regions(struct vma *a, struct vma *b)
 		new->inode = a->inode;
 		new->o_mode = a->o_mode;
 		free_vma_pages(a, b->start, b->end - b->start);
-		invalidate_tlb();
+		invalidate_tlb_range(b->start, b->end);
 		a->end = b->start;
+		vma_tree_update(current, b);
 		if(a->start == a->end) {
 			del_vma_region(a);
 		}
 		if(new->start >= new->end) {
-			kfree((unsigned int)new);
+			kmem_cache_free(vma_cache, (unsigned int)new);
 		} else {
 			insert_vma_region(new);
 		}
@@ -293,6 +305,8 @@ void free_vma_pages(struct vma *vma, unsigned int start, __size_t length)
 					page = pgtbl[pte] >> PAGE_SHIFT;
 					pg = &page_table[page];
 					if(pg->flags & PAGE_RESERVED) {
+						/* i.e. the shared zero page */
+						pgtbl[pte] = 0;
 						continue;
 					}
 
@@ -343,42 +357,55 @@ void release_binary(void)
 	invalidate_tlb();
 }
 
-struct vma *find_vma_region(unsigned int addr)
+/*
+ * A child created with CLONE_VM runs in the address space of its parent.
+ * When the child calls execve() or exits, the address space is given back
+ * to the parent, which is woken up, and the child switches to 'pgdir'.
+ */
+void release_vfork(unsigned int *pgdir)
 {
-	struct vma *vma;
+	struct proc *p;
+
+	p = current->ppid;
+	p->vma_table = current->vma_table;
+	p->vma_root = current->vma_root;
+	p->vma_last = current->vma_last;
+	p->brk_lower = current->brk_lower;
+	p->brk = current->brk;
+	p->rss = current->rss - 1;	/* the kernel stack of the child */
+
+	current->vma_table = current->vma_root = current->vma_last = NULL;
+	current->rss = 1;
+	current->tss.cr3 = V2P((unsigned int)pgdir);
+	SET_CR3(current->tss.cr3);
+	current->flags &= ~PF_VFORK;
+	wake_up_all(&p->vfork_wait);
+}
+
+/*
+ * The parent of a vfork()ed child is being killed, so the child keeps the
+ * address space as its own and the parent switches to the kernel one.
+ */
+void detach_vfork(struct proc *child)
+{
+	child->flags &= ~PF_VFORK;
+	current->rss = 1;	/* the kernel stack */
+	current->tss.cr3 = V2P((unsigned int)kpage_dir);
+	SET_CR3(current->tss.cr3);
+}
 
+struct vma *find_vma_region(unsigned int addr)
+{
 	if(!addr) {
 		return NULL;
 	}
 
-	addr &= PAGE_MASK;
-	vma = current->vma_table;
-
-	while(vma) {
-		if((addr >= vma->start) && (addr < vma->end)) {
-			return vma;
-		}
-		vma = vma->next;
-	}
-	return NULL;
+	return vma_tree_find(current, addr & PAGE_MASK);
 }
 
 struct vma *find_vma_intersection(unsigned int start, unsigned int end)
 {
-	struct vma *vma;
-
-	vma = current->vma_table;
-
-	while(vma) {
-		if(end <= vma->start) {
-			break;
-		}
-		if(start < vma->end) {
-			return vma;
-		}
-		vma = vma->next;
-	}
-	return NULL;
+	return vma_tree_find_intersection(current, start, end);
 }
 
 int expand_heap(unsigned int new)
@@ -392,6 +419,7 @@ int expand_heap(unsigned int new)
 		/* make sure the new heap won't overlap the next region */
 		if(heap && new < vma->start) {
 			heap->end = new;
+			vma_tree_update(current, vma);
 			return 0;
 		} else {
 			heap = NULL;	/* was a bad candidate */
@@ -409,28 +437,11 @@ int expand_heap(unsigned int new)
 /* return the first free address that matches with the size of length */
 unsigned int get_unmapped_vma_region(unsigned int length)
 {
-	unsigned int addr;
-	struct vma *vma;
-
 	if(!length) {
 		return 0;
 	}
 
-	addr = MMAP_START;
-	vma = current->vma_table;
-
-	while(vma) {
-		if(vma->start < MMAP_START) {
-			vma = vma->next;
-			continue;
-		}
-		if(vma->start - addr >= length) {
-			return PAGE_ALIGN(addr);
-		}
-		addr = PAGE_ALIGN(vma->end);
-		vma = vma->next;
-	}
-	return 0;
+	return vma_tree_find_gap(current, length, MMAP_START);
 }
 
 int do_mmap(struct inode *i, unsigned int start, unsigned int length, unsigned int prot, unsigned int flags, unsigned int offset, char type, char mode, void *object)
@@ -502,7 +513,7 @@ int do_mmap(struct inode *i, unsigned int start, unsigned int length, unsigned i
 		}
 	}
 
-	if(!(vma = (struct vma *)kmalloc(sizeof(struct vma)))) {
+	if(!(vma = (struct vma *)kmem_cache_alloc(vma_cache))) {
                 return -ENOMEM;
         }
         memset_b(vma, 0, sizeof(struct vma));
@@ -523,7 +534,7 @@ int do_mmap(struct inode *i, unsigned int start, unsigned int length, unsigned i
 	if(i && i->fsop->mmap) {
 		if((errno = i->fsop->mmap(i, vma))) {
 			free_vma_region(vma, start, length);
-			kfree((unsigned int)vma);
+			kmem_cache_free(vma_cache, (unsigned int)vma);
 			return errno;
 		}
 	}
@@ -554,7 +565,7 @@ int do_munmap(unsigned int addr, __size_t length)
 		}
 
 		free_vma_pages(vma, addr, size);
-		invalidate_tlb();
+		invalidate_tlb_range(addr, addr + size);
 		free_vma_region(vma, addr, size);
 		length -= size;
 		addr += size;
@@ -566,7 +577,7 @@ int do_mprotect(struct vma *vma, unsigned int addr, __size_t length, int prot)
 {
 	struct vma *new;
 
-	if(!(new = (struct vma *)kmalloc(sizeof(struct vma)))) {
+	if(!(new = (struct vma *)kmem_cache_alloc(vma_cache))) {
                 return -ENOMEM;
         }
         memset_b(new, 0, sizeof(struct vma));
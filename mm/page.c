@@ -20,6 +20,10 @@
  * +--------+  +--------------+  +--------------+  +--------------+
  *              (page)            (page)            (page)  
  *    ...
+ *
+ * The blocks of a cached page are mapped onto it as buffers whose data lives
+ * inside the page, so the buffer cache and the page cache share one copy of
+ * the file contents. A free page is not reused until its buffers are idle.
  */
 
 #include <fiwix/asm.h>
@@ -40,6 +44,12 @@
 #define NR_PAGES	(page_table_size / sizeof(struct page))
 #define NR_PAGE_HASH	(page_hash_table_size / sizeof(unsigned int))
 
+/* a page is in the free list when nobody is using it */
+#define PAGE_IS_FREE(pg)	(!(pg)->count && !((pg)->flags & PAGE_RESERVED))
+
+/* a free page can be reused once the buffers mapped onto it are idle */
+#define PAGE_IS_IDLE(pg)	(!(pg)->buffers || !page_buffers_busy(pg))
+
 struct page *page_table;		/* page pool */
 struct page *page_head;			/* page pool head */
 struct page **page_hash_table;
@@ -157,7 +167,7 @@ void page_unlock(struct page *pg)
 struct page *get_free_page(void)
 {
 	unsigned int flags;
-	struct page *pg;
+	struct page *pg, *first;
 
 repeat:
 	/* if the number of pages is low then reclaim some buffers */
@@ -197,8 +207,22 @@ repeat:
 		return NULL;
 	}
 
+	/* skip the cached pages whose buffers are still in use */
+	first = pg;
+	while(!PAGE_IS_IDLE(pg)) {
+		if((pg = pg->next_free) == first) {
+			printk("WARNING: %s(): all free pages have buffers in use.\n", __FUNCTION__);
+			RESTORE_FLAGS(flags);
+			wakeup(&kbdflushd);
+			return NULL;
+		}
+	}
+
 	remove_from_free_list(pg);
 	remove_from_hash(pg);	/* remove it from its old hash */
+	if(pg->buffers) {
+		detach_page_buffers(pg);
+	}
 	pg->count = 1;
 	pg->inode = 0;
 	pg->offset = 0;
@@ -208,6 +232,130 @@ repeat:
 	return pg;
 }
 
+/* checks if the pages [page, page + nr) are all in the free list */
+static int is_free_block(int page, int nr, int cached)
+{
+	struct page *pg;
+
+	while(nr--) {
+		pg = &page_table[page + nr];
+		if(!PAGE_IS_FREE(pg) || !PAGE_IS_IDLE(pg)) {
+			return 0;
+		}
+		if(!cached && pg->inode) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/* takes the pages [page, page + nr) out of the free list if still free */
+static int claim_free_block(int page, int nr, int cached)
+{
+	unsigned int flags;
+	struct page *pg;
+	int n;
+
+	SAVE_FLAGS(flags); CLI();
+	if(!is_free_block(page, nr, cached)) {
+		RESTORE_FLAGS(flags);
+		return 0;
+	}
+	for(n = 0; n < nr; n++) {
+		pg = &page_table[page + n];
+		remove_from_free_list(pg);
+		remove_from_hash(pg);
+		if(pg->buffers) {
+			detach_page_buffers(pg);
+		}
+		pg->count = 1;
+		pg->inode = 0;
+		pg->offset = 0;
+		pg->dev = 0;
+	}
+	RESTORE_FLAGS(flags);
+	return 1;
+}
+
+/*
+ * Returns the first page of a block of (1 << order) physically contiguous
+ * free pages, aligned to its own size. The blocks without cached pages are
+ * tried first, so the page cache is kept as much as possible.
+ *
+ * The page table is scanned with the interrupts enabled, so a block found
+ * free is checked again when it's taken, and the scan goes on if it's not
+ * free anymore.
+ */
+struct page *get_free_pages(int order)
+{
+	int nr, page, cached_page;
+
+	nr = 1 << order;
+	if(kstat.free_pages - nr <= kstat.min_free_pages) {
+		wakeup(&kswapd);
+	}
+
+	for(;;) {
+		cached_page = -1;
+		for(page = 0; page + nr <= NR_PAGES; page += nr) {
+			if(!is_free_block(page, nr, 1)) {
+				continue;
+			}
+			if(!is_free_block(page, nr, 0)) {
+				/* keep the first one in case there is no other */
+				if(cached_page < 0) {
+					cached_page = page;
+				}
+				continue;
+			}
+			if(claim_free_block(page, nr, 0)) {
+				return &page_table[page];
+			}
+		}
+		if(cached_page < 0) {
+			break;
+		}
+		if(claim_free_block(cached_page, nr, 1)) {
+			return &page_table[cached_page];
+		}
+	}
+
+	printk("WARNING: %s(): no free block of %d contiguous pages.\n", __FUNCTION__, nr);
+	return NULL;
+}
+
+/*
+ * Counts the free blocks of each order (up to 'max_order') that result from
+ * splitting the free pages in the largest aligned blocks possible, which
+ * tells how fragmented the physical memory is.
+ */
+void get_free_areas(int *areas, int max_order)
+{
+	int page, order;
+
+	for(order = 0; order <= max_order; order++) {
+		areas[order] = 0;
+	}
+
+	page = 0;
+	while(page < NR_PAGES) {
+		if(!PAGE_IS_FREE(&page_table[page])) {
+			page++;
+			continue;
+		}
+		for(order = max_order; order > 0; order--) {
+			if(page & ((1 << order) - 1)) {
+				continue;
+			}
+			if(page + (1 << order) <= NR_PAGES && is_free_block(page, 1 << order, 1)) {
+				break;
+			}
+		}
+		areas[order]++;
+		page += 1 << order;
+	}
+}
+
 struct page *search_page_hash(struct inode *inode, __off_t offset)
 {
 	struct page *pg;
@@ -230,6 +378,25 @@ struct page *search_page_hash(struct inode *inode, __off_t offset)
 	return NULL;
 }
 
+/*
+ * Returns the page of 'offset' from the page cache, once the I/O in progress
+ * on its buffers (i.e. readahead) has finished. A page whose buffers couldn't
+ * be read is dropped from the cache, so the caller reads it again.
+ */
+struct page *get_cached_page(struct inode *i, __off_t offset)
+{
+	struct page *pg;
+
+	if((pg = search_page_hash(i, offset))) {
+		if(pg->buffers && wait_page_buffers(pg)) {
+			remove_from_hash(pg);
+			release_page(pg);
+			return NULL;
+		}
+	}
+	return pg;
+}
+
 void release_page(struct page *pg)
 {
 	unsigned int flags;
@@ -292,27 +459,6 @@ void invalidate_inode_pages(struct inode *i)
 	}
 }
 
-void update_page_cache(struct inode *i, __off_t offset, const char *buf, int count)
-{
-	__off_t poffset;
-	struct page *pg;
-	int bytes;
-
-	poffset = offset & (PAGE_SIZE - 1);	/* mod PAGE_SIZE */
-	offset &= PAGE_MASK;
-	bytes = PAGE_SIZE - poffset;
-
-	if(count) {
-		bytes = MIN(bytes, count);
-		if((pg = search_page_hash(i, offset))) {
-			page_lock(pg);
-			memcpy_b(pg->data + poffset, buf, bytes);
-			page_unlock(pg);
-			release_page(pg);
-		}
-	}
-}
-
 int write_page(struct page *pg, struct inode *i, __off_t offset, unsigned int length)
 {
 	struct fd fdt;
@@ -337,12 +483,12 @@ int bread_page(struct page *pg, struct inode *i, __off_t offset, char prot, char
 {
 	__blk_t block;
 	__off_t size_read;
-	int blksize, retval;
+	int blksize, retval, cached;
 	struct device *d;
 	struct blk_request brh, *br, *tmp;
 
 	blksize = i->sb->s_blocksize;
-	retval = size_read = 0;
+	retval = size_read = cached = 0;
 	tmp = NULL;
 
 	if(!(d = get_device(BLK_DEV, i->dev))) {
@@ -359,15 +505,17 @@ int bread_page(struct page *pg, struct inode *i, __off_t offset, char prot, char
 		pg->offset = offset;
 		pg->dev = i->dev;
 		insert_to_hash(pg);
+		cached = 1;
 	}
 
 	while(size_read < PAGE_SIZE) {
-		if(!(br = (struct blk_request *)kmalloc(sizeof(struct blk_request)))) {
+		if(!(br = (struct blk_request *)kmem_cache_alloc(blk_request_cache))) {
 			printk("WARNING: %s(): no more free memory for block requests.\n", __FUNCTION__);
 			retval = 1;
 			break;
 		}
 		if((block = bmap(i, offset + size_read, FOR_READING)) < 0) {
+			kmem_cache_free(blk_request_cache, (unsigned int)br);
 			retval = 1;
 			break;
 		}
@@ -385,23 +533,33 @@ int bread_page(struct page *pg, struct inode *i, __off_t offset, char prot, char
 			tmp->next_group = br;
 		}
 		tmp = br;
+		if(cached && block) {
+			/* the block is read straight into the page */
+			if(!(br->buffer = getblk_page(pg, pg->data + size_read, i->dev, block, blksize))) {
+				retval = 1;
+				break;
+			}
+		}
 		size_read += blksize;
 	}
 	if(!retval) {
 		retval = gbread(d, &brh);
+		/*
+		 * We must zero retval if is not negative because block drivers
+		 * that still don't use the new I/O mechanism will return the
+		 * bytes read, and this value could be interpreted below as an
+		 * error.
+		 */
+		retval = retval < 0 ? retval : 0;
 	}
-	/*
-	 * We must zero retval if is not negative because block drivers
-	 * that still don't use the new I/O mechanism will return the
-	 * bytes read, and this value could be interpreted below as an error.
-	 */
-	retval = retval < 0 ? retval : 0;
 	br = brh.next_group;
 	size_read = 0;
 	while(br) {
 		if(!retval) {
 			if(br->block) {
-				memcpy_b(pg->data + size_read, br->buffer->data, br->size);
+				if(br->buffer->page != pg) {
+					memcpy_b(pg->data + size_read, br->buffer->data, br->size);
+				}
 				br->buffer->flags |= BUFFER_VALID;
 			} else {
 				/* fill the hole with zeros */
@@ -409,18 +567,95 @@ int bread_page(struct page *pg, struct inode *i, __off_t offset, char prot, char
 			}
 			size_read += br->size;
 		}
-		if(br->block) {
+		if(br->buffer) {
 			brelse(br->buffer);
 		}
 		tmp = br->next_group;
-		kfree((unsigned int)br);
+		kmem_cache_free(blk_request_cache, (unsigned int)br);
 		br = tmp;
 	}
 
+	/* don't leave a page with bogus contents in the cache */
+	if(retval && cached) {
+		remove_from_hash(pg);
+	}
 	page_unlock(pg);
 	return retval;
 }
 
+/*
+ * Starts reading asynchronously the pages that follow 'offset', up to the
+ * readahead window of the file descriptor, so they are already in the page
+ * cache (or on their way) when the sequential reader gets there. The blocks
+ * are read straight into the pages through the buffers mapped onto them.
+ * A new batch is not started until half of the previous one has been read.
+ */
+static void readahead(struct inode *i, struct fd *f, __off_t offset)
+{
+	struct device *d;
+	struct page *pg;
+	struct buffer *buf;
+	__off_t end;
+	__blk_t block;
+	int blksize, n;
+
+	if(f->ra_end - offset > (f->ra_pages / 2) * PAGE_SIZE) {
+		return;
+	}
+	end = offset + (f->ra_pages * PAGE_SIZE);
+	end = MIN(end, i->i_size);
+	offset = MAX(offset, f->ra_end);
+	if(offset >= end) {
+		return;
+	}
+	if(!(d = get_device(BLK_DEV, i->dev)) || !d->fsop->read_block) {
+		return;
+	}
+
+	blksize = i->sb->s_blocksize;
+	for(; offset < end; offset += PAGE_SIZE) {
+		if((pg = search_page_hash(i, offset))) {
+			release_page(pg);
+			continue;
+		}
+		/* readahead must not put pressure on memory */
+		if(kstat.free_pages <= kstat.min_free_pages) {
+			break;
+		}
+		if(!(pg = get_free_page())) {
+			break;
+		}
+		page_lock(pg);
+		pg->inode = i->inode;
+		pg->offset = offset;
+		pg->dev = i->dev;
+		insert_to_hash(pg);
+		for(n = 0; n < PAGE_SIZE; n += blksize) {
+			if((block = bmap(i, offset + n, FOR_READING)) < 0) {
+				break;
+			}
+			if(!block) {
+				memset_b(pg->data + n, 0, blksize);
+				continue;
+			}
+			if(!(buf = getblk_page(pg, pg->data + n, i->dev, block, blksize))) {
+				break;
+			}
+			if(buf->flags & BUFFER_VALID || add_async_blk_request(d, d->fsop->read_block, buf)) {
+				brelse(buf);
+			}
+		}
+		if(n < PAGE_SIZE) {
+			remove_from_hash(pg);
+		}
+		page_unlock(pg);
+		release_page(pg);
+		kstat.ra_pages++;
+	}
+	f->ra_end = offset;
+	run_blk_request(d);
+}
+
 int file_read(struct inode *i, struct fd *f, char *buffer, __size_t count)
 {
 	__size_t total_read;
@@ -433,6 +668,18 @@ int file_read(struct inode *i, struct fd *f, char *buffer, __size_t count)
 		f->offset = i->i_size;
 	}
 
+	/* a sequential reader gets a growing readahead window */
+	if(f->offset == f->ra_offset && kstat.max_readahead) {
+		if(f->ra_pages) {
+			f->ra_pages = MIN(f->ra_pages * 2, kstat.max_readahead);
+		} else {
+			f->ra_pages = MIN(READAHEAD_MIN_PAGES, kstat.max_readahead);
+		}
+	} else {
+		f->ra_pages = 0;
+		f->ra_end = 0;
+	}
+
 	total_read = 0;
 
 	for(;;) {
@@ -442,7 +689,10 @@ int file_read(struct inode *i, struct fd *f, char *buffer, __size_t count)
 		}
 
 		poffset = f->offset & (PAGE_SIZE - 1);	/* mod PAGE_SIZE */
-		if(!(pg = search_page_hash(i, f->offset & PAGE_MASK))) {
+		if(!(pg = get_cached_page(i, f->offset & PAGE_MASK))) {
+			if(f->ra_pages && !poffset) {
+				kstat.ra_misses++;
+			}
 			if(!(addr = kmalloc(PAGE_SIZE))) {
 				inode_unlock(i);
 				printk("%s(): returning -ENOMEM\n", __FUNCTION__);
@@ -456,8 +706,14 @@ int file_read(struct inode *i, struct fd *f, char *buffer, __size_t count)
 				return -EIO;
 			}
 		} else {
+			if(f->ra_pages && !poffset && (f->offset & PAGE_MASK) < f->ra_end) {
+				kstat.ra_hits++;
+			}
 			addr = (unsigned int)pg->data;
 		}
+		if(f->ra_pages) {
+			readahead(i, f, (f->offset & PAGE_MASK) + PAGE_SIZE);
+		}
 
 		page_lock(pg);
 		bytes = PAGE_SIZE - poffset;
@@ -470,10 +726,125 @@ int file_read(struct inode *i, struct fd *f, char *buffer, __size_t count)
 		page_unlock(pg);
 	}
 
+	f->ra_offset = f->offset;
 	inode_unlock(i);
 	return total_read;
 }
 
+/*
+ * Writes the bytes [from, to) of the page of 'offset' in the page cache. The
+ * blocks are mapped onto the page and only marked as dirty, so they reach the
+ * disk later from the writeback in kbdflushd(). The blocks that are fully
+ * overwritten, or beyond the end of the file, are never read from the disk,
+ * and neither are the blocks of a page that was already in the cache.
+ */
+static int write_cached_page(struct inode *i, __off_t offset, unsigned int from, unsigned int to, const char *data)
+{
+	struct device *d;
+	struct page *pg;
+	struct buffer *buf;
+	__blk_t block;
+	unsigned int start, end;
+	int blksize, n, cached, written, errno;
+
+	if(!(d = get_device(BLK_DEV, i->dev))) {
+		printk("WARNING: %s(): device major %d not found!\n", __FUNCTION__, MAJOR(i->dev));
+		return -ENXIO;
+	}
+
+	cached = 1;
+	if(!(pg = get_cached_page(i, offset))) {
+		if(!(pg = get_free_page())) {
+			return -ENOMEM;
+		}
+		pg->inode = i->inode;
+		pg->offset = offset;
+		pg->dev = i->dev;
+		cached = 0;
+	}
+	page_lock(pg);
+	if(!cached) {
+		insert_to_hash(pg);
+	}
+
+	blksize = i->sb->s_blocksize;
+	errno = 0;
+	for(n = 0; n < PAGE_SIZE; n += blksize) {
+		written = n + blksize > from && n < to;
+		if(!written) {
+			if(cached) {
+				continue;
+			}
+			block = 0;
+			if(offset + n < i->i_size) {
+				block = bmap(i, offset + n, FOR_READING);
+			}
+			if(!block) {
+				memset_b(pg->data + n, 0, blksize);
+				continue;
+			}
+		} else {
+			block = bmap(i, offset + n, FOR_WRITING);
+		}
+		if(block < 0) {
+			errno = block;
+			break;
+		}
+		if(!(buf = getblk_page(pg, pg->data + n, i->dev, block, blksize))) {
+			errno = -ENOMEM;
+			break;
+		}
+		if(!(buf->flags & BUFFER_VALID) && !cached) {
+			if(offset + n >= i->i_size) {
+				memset_b(pg->data + n, 0, blksize);
+			} else if(!written || n < from || n + blksize > to) {
+				if(do_blk_request(d, d->fsop->read_block, buf) < 0) {
+					brelse(buf);
+					errno = -EIO;
+					break;
+				}
+			}
+		}
+		buf->flags |= BUFFER_VALID;
+		if(!written) {
+			brelse(buf);
+			continue;
+		}
+		start = MAX(n, from);
+		end = MIN(n + blksize, to);
+		memcpy_b(pg->data + start, data + (start - from), end - start);
+		bwrite(buf);
+	}
+
+	/* don't leave a page with bogus contents in the cache */
+	if(errno && !cached) {
+		remove_from_hash(pg);
+	}
+	page_unlock(pg);
+	release_page(pg);
+	return errno;
+}
+
+int file_write(struct inode *i, struct fd *f, const char *buffer, __size_t count)
+{
+	__size_t total_written;
+	unsigned int poffset, bytes;
+	int errno;
+
+	total_written = 0;
+	while(total_written < count) {
+		poffset = f->offset & (PAGE_SIZE - 1);	/* mod PAGE_SIZE */
+		bytes = PAGE_SIZE - poffset;
+		bytes = MIN(bytes, count - total_written);
+		if((errno = write_cached_page(i, f->offset & PAGE_MASK, poffset, poffset + bytes, buffer + total_written))) {
+			return total_written ? total_written : errno;
+		}
+		total_written += bytes;
+		f->offset += bytes;
+	}
+	return total_written;
+}
+
 void reserve_pages(unsigned int from, unsigned int to)
 {
 	struct page *pg;
@@ -536,4 +907,5 @@ void page_init(int pages)
 
 	kstat.total_mem_pages = kstat.free_pages;
 	kstat.min_free_pages = (kstat.total_mem_pages * FREE_PAGES_RATIO) / 100;
+	kstat.max_readahead = READAHEAD_MAX_PAGES;
 }
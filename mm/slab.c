@@ -0,0 +1,244 @@
+/*
+ * fiwix/mm/slab.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+/*
+ * This slab allocator keeps a cache of objects of the same type and size, so
+ * that the hot kernel structures don't pay the power of two rounding of the
+ * buddy_low allocator.
+ *
+ * Each slab is a page taken from get_free_page() which starts with a slab
+ * header, followed by an array of indexes that link the free objects, and
+ * then the objects themselves. The unused space at the end of the page is
+ * used to shift the first object of each new slab by a different multiple of
+ * SLAB_COLOR_ALIGN (cache coloring), so the objects of different slabs don't
+ * compete for the same cache lines.
+ *
+ * +--------+----------------+-------+-----+-----+-----+-----+----------+
+ * | header | free index [n] | color | obj | obj | ... | obj |  unused  |
+ * +--------+----------------+-------+-----+-----+-----+-----+----------+
+ */
+
+#include <fiwix/asm.h>
+#include <fiwix/kernel.h>
+#include <fiwix/mm.h>
+#include <fiwix/stdio.h>
+#include <fiwix/string.h>
+
+#define SLAB_FREE_END	0xFFFF		/* no more free objects */
+#define SLAB_INDEX(s)	((unsigned short int *)((struct slab *)(s) + 1))
+
+struct kmem_cache *kmem_cache_head;
+
+/* the cache of cache descriptors */
+static struct kmem_cache cache_cache;
+
+static void add_slab(struct slab **h, struct slab *s)
+{
+	s->prev = NULL;
+	s->next = *h;
+	if(*h) {
+		(*h)->prev = s;
+	}
+	*h = s;
+}
+
+static void del_slab(struct slab **h, struct slab *s)
+{
+	if(s->next) {
+		s->next->prev = s->prev;
+	}
+	if(s->prev) {
+		s->prev->next = s->next;
+	}
+	if(s == *h) {
+		*h = s->next;
+	}
+	s->prev = s->next = NULL;
+}
+
+static struct slab *grow_cache(struct kmem_cache *c)
+{
+	struct page *pg;
+	struct slab *s;
+	unsigned short int *index;
+	unsigned int addr;
+	int n;
+
+	if(!(pg = get_free_page())) {
+		return NULL;
+	}
+	addr = pg->page << PAGE_SHIFT;
+	s = (struct slab *)P2V(addr);
+	s->cache = c;
+	s->prev = s->next = NULL;
+	s->inuse = 0;
+	s->free = 0;
+
+	/* pick the color of this slab */
+	s->objs = (unsigned int)s + c->offset + (c->color_next * SLAB_COLOR_ALIGN);
+	if(++c->color_next >= c->colors) {
+		c->color_next = 0;
+	}
+
+	index = SLAB_INDEX(s);
+	for(n = 0, addr = s->objs; n < c->objs_per_slab; n++, addr += c->objsize) {
+		index[n] = n + 1;
+		if(c->ctor) {
+			c->ctor((void *)addr);
+		}
+	}
+	index[c->objs_per_slab - 1] = SLAB_FREE_END;
+	c->nr_slabs++;
+	return s;
+}
+
+static void release_slab(struct kmem_cache *c, struct slab *s)
+{
+	c->nr_slabs--;
+	release_page(&page_table[V2P((unsigned int)s) >> PAGE_SHIFT]);
+}
+
+/* set up the cache and the layout of its slabs */
+static int setup_cache(struct kmem_cache *c, const char *name, int size, void (*ctor)(void *))
+{
+	int left;
+
+	memset_b(c, 0, sizeof(struct kmem_cache));
+	c->name = name;
+	c->size = size;
+	c->objsize = (size + (sizeof(unsigned int) - 1)) & ~(sizeof(unsigned int) - 1);
+	c->ctor = ctor;
+
+	/* each object takes its size plus its free index */
+	left = PAGE_SIZE - sizeof(struct slab);
+	if((c->objs_per_slab = left / (c->objsize + sizeof(unsigned short int))) < 1) {
+		return 1;
+	}
+	c->offset = sizeof(struct slab) + (c->objs_per_slab * sizeof(unsigned short int));
+	c->offset = (c->offset + (sizeof(unsigned int) - 1)) & ~(sizeof(unsigned int) - 1);
+	if(c->offset + (c->objs_per_slab * c->objsize) > PAGE_SIZE) {
+		c->objs_per_slab--;
+	}
+	left = PAGE_SIZE - c->offset - (c->objs_per_slab * c->objsize);
+	c->colors = (left / SLAB_COLOR_ALIGN) + 1;
+
+	c->next = kmem_cache_head;
+	kmem_cache_head = c;
+	return 0;
+}
+
+struct kmem_cache *kmem_cache_create(const char *name, int size, void (*ctor)(void *))
+{
+	struct kmem_cache *c;
+
+	if(!(c = (struct kmem_cache *)kmem_cache_alloc(&cache_cache))) {
+		return NULL;
+	}
+	if(setup_cache(c, name, size, ctor)) {
+		printk("WARNING: %s(): object size (%d) too big for cache '%s'.\n", __FUNCTION__, size, name);
+		kmem_cache_free(&cache_cache, (unsigned int)c);
+		return NULL;
+	}
+	return c;
+}
+
+unsigned int kmem_cache_alloc(struct kmem_cache *c)
+{
+	unsigned int flags;
+	struct slab *s;
+	unsigned int addr;
+
+	SAVE_FLAGS(flags); CLI();
+	if(!(s = c->slabs_partial)) {
+		if((s = c->slabs_free)) {
+			del_slab(&c->slabs_free, s);
+		} else {
+			RESTORE_FLAGS(flags);
+			if(!(s = grow_cache(c))) {
+				printk("WARNING: %s(): not enough memory for cache '%s'.\n", __FUNCTION__, c->name);
+				return 0;
+			}
+			SAVE_FLAGS(flags); CLI();
+		}
+		add_slab(&c->slabs_partial, s);
+	}
+
+	addr = s->objs + (s->free * c->objsize);
+	s->free = SLAB_INDEX(s)[s->free];
+	s->inuse++;
+	if(s->free == SLAB_FREE_END) {
+		del_slab(&c->slabs_partial, s);
+		add_slab(&c->slabs_full, s);
+	}
+	c->nr_active++;
+	c->nr_allocs++;
+	RESTORE_FLAGS(flags);
+	return addr;
+}
+
+void kmem_cache_free(struct kmem_cache *c, unsigned int addr)
+{
+	unsigned int flags;
+	struct slab *s;
+	int n;
+
+	s = (struct slab *)(addr & PAGE_MASK);
+	if(s->cache != c) {
+		printk("WARNING: %s(): object 0x%x doesn't belong to cache '%s'!\n", __FUNCTION__, addr, c->name);
+		return;
+	}
+	n = (addr - s->objs) / c->objsize;
+
+	SAVE_FLAGS(flags); CLI();
+	if(s->free == SLAB_FREE_END) {
+		del_slab(&c->slabs_full, s);
+		add_slab(&c->slabs_partial, s);
+	}
+	SLAB_INDEX(s)[n] = s->free;
+	s->free = n;
+	s->inuse--;
+	c->nr_active--;
+	c->nr_frees++;
+
+	/* only one empty slab is kept in the cache */
+	if(!s->inuse) {
+		del_slab(&c->slabs_partial, s);
+		if(c->slabs_free) {
+			release_slab(c, s);
+		} else {
+			add_slab(&c->slabs_free, s);
+		}
+	}
+	RESTORE_FLAGS(flags);
+}
+
+/* release the empty slabs of all caches */
+int kmem_cache_reap(void)
+{
+	unsigned int flags;
+	struct kmem_cache *c;
+	struct slab *s;
+	int reaped;
+
+	reaped = 0;
+	SAVE_FLAGS(flags); CLI();
+	for(c = kmem_cache_head; c; c = c->next) {
+		while((s = c->slabs_free)) {
+			del_slab(&c->slabs_free, s);
+			release_slab(c, s);
+			reaped++;
+		}
+	}
+	RESTORE_FLAGS(flags);
+	return reaped;
+}
+
+void kmem_cache_init(void)
+{
+	kmem_cache_head = NULL;
+	setup_cache(&cache_cache, "kmem_cache", sizeof(struct kmem_cache), NULL);
+}
@@ -64,7 +64,10 @@ int kswapd(void)
 
 	for(;;) {
 		sleep(&kswapd, PROC_INTERRUPTIBLE);
-		if((kstat.pages_reclaimed = reclaim_buffers())) {
+		kstat.pages_reclaimed = reclaim_buffers();
+		kstat.pages_reclaimed += kmem_cache_reap();
+		kstat.pages_reclaimed += bh_reap();
+		if(kstat.pages_reclaimed) {
 			continue;
 		}
 		wakeup(&get_free_page);
@@ -0,0 +1,302 @@
+/*
+ * fiwix/mm/vma.c
+ *
+ * Copyright 2025, Jordi Sanfeliu. All rights reserved.
+ * Distributed under the terms of the Fiwix License.
+ */
+
+/*
+ * vma.c implements an index of the vma regions of a process, so finding the
+ * region of an address doesn't need to walk the whole vma_table.
+ *
+ * The regions are kept in an AVL tree sorted by their start address, which
+ * mirrors the order of the vma_table list (the list is still used by those
+ * who need to walk all the regions). Each node also keeps the free gap that
+ * precedes its region and the biggest gap in its subtree, so the search of
+ * an unmapped area can skip the subtrees with no room enough.
+ *
+ * The last region found is cached per process, as most of the lookups hit
+ * the same region repeatedly (i.e. the page faults of a sequential access or
+ * the checks of the user pointers of a syscall).
+ */
+
+#include <fiwix/kernel.h>
+#include <fiwix/mm.h>
+#include <fiwix/process.h>
+#include <fiwix/mman.h>
+#include <fiwix/string.h>
+
+#define VMA_HEIGHT(n)	((n) ? (n)->height : 0)
+#define VMA_MAX_GAP(n)	((n) ? (n)->max_gap : 0)
+
+/* returns the free space between 'vma' and the previous region */
+static unsigned int vma_gap(struct proc *p, struct vma *vma)
+{
+	unsigned int end;
+
+	end = (vma == p->vma_table) ? 0 : vma->prev->end;
+	return vma->start > end ? vma->start - end : 0;
+}
+
+static void update_node(struct vma *n)
+{
+	n->height = MAX(VMA_HEIGHT(n->left), VMA_HEIGHT(n->right)) + 1;
+	n->max_gap = MAX(n->gap, MAX(VMA_MAX_GAP(n->left), VMA_MAX_GAP(n->right)));
+}
+
+/* makes the parent of 'old' to point to 'new' */
+static void replace_child(struct proc *p, struct vma *old, struct vma *new)
+{
+	if(!old->parent) {
+		p->vma_root = new;
+	} else if(old->parent->left == old) {
+		old->parent->left = new;
+	} else {
+		old->parent->right = new;
+	}
+}
+
+static struct vma *rotate_left(struct proc *p, struct vma *x)
+{
+	struct vma *y;
+
+	y = x->right;
+	x->right = y->left;
+	if(y->left) {
+		y->left->parent = x;
+	}
+	replace_child(p, x, y);
+	y->parent = x->parent;
+	y->left = x;
+	x->parent = y;
+	update_node(x);
+	update_node(y);
+	return y;
+}
+
+static struct vma *rotate_right(struct proc *p, struct vma *x)
+{
+	struct vma *y;
+
+	y = x->left;
+	x->left = y->right;
+	if(y->right) {
+		y->right->parent = x;
+	}
+	replace_child(p, x, y);
+	y->parent = x->parent;
+	y->right = x;
+	x->parent = y;
+	update_node(x);
+	update_node(y);
+	return y;
+}
+
+/* returns the new root of the subtree of 'n' once balanced */
+static struct vma *rebalance(struct proc *p, struct vma *n)
+{
+	int balance;
+
+	update_node(n);
+	balance = VMA_HEIGHT(n->left) - VMA_HEIGHT(n->right);
+	if(balance > 1) {
+		if(VMA_HEIGHT(n->left->left) < VMA_HEIGHT(n->left->right)) {
+			rotate_left(p, n->left);
+		}
+		n = rotate_right(p, n);
+	} else if(balance < -1) {
+		if(VMA_HEIGHT(n->right->right) < VMA_HEIGHT(n->right->left)) {
+			rotate_right(p, n->right);
+		}
+		n = rotate_left(p, n);
+	}
+	return n;
+}
+
+/* rebalances and updates the gaps from 'n' up to the root */
+static void rebalance_path(struct proc *p, struct vma *n)
+{
+	while(n) {
+		n = rebalance(p, n);
+		n = n->parent;
+	}
+}
+
+/* recomputes the gap of 'vma' after its start or the previous end changed */
+void vma_tree_update(struct proc *p, struct vma *vma)
+{
+	vma->gap = vma_gap(p, vma);
+	for(; vma; vma = vma->parent) {
+		update_node(vma);
+	}
+}
+
+/*
+ * Inserts a region already linked in the vma_table. The regions with the
+ * same start address are placed after the existing ones, as in the list.
+ */
+void vma_tree_insert(struct proc *p, struct vma *vma)
+{
+	struct vma *n, *parent;
+
+	vma->left = vma->right = NULL;
+	vma->height = 1;
+	vma->gap = vma->max_gap = vma_gap(p, vma);
+
+	parent = NULL;
+	n = p->vma_root;
+	while(n) {
+		parent = n;
+		n = vma->start < n->start ? n->left : n->right;
+	}
+	vma->parent = parent;
+	if(!parent) {
+		p->vma_root = vma;
+	} else if(vma->start < parent->start) {
+		parent->left = vma;
+	} else {
+		parent->right = vma;
+	}
+	rebalance_path(p, parent);
+
+	/* the gap of the next region is now smaller */
+	if(vma->next) {
+		vma_tree_update(p, vma->next);
+	}
+}
+
+/*
+ * Removes a region from the tree. The caller must update the gap of the
+ * next region once it has been unlinked from the vma_table.
+ */
+void vma_tree_remove(struct proc *p, struct vma *vma)
+{
+	struct vma *child, *s, *start;
+
+	if(p->vma_last == vma) {
+		p->vma_last = NULL;
+	}
+
+	if(!vma->left || !vma->right) {
+		child = vma->left ? vma->left : vma->right;
+		replace_child(p, vma, child);
+		if(child) {
+			child->parent = vma->parent;
+		}
+		start = vma->parent;
+	} else {
+		/* the successor takes the place of the region */
+		s = vma->right;
+		while(s->left) {
+			s = s->left;
+		}
+		if(s->parent != vma) {
+			start = s->parent;
+			replace_child(p, s, s->right);
+			if(s->right) {
+				s->right->parent = s->parent;
+			}
+			s->right = vma->right;
+			s->right->parent = s;
+		} else {
+			start = s;
+		}
+		s->left = vma->left;
+		s->left->parent = s;
+		replace_child(p, vma, s);
+		s->parent = vma->parent;
+	}
+	vma->parent = vma->left = vma->right = NULL;
+	rebalance_path(p, start);
+}
+
+/* builds the tree of a process from its vma_table (i.e. after fork) */
+void vma_tree_build(struct proc *p)
+{
+	struct vma *vma;
+
+	p->vma_root = p->vma_last = NULL;
+	for(vma = p->vma_table; vma; vma = vma->next) {
+		vma_tree_insert(p, vma);
+	}
+}
+
+struct vma *vma_tree_find(struct proc *p, unsigned int addr)
+{
+	struct vma *vma;
+
+	vma = p->vma_last;
+	if(vma && addr >= vma->start && addr < vma->end) {
+		return vma;
+	}
+
+	vma = p->vma_root;
+	while(vma) {
+		if(addr < vma->start) {
+			vma = vma->left;
+		} else if(addr >= vma->end) {
+			vma = vma->right;
+		} else {
+			p->vma_last = vma;
+			return vma;
+		}
+	}
+	return NULL;
+}
+
+/* returns the first region that overlaps the range 'start' - 'end' */
+struct vma *vma_tree_find_intersection(struct proc *p, unsigned int start, unsigned int end)
+{
+	struct vma *vma, *first;
+
+	first = NULL;
+	vma = p->vma_root;
+	while(vma) {
+		if(vma->end > start) {
+			first = vma;
+			vma = vma->left;
+		} else {
+			vma = vma->right;
+		}
+	}
+	if(first && first->start < end) {
+		return first;
+	}
+	return NULL;
+}
+
+/* returns the lowest region above 'floor' preceded by 'length' free bytes */
+static struct vma *find_gap(struct proc *p, struct vma *n, unsigned int length, unsigned int floor)
+{
+	struct vma *vma;
+	unsigned int end;
+
+	if(!n || n->max_gap < length) {
+		return NULL;
+	}
+	if(n->start >= floor) {
+		if((vma = find_gap(p, n->left, length, floor))) {
+			return vma;
+		}
+		end = (n == p->vma_table) ? 0 : PAGE_ALIGN(n->prev->end);
+		end = MAX(end, floor);
+		if(n->start > end && n->start - end >= length) {
+			return n;
+		}
+	}
+	return find_gap(p, n->right, length, floor);
+}
+
+/* returns the first free address above 'floor' with 'length' bytes free */
+unsigned int vma_tree_find_gap(struct proc *p, unsigned int length, unsigned int floor)
+{
+	struct vma *vma;
+
+	if(!(vma = find_gap(p, p->vma_root, length, floor))) {
+		return 0;
+	}
+	if(vma == p->vma_table) {
+		return floor;
+	}
+	return MAX(PAGE_ALIGN(vma->prev->end), floor);
+}
@@ -22,7 +22,7 @@
 #ifdef CONFIG_NET
 struct ipv4_info *ipv4_socket_head;
 
-static struct resource packet_resource = { 0, 0 };
+static struct resource packet_resource = { 0 };
 
 static void add_ipv4_socket(struct ipv4_info *ip4)
 {
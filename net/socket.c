@@ -13,6 +13,7 @@
 #include <fiwix/fcntl.h>
 #include <fiwix/net.h>
 #include <fiwix/socket.h>
+#include <fiwix/poll.h>
 #include <fiwix/sleep.h>
 #include <fiwix/sched.h>
 #include <fiwix/errno.h>
@@ -29,7 +30,7 @@ static int check_sd(int sd)
 	struct inode *i;
 
 	CHECK_UFD(sd);
-	i = fd_table[current->fd[sd]].inode;
+	i = fd_table[current->files->fd[sd]].inode;
 	if(!i || !S_ISSOCK(i->i_mode)) {
 		return -ENOTSOCK;
 	}
@@ -41,7 +42,7 @@ static struct socket *get_socket(int fd)
 {
 	struct inode *i;
 
-	i = fd_table[current->fd[fd]].inode;
+	i = fd_table[current->files->fd[fd]].inode;
 	return &i->u.sockfs.sock;
 }
 
@@ -85,6 +86,7 @@ int insert_socket_to_queue(struct socket *ss, struct socket *sc)
 	RESTORE_FLAGS(flags);
 
 	ss->queue_len++;
+	select_notify(ss);
 	return 0;
 }
 
@@ -111,7 +113,7 @@ int sock_alloc(struct socket **s)
 		iput(i);
 		return -EMFILE;
 	}
-	current->fd[ufd] = fd;
+	current->files->fd[ufd] = fd;
 	i = fd_table[fd].inode;
 	ns = &i->u.sockfs.sock;
 	ns->state = SS_UNCONNECTED;
@@ -131,8 +133,8 @@ void sock_free(struct socket *s)
 	/* pointer arithmetic */
 	fd = ((unsigned int)s->fd - (unsigned int)&fd_table[0]) / sizeof(struct fd);
 
-	for(n = 0; n < OPEN_MAX; n++) {
-		if(current->fd[n] == fd) {
+	for(n = 0; n < current->files->fd_max; n++) {
+		if(current->files->fd[n] == fd) {
 			ufd = n;
 			break;
 		}
@@ -149,7 +151,7 @@ void sock_free(struct socket *s)
 	if(s->ops) {
 		s->ops->free(s);
 	}
-	wakeup(s);
+	wake_up(&s->wait);
 }
 
 int socket(int domain, int type, int protocol)
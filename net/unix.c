@@ -8,6 +8,7 @@
 
 #include <fiwix/config.h>
 #include <fiwix/fs.h>
+#include <fiwix/poll.h>
 #include <fiwix/stat.h>
 #include <fiwix/errno.h>
 #include <fiwix/socket.h>
@@ -24,7 +25,7 @@
 #ifdef CONFIG_NET
 struct unix_info *unix_socket_head;
 
-static struct resource packet_resource = { 0, 0 };
+static struct resource packet_resource = { 0 };
 
 static void add_unix_socket(struct unix_info *u)
 {
@@ -114,8 +115,8 @@ void unix_free(struct socket *s)
 		if(u->peer->socket) {
 			u->peer->socket->state = SS_DISCONNECTING;
 		}
-		wakeup(u->peer);
-		wakeup(&do_select);
+		wake_up(&u->peer->wait);
+		select_notify(u->peer);
 	}
 	remove_unix_socket(u);
 	return;
@@ -201,8 +202,8 @@ int unix_connect(struct socket *sc, const struct sockaddr *addr, int addrlen)
 	if((errno = insert_socket_to_queue(up->socket, sc))) {
 		return errno;
 	}
-	wakeup(up->socket);
-	sleep(sc, PROC_INTERRUPTIBLE);
+	wake_up(&up->socket->wait);
+	sleep_on(&sc->wait, PROC_INTERRUPTIBLE);
 	return 0;
 }
 
@@ -217,7 +218,7 @@ int unix_accept(struct socket *ss, struct sockaddr *addr, unsigned int *addrlen)
 		if(ss->fd->flags & O_NONBLOCK) {
 			return -EAGAIN;
 		}
-		if(sleep(ss, PROC_INTERRUPTIBLE)) {
+		if(sleep_on(&ss->wait, PROC_INTERRUPTIBLE)) {
 			return -EINTR;
 		}
 	}
@@ -250,8 +251,8 @@ int unix_accept(struct socket *ss, struct sockaddr *addr, unsigned int *addrlen)
 	uc->count++;
 	sc->state = SS_CONNECTED;
 	nss->state = SS_CONNECTED;
-	wakeup(sc);
-	wakeup(&do_select);
+	wake_up(&sc->wait);
+	select_notify(uc);
 	if(addr) {
 		nss->ops->getname(nss, addr, addrlen, SYS_GETPEERNAME);
 	}
@@ -369,7 +370,7 @@ int unix_sendto(struct socket *s, struct fd *f, const char *buffer, __size_t cou
 	lock_resource(&packet_resource);
 	append_packet_to_queue(p, &u->packet_queue);
 	unlock_resource(&packet_resource);
-	wakeup(u);
+	wake_up(&u->wait);
 	return count;
 }
 
@@ -386,7 +387,7 @@ int unix_recvfrom(struct socket *s, struct fd *f, char *buffer, __size_t count,
 	while(!(p = peek_packet(u->packet_queue))) {
 		unlock_resource(&packet_resource);
 		if(!(f->flags & O_NONBLOCK)) {
-			if(sleep(u, PROC_INTERRUPTIBLE)) {
+			if(sleep_on(&u->wait, PROC_INTERRUPTIBLE)) {
 				return -EINTR;
 			}
 			lock_resource(&packet_resource);
@@ -443,8 +444,8 @@ int unix_read(struct socket *s, struct fd *f, char *buffer, __size_t count)
 			if(u->writeoff == PIPE_BUF) {
 				u->writeoff = 0;
 			}
-			wakeup(u->peer);
-			wakeup(&do_select);
+			wake_up(&u->peer->wait);
+			select_notify(u);
 		} else {
 			if(s->state != SS_CONNECTED) {
 				if(s->state == SS_DISCONNECTING) {
@@ -464,7 +465,7 @@ int unix_read(struct socket *s, struct fd *f, char *buffer, __size_t count)
 			if(f->flags & O_NONBLOCK) {
 				return -EAGAIN;
 			}
-			if(sleep(u, PROC_INTERRUPTIBLE)) {
+			if(sleep_on(&u->wait, PROC_INTERRUPTIBLE)) {
 				return -EINTR;
 			}
 		}
@@ -513,14 +514,14 @@ int unix_write(struct socket *s, struct fd *f, const char *buffer, __size_t coun
 			if(up->readoff == PIPE_BUF) {
 				up->readoff = 0;
 			}
-			wakeup(u->peer);
-			wakeup(&do_select);
+			wake_up(&u->peer->wait);
+			select_notify(up);
 			continue;
 		}
-		wakeup(u->peer);
-		wakeup(&do_select);
+		wake_up(&u->peer->wait);
+		select_notify(up);
 		if(!(f->flags & O_NONBLOCK)) {
-			if(sleep(u, PROC_INTERRUPTIBLE)) {
+			if(sleep_on(&u->wait, PROC_INTERRUPTIBLE)) {
 				return -EINTR;
 			}
 		} else {
@@ -547,6 +548,7 @@ int unix_select(struct socket *s, int flag)
 	struct unix_info *u, *up;
 
 	if(s->flags & SO_ACCEPTCONN) {
+		select_wait(s);
 		if (flag == SEL_R && s->queue_len) {
 			return 1;
 		}
@@ -555,6 +557,10 @@ int unix_select(struct socket *s, int flag)
 
 	u = &s->u.unix_info;
 	up = s->u.unix_info.peer;
+	select_wait(u);
+	if(up) {
+		select_wait(up);
+	}
 
 	switch(flag) {
 		case SEL_R: